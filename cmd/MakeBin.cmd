@@ -34,6 +34,7 @@ if not exist %TMP_DIR% mkdir %TMP_DIR%
 
 xcopy %RELEASE_DIR%\data\* %TMP_DIR%\data\* /y /i /s
 xcopy %RELEASE_DIR%\AntiDupl*.exe %TMP_DIR%\* /y /i
+erase %TMP_DIR%\AntiDupl.Bench.exe /q
 xcopy %RELEASE_DIR%\AntiDupl*.dll %TMP_DIR%\* /y /i
 xcopy %RELEASE_DIR%\AntiDupl.NET.WinForms.runtimeconfig.json %TMP_DIR%\* /y /i
 
@@ -0,0 +1,577 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <windows.h>
+#include <gdiplus.h>
+#include <psapi.h>
+
+#include <stdio.h>
+#include <wctype.h>
+#include <limits.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "AntiDupl.h"
+#include "adCorpus.h"
+#include "adGolden.h"
+
+namespace ad
+{
+    const size_t RESULT_BATCH_SIZE = 16; // adResultW содержит полные пути и занимает больше 100 КБ
+    const DWORD MEMORY_SAMPLE_INTERVAL = 5;
+    const adUInt32 DECODE_BITMAP_SIZE = 256; // как INITIAL_REDUCED_IMAGE_SIZE при сборе данных
+
+    struct TBenchOptions
+    {
+        TCorpusOptions corpus;
+        std::wstring path; // каталог поиска вместо синтетического набора
+        std::vector<adAlgorithmComparing> comparers;
+        std::vector<int> threads;
+        std::vector<int> reducedSizes;
+        int threshold;
+        std::wstring kernels; // файл JSON замеров ядер, если задан, замер поиска не выполняется
+        double kernelTime; // секунды на одно ядро или формат
+        std::wstring decode; // каталог с файлами для замера декодирования, если задан, замер поиска не выполняется
+        std::wstring save; // файл эталонных результатов первой конфигурации
+        std::wstring verify; // файл эталона, с которым сравниваются результаты всех конфигураций
+        bool equivalence; // результаты конфигураций сравниваются с результатами первой
+        bool defects; // включаются проверки на дефекты, блочность и размытие
+        TTolerance tolerance;
+    };
+
+    struct TBenchResult
+    {
+        double time; // секунды
+        size_t imageNumber;
+        adUInt64 pairNumber;
+        size_t peakMemory; // байты
+        size_t truePairNumber;
+        size_t falsePairNumber;
+    };
+
+    static double Time()
+    {
+        LARGE_INTEGER counter, frequency;
+        ::QueryPerformanceCounter(&counter);
+        ::QueryPerformanceFrequency(&frequency);
+        return double(counter.QuadPart)/double(frequency.QuadPart);
+    }
+
+    // Рабочий набор процесса опрашивается из отдельного потока, так как PeakWorkingSetSize 
+    // не сбрасывается между прогонами.
+    class TMemorySampler
+    {
+    public:
+        TMemorySampler() : m_stop(false), m_peak(0), m_thread(&TMemorySampler::Work, this) {}
+
+        size_t Stop()
+        {
+            m_stop = true;
+            m_thread.join();
+            return m_peak;
+        }
+
+    private:
+        void Work()
+        {
+            PROCESS_MEMORY_COUNTERS counters;
+            do
+            {
+                if(::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+                    m_peak = std::max<size_t>(m_peak, counters.WorkingSetSize);
+                ::Sleep(MEMORY_SAMPLE_INTERVAL);
+            } while(!m_stop);
+        }
+
+        std::atomic<bool> m_stop;
+        size_t m_peak;
+        std::thread m_thread;
+    };
+
+    static const wchar_t * ComparerName(adAlgorithmComparing comparer)
+    {
+        return comparer == AD_COMPARING_SSIM ? L"ssim" : L"squared";
+    }
+
+    // Каждый прогон выполняется новым движком с пустым каталогом пользователя, 
+    // чтобы результаты не зависели от данных, накопленных предыдущими прогонами.
+    static adError Run(const TBenchOptions & options, const std::wstring & searchPath, const std::wstring & userPath, 
+        adAlgorithmComparing comparer, int threads, int reducedSize, TBenchResult & result, TGolden *pGolden)
+    {
+        ::CreateDirectoryW(userPath.c_str(), NULL);
+        adEngineHandle handle = adCreateW(userPath.c_str());
+        if(handle == NULL)
+            return AD_ERROR_UNKNOWN;
+
+        adCompareOptions compare;
+        adAdvancedOptions advanced;
+        adDefectOptions defect;
+        adOptionsGet(handle, AD_OPTIONS_COMPARE, &compare);
+        adOptionsGet(handle, AD_OPTIONS_ADVANCED, &advanced);
+        adOptionsGet(handle, AD_OPTIONS_DEFECT, &defect);
+        compare.algorithmComparing = comparer;
+        compare.thresholdDifference = options.threshold;
+        compare.transformedImage = TRUE;
+        compare.sizeControl = FALSE;
+        compare.typeControl = FALSE;
+        compare.ratioControl = FALSE;
+        advanced.compareThreadCount = threads;
+        advanced.collectThreadCount = threads;
+        advanced.reducedImageSize = reducedSize;
+        advanced.mistakeDataBase = FALSE;
+        advanced.resultCountMax = INT_MAX;
+        defect.checkOnDefect = options.defects ? TRUE : FALSE;
+        defect.checkOnBlockiness = options.defects ? TRUE : FALSE;
+        defect.checkOnBlurring = options.defects ? TRUE : FALSE;
+        adOptionsSet(handle, AD_OPTIONS_COMPARE, &compare);
+        adOptionsSet(handle, AD_OPTIONS_ADVANCED, &advanced);
+        adOptionsSet(handle, AD_OPTIONS_DEFECT, &defect);
+
+        adPathW path;
+        wcsncpy_s(path, searchPath.c_str(), _TRUNCATE);
+        adError error = adPathSetW(handle, AD_PATH_SEARCH, &path, 1);
+        if(error != AD_OK)
+        {
+            adRelease(handle);
+            return error;
+        }
+
+        TMemorySampler sampler;
+        double start = Time();
+        error = adSearch(handle);
+        result.time = Time() - start;
+        result.peakMemory = sampler.Stop();
+
+        adStatistic statistic;
+        adStatisticGet(handle, &statistic);
+        result.imageNumber = statistic.collectedImageNumber;
+        result.pairNumber = statistic.visitedCandidateNumber;
+
+        std::set<std::pair<std::wstring, std::wstring>> found;
+        std::vector<adResultW> results(RESULT_BATCH_SIZE);
+        result.falsePairNumber = 0;
+        for(adSize startFrom = 0; error == AD_OK; )
+        {
+            adSize size = results.size();
+            error = adResultGetW(handle, &startFrom, results.data(), &size);
+            if(error != AD_OK || size == 0)
+                break;
+            for(adSize i = 0; i < size; ++i)
+            {
+                const adResultW & r = results[i];
+                if(r.type != AD_RESULT_DUPL_IMAGE_PAIR)
+                    continue;
+                size_t group = TCorpus::Group(r.first.path);
+                if(group != (size_t)-1 && group == TCorpus::Group(r.second.path))
+                    found.insert(std::make_pair(std::min<std::wstring>(r.first.path, r.second.path), 
+                        std::max<std::wstring>(r.first.path, r.second.path)));
+                else
+                    result.falsePairNumber++;
+            }
+            startFrom += size;
+        }
+        result.truePairNumber = found.size();
+
+        if(pGolden && error == AD_OK)
+            error = pGolden->Import(handle, searchPath);
+
+        adRelease(handle);
+        return error;
+    }
+
+    static const char * KernelName(adKernelType kernel)
+    {
+        static const char * names[AD_KERNEL_SIZE] = { "TPixelData::FillFast", "TPixelData::Turn", "TPixelData::Mirror", 
+            "TImageComparer::IsDuplPair", "TImageComparer_SSIM::IsDuplPair", "TImageComparer_3D::GetIndex", "TDataCollector::GetBlockiness", 
+            "TPathFilter" };
+        return names[kernel];
+    }
+
+    // Порядок и формат полей фиксированы, чтобы файлы разных запусков можно было сравнивать построчно.
+    static int RunKernels(const TBenchOptions & options)
+    {
+        wchar_t temp[MAX_PATH];
+        ::GetTempPathW(MAX_PATH, temp);
+        std::wstring userPath = std::wstring(temp) + L"AntiDupl.Bench.kernels";
+        ::CreateDirectoryW(userPath.c_str(), NULL);
+        adEngineHandle handle = adCreateW(userPath.c_str());
+        if(handle == NULL)
+            return 1;
+
+        FILE *file = NULL;
+        if(_wfopen_s(&file, options.kernels.c_str(), L"w") != 0 || file == NULL)
+        {
+            wprintf(L"Can't create file %ls!\n", options.kernels.c_str());
+            adRelease(handle);
+            return 1;
+        }
+
+        int exitCode = 0;
+        adInt32 simd = 0;
+        bool first = true;
+        fprintf(file, "{\n  \"kernels\": [");
+        for(size_t r = 0; r < options.reducedSizes.size(); ++r)
+        {
+            adAdvancedOptions advanced;
+            adOptionsGet(handle, AD_OPTIONS_ADVANCED, &advanced);
+            advanced.reducedImageSize = options.reducedSizes[r];
+            adOptionsSet(handle, AD_OPTIONS_ADVANCED, &advanced);
+            adOptionsGet(handle, AD_OPTIONS_ADVANCED, &advanced);
+
+            for(int k = AD_KERNEL_FILL_FAST; k < AD_KERNEL_SIZE; ++k)
+            {
+                adKernelBenchmark benchmark;
+                adError error = adBenchmarkKernel(handle, (adKernelType)k, options.kernelTime, &benchmark);
+                if(error != AD_OK)
+                {
+                    wprintf(L"Kernel %hs (reduced %d): error %d\n", KernelName((adKernelType)k), advanced.reducedImageSize, error);
+                    exitCode = 1;
+                    continue;
+                }
+                simd = benchmark.simd;
+                fprintf(file, "%s\n    {\"kernel\": \"%s\", \"reducedImageSize\": %u, \"count\": %llu, "
+                    "\"totalMs\": %.3f, \"averageNs\": %.1f, \"minNs\": %.1f}", first ? "" : ",", 
+                    KernelName((adKernelType)k), (unsigned int)benchmark.reducedImageSize, (unsigned long long)benchmark.count, 
+                    benchmark.total, benchmark.average, benchmark.min);
+                first = false;
+                wprintf(L"%-32hs %4u %12.1f ns\n", KernelName((adKernelType)k), (unsigned int)benchmark.reducedImageSize, benchmark.min);
+            }
+        }
+        fprintf(file, "\n  ],\n  \"simd\": {\"sse41\": %s, \"avx2\": %s, \"avx512bw\": %s}\n}\n", 
+            (simd & AD_SIMD_SSE41) ? "true" : "false", (simd & AD_SIMD_AVX2) ? "true" : "false", 
+            (simd & AD_SIMD_AVX512BW) ? "true" : "false");
+        fclose(file);
+
+        adRelease(handle);
+        return exitCode;
+    }
+
+    // Файлы каталога (без подкаталогов) декодируются по кругу, пока на формат не уйдет kernelTime секунд. 
+    // Формат определяется по расширению. Первый проход по каждому формату не учитывается: 
+    // он прогревает кэш файлов и контексты кодеков потока.
+    static int RunDecode(const TBenchOptions & options)
+    {
+        typedef std::map<std::wstring, std::vector<std::wstring>> TFormats;
+        TFormats formats;
+        WIN32_FIND_DATAW findData;
+        HANDLE hFind = ::FindFirstFileW((options.decode + L"\\*").c_str(), &findData);
+        if(hFind == INVALID_HANDLE_VALUE)
+        {
+            wprintf(L"Can't read directory %ls!\n", options.decode.c_str());
+            return 1;
+        }
+        do
+        {
+            if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            const wchar_t *dot = wcsrchr(findData.cFileName, L'.');
+            if(dot == NULL)
+                continue;
+            std::wstring extension(dot + 1);
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::towupper);
+            formats[extension].push_back(options.decode + L"\\" + findData.cFileName);
+        } while(::FindNextFileW(hFind, &findData));
+        ::FindClose(hFind);
+
+        wchar_t temp[MAX_PATH];
+        ::GetTempPathW(MAX_PATH, temp);
+        std::wstring userPath = std::wstring(temp) + L"AntiDupl.Bench.decode";
+        ::CreateDirectoryW(userPath.c_str(), NULL);
+        adEngineHandle handle = adCreateW(userPath.c_str());
+        if(handle == NULL)
+            return 1;
+
+        std::vector<adUInt8> pixels(DECODE_BITMAP_SIZE*DECODE_BITMAP_SIZE*4);
+        adBitmap bitmap;
+        bitmap.width = DECODE_BITMAP_SIZE;
+        bitmap.height = DECODE_BITMAP_SIZE;
+        bitmap.stride = DECODE_BITMAP_SIZE*4;
+        bitmap.format = AD_PIXEL_FORMAT_ARGB32;
+        bitmap.data = pixels.data();
+
+        wprintf(L"%-8ls %7ls %7ls %10ls %10ls\n", L"format", L"files", L"failed", L"images/s", L"ms/image");
+        for(TFormats::const_iterator it = formats.begin(); it != formats.end(); ++it)
+        {
+            const std::vector<std::wstring> & files = it->second;
+            size_t failed = 0;
+            for(size_t i = 0; i < files.size(); ++i)
+                if(adLoadBitmapW(handle, files[i].c_str(), &bitmap) != AD_OK)
+                    failed++;
+
+            size_t count = 0;
+            double start = Time(), time = 0;
+            do
+            {
+                for(size_t i = 0; i < files.size(); ++i)
+                    adLoadBitmapW(handle, files[i].c_str(), &bitmap);
+                count += files.size();
+                time = Time() - start;
+            } while(time < options.kernelTime);
+
+            wprintf(L"%-8ls %7u %7u %10.1f %10.3f\n", it->first.c_str(), (unsigned int)files.size(), (unsigned int)failed, 
+                count/time, time*1000.0/count);
+        }
+
+        adRelease(handle);
+        return 0;
+    }
+
+    static std::vector<int> ParseList(const wchar_t *value)
+    {
+        std::vector<int> list;
+        for(const wchar_t *p = value; *p; )
+        {
+            wchar_t *end;
+            list.push_back((int)wcstol(p, &end, 10));
+            p = (*end == L',' ? end + 1 : end + wcslen(end));
+        }
+        return list;
+    }
+
+    static void PrintUsage()
+    {
+        wprintf(L"Usage: AntiDupl.Bench.exe [options]\n"
+            L"  -corpus <path>       directory of the synthetic corpus (created if absent)\n"
+            L"  -count <n>           number of original images (default 1000)\n"
+            L"  -duplicates <n>      near-duplicates of each original (default 3)\n"
+            L"  -seed <n>            random seed (default 1)\n"
+            L"  -size <w>,<h>        size of the original images (default 640,480)\n"
+            L"  -comparers <list>    squared,ssim (default squared)\n"
+            L"  -threads <list>      collect and compare thread counts (default 0 - automatic)\n"
+            L"  -reduced <list>      reduced image sizes (default 32)\n"
+            L"  -threshold <n>       difference threshold in percent (default 5)\n"
+            L"  -path <path>         search the given directory instead of the synthetic corpus\n"
+            L"  -save <file>         save results of the first configuration as golden output\n"
+            L"  -verify <file>       compare results of every configuration with golden output\n"
+            L"  -equivalence 1       compare results of every configuration with the first one\n"
+            L"  -tolerance <list>    difference=<percent>,transform=ignore,defect=ignore,group=ignore\n"
+            L"  -defects 1           check images on defects, blockiness and blurring (results go to golden output)\n"
+            L"  -kernels <file>      measure single kernels for each -reduced size and write JSON\n"
+            L"  -decode <path>       measure decoding of the files in the directory, per format\n"
+            L"  -time <seconds>      measuring time of one kernel or format (default 0.5)\n");
+    }
+
+    static bool ParseOptions(int argc, wchar_t *argv[], TBenchOptions & options)
+    {
+        options.corpus.count = 1000;
+        options.corpus.duplicates = 3;
+        options.corpus.seed = 1;
+        options.corpus.width = 640;
+        options.corpus.height = 480;
+        options.comparers.push_back(AD_COMPARING_SQUARED_SUM);
+        options.threads.push_back(0);
+        options.reducedSizes.push_back(32);
+        options.threshold = 5;
+        options.kernelTime = 0.5;
+        options.equivalence = false;
+        options.defects = false;
+
+        for(int i = 1; i < argc; i += 2)
+        {
+            std::wstring name = argv[i];
+            if(i + 1 >= argc)
+                return false;
+            const wchar_t *value = argv[i + 1];
+            if(name == L"-corpus")
+                options.corpus.path = value;
+            else if(name == L"-count")
+                options.corpus.count = wcstoul(value, NULL, 10);
+            else if(name == L"-duplicates")
+                options.corpus.duplicates = wcstoul(value, NULL, 10);
+            else if(name == L"-seed")
+                options.corpus.seed = wcstoul(value, NULL, 10);
+            else if(name == L"-size")
+            {
+                std::vector<int> size = ParseList(value);
+                if(size.size() != 2 || size[0] < 64 || size[1] < 64)
+                    return false;
+                options.corpus.width = size[0];
+                options.corpus.height = size[1];
+            }
+            else if(name == L"-comparers")
+            {
+                options.comparers.clear();
+                for(const wchar_t *p = value; *p; p += (*p == L',' ? 1 : 0))
+                {
+                    size_t length = wcscspn(p, L",");
+                    std::wstring comparer(p, length);
+                    if(comparer == L"squared")
+                        options.comparers.push_back(AD_COMPARING_SQUARED_SUM);
+                    else if(comparer == L"ssim")
+                        options.comparers.push_back(AD_COMPARING_SSIM);
+                    else
+                        return false;
+                    p += length;
+                }
+            }
+            else if(name == L"-threads")
+                options.threads = ParseList(value);
+            else if(name == L"-reduced")
+                options.reducedSizes = ParseList(value);
+            else if(name == L"-threshold")
+                options.threshold = _wtoi(value);
+            else if(name == L"-kernels")
+                options.kernels = value;
+            else if(name == L"-decode")
+                options.decode = value;
+            else if(name == L"-time")
+                options.kernelTime = _wtof(value);
+            else if(name == L"-path")
+                options.path = value;
+            else if(name == L"-save")
+                options.save = value;
+            else if(name == L"-verify")
+                options.verify = value;
+            else if(name == L"-equivalence")
+                options.equivalence = _wtoi(value) != 0;
+            else if(name == L"-defects")
+                options.defects = _wtoi(value) != 0;
+            else if(name == L"-tolerance")
+            {
+                if(!options.tolerance.Parse(value))
+                    return false;
+            }
+            else
+                return false;
+        }
+
+        if(options.corpus.path.empty())
+        {
+            wchar_t temp[MAX_PATH];
+            ::GetTempPathW(MAX_PATH, temp);
+            wchar_t name[MAX_PATH];
+            swprintf_s(name, L"AntiDupl.Bench.%u.%ux%u.%dx%d", options.corpus.seed, (unsigned int)options.corpus.count, 
+                (unsigned int)options.corpus.duplicates, options.corpus.width, options.corpus.height);
+            options.corpus.path = std::wstring(temp) + name;
+        }
+        return options.corpus.count > 0 && !options.comparers.empty() && !options.threads.empty() && !options.reducedSizes.empty();
+    }
+}
+
+int wmain(int argc, wchar_t *argv[])
+{
+    using namespace ad;
+
+    TBenchOptions options;
+    if(!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if(!options.kernels.empty())
+        return RunKernels(options);
+
+    if(!options.decode.empty())
+        return RunDecode(options);
+
+    TGolden reference;
+    if(!options.verify.empty() && !reference.Load(options.verify))
+    {
+        wprintf(L"Can't load golden output from %ls!\n", options.verify.c_str());
+        return 1;
+    }
+    bool golden = !options.save.empty() || !options.verify.empty() || options.equivalence;
+
+    TCorpus corpus(options.corpus);
+    std::wstring searchPath = options.path;
+    if(searchPath.empty())
+    {
+        Gdiplus::GdiplusStartupInput input;
+        ULONG_PTR token;
+        Gdiplus::GdiplusStartup(&token, &input, NULL);
+
+        wprintf(L"Corpus %ls: %u images, %u true pairs.\n", corpus.Path().c_str(), 
+            (unsigned int)corpus.ImageCount(), (unsigned int)corpus.PairCount());
+        double start = Time();
+        bool generated = corpus.Generate();
+        Gdiplus::GdiplusShutdown(token);
+        if(!generated)
+        {
+            wprintf(L"Can't create corpus!\n");
+            return 1;
+        }
+        wprintf(L"Corpus is ready in %.1f s.\n\n", Time() - start);
+        searchPath = corpus.Path();
+    }
+
+    wprintf(L"%-8ls %7ls %7ls %9ls %10ls %12ls %10ls %8ls %8ls %7ls\n", L"comparer", L"threads", L"reduced", 
+        L"time,s", L"images/s", L"pairs/s", L"peak,MB", L"found", L"false", L"recall");
+
+    wchar_t temp[MAX_PATH];
+    ::GetTempPathW(MAX_PATH, temp);
+    std::wstring userPath = std::wstring(temp) + L"AntiDupl.Bench.user";
+    int exitCode = 0;
+    bool first = true;
+    for(size_t c = 0; c < options.comparers.size(); ++c)
+    {
+        for(size_t t = 0; t < options.threads.size(); ++t)
+        {
+            for(size_t r = 0; r < options.reducedSizes.size(); ++r)
+            {
+                TBenchResult result;
+                TGolden current;
+                adError error = Run(options, searchPath, userPath, options.comparers[c], options.threads[t], options.reducedSizes[r], 
+                    result, golden ? &current : NULL);
+                if(error != AD_OK)
+                {
+                    wprintf(L"%-8ls %7d %7d error %d\n", ComparerName(options.comparers[c]), options.threads[t], options.reducedSizes[r], error);
+                    exitCode = 1;
+                    continue;
+                }
+                wchar_t recall[16] = L"-";
+                if(options.path.empty())
+                    swprintf_s(recall, L"%.4f", corpus.PairCount() ? double(result.truePairNumber)/corpus.PairCount() : 1.0);
+                wprintf(L"%-8ls %7d %7d %9.3f %10.1f %12.0f %10.1f %8u %8u %7ls\n", 
+                    ComparerName(options.comparers[c]), options.threads[t], options.reducedSizes[r], result.time, 
+                    result.time > 0 ? result.imageNumber/result.time : 0.0, 
+                    result.time > 0 ? result.pairNumber/result.time : 0.0, 
+                    result.peakMemory/1024.0/1024.0, (unsigned int)result.truePairNumber, (unsigned int)result.falsePairNumber, recall);
+
+                if(first && !options.save.empty() && !current.Save(options.save))
+                {
+                    wprintf(L"Can't save golden output to %ls!\n", options.save.c_str());
+                    exitCode = 1;
+                }
+                if(first && options.equivalence && options.verify.empty())
+                    reference = current;
+                else if(!options.verify.empty() || options.equivalence)
+                {
+                    size_t divergences = current.Diff(reference, options.tolerance, stdout);
+                    if(divergences)
+                    {
+                        wprintf(L"%u results diverge from the golden output.\n", (unsigned int)divergences);
+                        exitCode = 1;
+                    }
+                }
+                first = false;
+            }
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,221 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <windows.h>
+#include <gdiplus.h>
+
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "adCorpus.h"
+
+namespace ad
+{
+    const ULONG ORIGINAL_QUALITY = 92;
+    const ULONG DUPLICATE_QUALITY = 85;
+
+    //-------------------------------------------------------------------------
+
+    // std::uniform_int_distribution зависит от реализации библиотеки, поэтому диапазон 
+    // получается делением выхода mt19937, который определен стандартом.
+    class TRandom
+    {
+    public:
+        TRandom(unsigned int seed) : m_generator(seed) {}
+
+        int Get(int min, int max) { return min + (int)(m_generator()%(unsigned int)(max - min + 1)); }
+
+        Gdiplus::Color Color(int alpha) { return Gdiplus::Color(alpha, Get(0, 255), Get(0, 255), Get(0, 255)); }
+
+    private:
+        std::mt19937 m_generator;
+    };
+
+    static bool GetEncoderClsid(const wchar_t *format, CLSID *pClsid)
+    {
+        UINT number = 0, size = 0;
+        Gdiplus::GetImageEncodersSize(&number, &size);
+        if(size == 0)
+            return false;
+
+        std::vector<unsigned char> buffer(size);
+        Gdiplus::ImageCodecInfo *pInfo = (Gdiplus::ImageCodecInfo*)buffer.data();
+        Gdiplus::GetImageEncoders(number, size, pInfo);
+        for(UINT i = 0; i < number; ++i)
+        {
+            if(wcscmp(pInfo[i].MimeType, format) == 0)
+            {
+                *pClsid = pInfo[i].Clsid;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool SaveJpeg(Gdiplus::Bitmap *pBitmap, const std::wstring & fileName, ULONG quality)
+    {
+        CLSID clsid;
+        if(!GetEncoderClsid(L"image/jpeg", &clsid))
+            return false;
+
+        Gdiplus::EncoderParameters parameters;
+        parameters.Count = 1;
+        parameters.Parameter[0].Guid = Gdiplus::EncoderQuality;
+        parameters.Parameter[0].Type = Gdiplus::EncoderParameterValueTypeLong;
+        parameters.Parameter[0].NumberOfValues = 1;
+        parameters.Parameter[0].Value = &quality;
+        return pBitmap->Save(fileName.c_str(), &clsid, &parameters) == Gdiplus::Ok;
+    }
+
+    static bool FileExists(const std::wstring & fileName)
+    {
+        return ::GetFileAttributesW(fileName.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+    // Градиентный фон и набор случайных фигур: у разных изображений заметно различаются 
+    // как уменьшенные копии, так и средняя яркость.
+    static Gdiplus::Bitmap* CreateOriginal(TRandom & random, int width, int height)
+    {
+        Gdiplus::Bitmap *pBitmap = new Gdiplus::Bitmap(width, height, PixelFormat24bppRGB);
+        Gdiplus::Graphics graphics(pBitmap);
+        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+
+        Gdiplus::LinearGradientBrush background(Gdiplus::Point(0, 0), 
+            Gdiplus::Point(random.Get(1, width), random.Get(1, height)), random.Color(255), random.Color(255));
+        graphics.FillRectangle(&background, 0, 0, width, height);
+
+        for(int i = 0, n = random.Get(8, 24); i < n; ++i)
+        {
+            Gdiplus::SolidBrush brush(random.Color(random.Get(128, 255)));
+            int x = random.Get(-width/8, width), y = random.Get(-height/8, height);
+            int w = random.Get(width/16, width/2), h = random.Get(height/16, height/2);
+            if(random.Get(0, 1))
+                graphics.FillEllipse(&brush, x, y, w, h);
+            else
+                graphics.FillRectangle(&brush, x, y, w, h);
+        }
+        return pBitmap;
+    }
+
+    static bool SaveDuplicate(TRandom & random, Gdiplus::Bitmap *pOriginal, TDistortion distortion, const std::wstring & fileName)
+    {
+        int width = pOriginal->GetWidth(), height = pOriginal->GetHeight();
+        std::unique_ptr<Gdiplus::Bitmap> pBitmap;
+        ULONG quality = DUPLICATE_QUALITY;
+        switch(distortion)
+        {
+        case DISTORTION_RESIZE:
+            {
+                int percent = random.Get(40, 80);
+                pBitmap.reset(new Gdiplus::Bitmap(width*percent/100, height*percent/100, PixelFormat24bppRGB));
+                Gdiplus::Graphics graphics(pBitmap.get());
+                graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+                graphics.DrawImage(pOriginal, 0, 0, pBitmap->GetWidth(), pBitmap->GetHeight());
+            }
+            break;
+        case DISTORTION_RECOMPRESS:
+            pBitmap.reset(pOriginal->Clone(0, 0, width, height, PixelFormat24bppRGB));
+            quality = random.Get(25, 60);
+            break;
+        case DISTORTION_ROTATE:
+            pBitmap.reset(pOriginal->Clone(0, 0, width, height, PixelFormat24bppRGB));
+            pBitmap->RotateFlip((Gdiplus::RotateFlipType)random.Get(Gdiplus::Rotate90FlipNone, Gdiplus::Rotate270FlipNone));
+            break;
+        case DISTORTION_CROP:
+            {
+                int dx = width*random.Get(1, 4)/100, dy = height*random.Get(1, 4)/100;
+                pBitmap.reset(pOriginal->Clone(dx, dy, width - 2*dx, height - 2*dy, PixelFormat24bppRGB));
+            }
+            break;
+        default:
+            return false;
+        }
+        return SaveJpeg(pBitmap.get(), fileName, quality);
+    }
+
+    //-------------------------------------------------------------------------
+
+    TCorpus::TCorpus(const TCorpusOptions & options)
+        : m_options(options)
+    {
+    }
+
+    // Случайная последовательность каждой группы зависит только от seed и номера группы, 
+    // поэтому набор дополняется до большего count без изменения уже созданных файлов.
+    bool TCorpus::Generate()
+    {
+        ::CreateDirectoryW(m_options.path.c_str(), NULL);
+        for(size_t g = 0; g < m_options.count; ++g)
+        {
+            wchar_t prefix[32];
+            swprintf_s(prefix, L"\\g%07u_", (unsigned int)g);
+
+            std::wstring original = m_options.path + prefix + L"0_original.jpg";
+            std::vector<std::wstring> duplicates;
+            bool complete = FileExists(original);
+            for(size_t d = 0; d < m_options.duplicates; ++d)
+            {
+                TDistortion distortion = (TDistortion)((g + d)%DISTORTION_SIZE);
+                duplicates.push_back(m_options.path + prefix + std::to_wstring(d + 1) + L"_" + Name(distortion) + L".jpg");
+                complete = complete && FileExists(duplicates.back());
+            }
+            if(complete)
+                continue;
+
+            TRandom random(m_options.seed*0x9E3779B1 + (unsigned int)g);
+            std::unique_ptr<Gdiplus::Bitmap> pOriginal(CreateOriginal(random, m_options.width, m_options.height));
+            if(!SaveJpeg(pOriginal.get(), original, ORIGINAL_QUALITY))
+                return false;
+            for(size_t d = 0; d < m_options.duplicates; ++d)
+            {
+                if(!SaveDuplicate(random, pOriginal.get(), (TDistortion)((g + d)%DISTORTION_SIZE), duplicates[d]))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    size_t TCorpus::Group(const std::wstring & fileName)
+    {
+        size_t name = fileName.find_last_of(L"\\/");
+        name = (name == std::wstring::npos ? 0 : name + 1);
+        if(fileName.size() < name + 9 || fileName[name] != L'g' || fileName[name + 8] != L'_')
+            return -1;
+
+        size_t group = 0;
+        for(size_t i = name + 1; i < name + 8; ++i)
+        {
+            if(fileName[i] < L'0' || fileName[i] > L'9')
+                return -1;
+            group = group*10 + (fileName[i] - L'0');
+        }
+        return group;
+    }
+
+    const wchar_t * TCorpus::Name(TDistortion distortion)
+    {
+        static const wchar_t * names[DISTORTION_SIZE] = { L"resize", L"recompress", L"rotate", L"crop" };
+        return distortion < DISTORTION_SIZE ? names[distortion] : L"unknown";
+    }
+}
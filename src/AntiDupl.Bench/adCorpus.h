@@ -0,0 +1,78 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adCorpus_h__
+#define __adCorpus_h__
+
+#include <string>
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+
+    // Искажения, которыми из исходного изображения получаются почти-дубликаты.
+    enum TDistortion
+    {
+        DISTORTION_RESIZE = 0,
+        DISTORTION_RECOMPRESS,
+        DISTORTION_ROTATE,
+        DISTORTION_CROP,
+        DISTORTION_SIZE
+    };
+
+    struct TCorpusOptions
+    {
+        std::wstring path;
+        size_t count; // число исходных изображений
+        size_t duplicates; // число почти-дубликатов каждого исходного изображения
+        unsigned int seed;
+        int width;
+        int height;
+    };
+
+    // Воспроизводимый набор изображений для замеров: случайные исходные изображения и их 
+    // искаженные копии. Изображение и его копии образуют группу, номер группы хранится в имени файла, 
+    // поэтому эталонные пары восстанавливаются и для ранее созданного набора.
+    class TCorpus
+    {
+    public:
+        TCorpus(const TCorpusOptions & options);
+
+        // Создает недостающие файлы набора, уже существующие файлы не перезаписываются.
+        bool Generate();
+
+        const std::wstring & Path() const { return m_options.path; }
+        size_t ImageCount() const { return m_options.count*(m_options.duplicates + 1); }
+        size_t PairCount() const { return m_options.count*(m_options.duplicates + 1)*m_options.duplicates/2; }
+
+        // Возвращает номер группы файла или -1, если файл не принадлежит набору.
+        static size_t Group(const std::wstring & fileName);
+
+        static const wchar_t * Name(TDistortion distortion);
+
+    private:
+        TCorpusOptions m_options;
+    };
+}
+
+#endif//__adCorpus_h__
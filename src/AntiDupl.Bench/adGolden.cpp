@@ -0,0 +1,272 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "adGolden.h"
+
+namespace ad
+{
+    const size_t GOLDEN_BATCH_SIZE = 16;
+    const size_t GOLDEN_FIELD_NUMBER = 7;
+    const double GOLDEN_DIFFERENCE_EPSILON = 0.000001; // различие сохраняется с 6 знаками после запятой
+
+    //-------------------------------------------------------------------------
+
+    static std::vector<std::wstring> Split(const std::wstring & text, wchar_t separator)
+    {
+        std::vector<std::wstring> fields;
+        for(size_t begin = 0; ; )
+        {
+            size_t end = text.find(separator, begin);
+            fields.push_back(text.substr(begin, end == std::wstring::npos ? std::wstring::npos : end - begin));
+            if(end == std::wstring::npos)
+                break;
+            begin = end + 1;
+        }
+        return fields;
+    }
+
+    static std::wstring Relative(const std::wstring & path, const std::wstring & root)
+    {
+        if(path.size() > root.size() + 1 && _wcsnicmp(path.c_str(), root.c_str(), root.size()) == 0 && path[root.size()] == L'\\')
+            return path.substr(root.size() + 1);
+        return path;
+    }
+
+    // Обратная трансформация: повороты обращаются, поворот с отражением обратен сам себе.
+    static adTransformType Inverse(adTransformType transform)
+    {
+        if(transform < AD_TRANSFORM_MIRROR_TURN_0)
+            return (adTransformType)((AD_TRANSFORM_MIRROR_TURN_0 - transform)%AD_TRANSFORM_MIRROR_TURN_0);
+        return transform;
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool TTolerance::Parse(const wchar_t *value)
+    {
+        std::vector<std::wstring> items = Split(value, L',');
+        for(size_t i = 0; i < items.size(); ++i)
+        {
+            std::vector<std::wstring> item = Split(items[i], L'=');
+            if(item.size() != 2)
+                return false;
+            if(item[0] == L"difference")
+                difference = _wtof(item[1].c_str());
+            else if(item[1] != L"ignore")
+                return false;
+            else if(item[0] == L"transform")
+                transform = true;
+            else if(item[0] == L"defect")
+                defect = true;
+            else if(item[0] == L"group")
+                group = true;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+
+    adError TGolden::Import(adEngineHandle handle, const std::wstring & root)
+    {
+        std::wstring base = root;
+        while(!base.empty() && (base.back() == L'\\' || base.back() == L'/'))
+            base.pop_back();
+
+        std::vector<TRecord> records;
+        std::vector<adSize> groups;
+        std::map<adSize, std::wstring> names;
+        std::vector<adResultW> results(GOLDEN_BATCH_SIZE);
+        for(adSize startFrom = 0; ; )
+        {
+            adSize size = results.size();
+            adError error = adResultGetW(handle, &startFrom, results.data(), &size);
+            if(error != AD_OK)
+                return error;
+            if(size == 0)
+                break;
+            for(adSize i = 0; i < size; ++i)
+            {
+                const adResultW & result = results[i];
+                TRecord record;
+                record.type = result.type;
+                record.first = Relative(result.first.path, base);
+                record.defect = result.defect;
+                record.difference = result.difference;
+                record.transform = result.transform;
+                if(result.type == AD_RESULT_DUPL_IMAGE_PAIR)
+                {
+                    record.second = Relative(result.second.path, base);
+                    if(record.second < record.first)
+                    {
+                        std::swap(record.first, record.second);
+                        record.transform = Inverse(record.transform);
+                    }
+                    std::wstring & name = names[result.group];
+                    if(name.empty() || record.first < name)
+                        name = record.first;
+                }
+                records.push_back(record);
+                groups.push_back(result.group);
+            }
+            startFrom += size;
+        }
+
+        m_records.clear();
+        for(size_t i = 0; i < records.size(); ++i)
+        {
+            if(records[i].type == AD_RESULT_DUPL_IMAGE_PAIR)
+                records[i].group = names[groups[i]];
+            Insert(records[i]);
+        }
+        return AD_OK;
+    }
+
+    bool TGolden::Load(const std::wstring & fileName)
+    {
+        FILE *file = NULL;
+        if(_wfopen_s(&file, fileName.c_str(), L"r, ccs=UTF-8") != 0 || file == NULL)
+            return false;
+
+        m_records.clear();
+        std::vector<wchar_t> line(4*MAX_PATH_EX);
+        while(fgetws(line.data(), (int)line.size(), file))
+        {
+            std::wstring text = line.data();
+            while(!text.empty() && (text.back() == L'\n' || text.back() == L'\r'))
+                text.pop_back();
+            if(text.empty() || text[0] == L'#')
+                continue;
+
+            std::vector<std::wstring> fields = Split(text, L'\t');
+            if(fields.size() != GOLDEN_FIELD_NUMBER)
+            {
+                fclose(file);
+                return false;
+            }
+            TRecord record;
+            record.type = (adResultType)_wtoi(fields[0].c_str());
+            record.first = fields[1];
+            record.second = fields[2];
+            record.defect = (adDefectType)_wtoi(fields[3].c_str());
+            record.difference = _wtof(fields[4].c_str());
+            record.transform = (adTransformType)_wtoi(fields[5].c_str());
+            record.group = fields[6];
+            Insert(record);
+        }
+        fclose(file);
+        return true;
+    }
+
+    bool TGolden::Save(const std::wstring & fileName) const
+    {
+        FILE *file = NULL;
+        if(_wfopen_s(&file, fileName.c_str(), L"w, ccs=UTF-8") != 0 || file == NULL)
+            return false;
+
+        fwprintf(file, L"# type\tfirst\tsecond\tdefect\tdifference\ttransform\tgroup\n");
+        for(TRecords::const_iterator it = m_records.begin(); it != m_records.end(); ++it)
+        {
+            const TRecord & record = it->second;
+            fwprintf(file, L"%d\t%ls\t%ls\t%d\t%.6f\t%d\t%ls\n", record.type, record.first.c_str(), record.second.c_str(), 
+                record.defect, record.difference, record.transform, record.group.c_str());
+        }
+        bool result = ferror(file) == 0;
+        fclose(file);
+        return result;
+    }
+
+    // "+" - результат есть только в проверяемом наборе, "-" - только в эталоне, "~" - отличаются поля.
+    size_t TGolden::Diff(const TGolden & golden, const TTolerance & tolerance, FILE *out) const
+    {
+        size_t count = 0;
+        TRecords::const_iterator a = m_records.begin(), b = golden.m_records.begin();
+        while(a != m_records.end() || b != golden.m_records.end())
+        {
+            if(b == golden.m_records.end() || (a != m_records.end() && a->first < b->first))
+            {
+                Print(out, L'+', a->second);
+                ++a;
+                ++count;
+            }
+            else if(a == m_records.end() || b->first < a->first)
+            {
+                Print(out, L'-', b->second);
+                ++b;
+                ++count;
+            }
+            else
+            {
+                const TRecord & x = a->second, & y = b->second;
+                wchar_t buffer[MAX_PATH];
+                std::wstring fields;
+                if(!tolerance.defect && x.defect != y.defect)
+                {
+                    swprintf_s(buffer, L" defect %d != %d;", x.defect, y.defect);
+                    fields += buffer;
+                }
+                if(fabs(x.difference - y.difference) > tolerance.difference + GOLDEN_DIFFERENCE_EPSILON)
+                {
+                    swprintf_s(buffer, L" difference %.6f != %.6f;", x.difference, y.difference);
+                    fields += buffer;
+                }
+                if(!tolerance.transform && x.transform != y.transform)
+                {
+                    swprintf_s(buffer, L" transform %d != %d;", x.transform, y.transform);
+                    fields += buffer;
+                }
+                if(!tolerance.group && x.group != y.group)
+                    fields += L" group " + x.group + L" != " + y.group + L";";
+                if(!fields.empty())
+                {
+                    fwprintf(out, L"~ %ls\t%ls\t%ls\n", x.first.c_str(), x.second.c_str(), fields.c_str());
+                    ++count;
+                }
+                ++a;
+                ++b;
+            }
+        }
+        return count;
+    }
+
+    void TGolden::Insert(const TRecord & record)
+    {
+        wchar_t type[16];
+        swprintf_s(type, L"%d\t", record.type);
+        m_records[type + record.first + L"\t" + record.second] = record;
+    }
+
+    void TGolden::Print(FILE *out, wchar_t sign, const TRecord & record)
+    {
+        if(record.type == AD_RESULT_DUPL_IMAGE_PAIR)
+            fwprintf(out, L"%lc %ls\t%ls\tdifference %.6f, transform %d\n", sign, record.first.c_str(), record.second.c_str(), 
+                record.difference, record.transform);
+        else
+            fwprintf(out, L"%lc %ls\tdefect %d\n", sign, record.first.c_str(), record.defect);
+    }
+}
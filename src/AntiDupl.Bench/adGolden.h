@@ -0,0 +1,86 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adGolden_h__
+#define __adGolden_h__
+
+#include <stdio.h>
+#include <string>
+#include <map>
+
+#include "AntiDupl.h"
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+
+    // Допуски сравнения полей результата, задаются строкой вида "difference=0.5,transform=ignore".
+    struct TTolerance
+    {
+        double difference; // абсолютное отклонение различия в процентах
+        bool transform; // true - поле не сравнивается
+        bool defect;
+        bool group;
+
+        TTolerance() : difference(0), transform(false), defect(false), group(false) {}
+
+        bool Parse(const wchar_t *value);
+    };
+
+    // Результаты поиска в виде, не зависящем от порядка выдачи, нумерации групп и расположения набора: 
+    // пути хранятся относительно корня поиска, пара упорядочена по путям (трансформация при этом 
+    // обращается), группа обозначается наименьшим путем своих изображений.
+    class TGolden
+    {
+    public:
+        adError Import(adEngineHandle handle, const std::wstring & root);
+
+        bool Load(const std::wstring & fileName);
+        bool Save(const std::wstring & fileName) const;
+
+        // Печатает расхождения с эталоном golden и возвращает их число.
+        size_t Diff(const TGolden & golden, const TTolerance & tolerance, FILE *out) const;
+
+        size_t Size() const { return m_records.size(); }
+
+    private:
+        struct TRecord
+        {
+            adResultType type;
+            std::wstring first;
+            std::wstring second;
+            adDefectType defect;
+            double difference;
+            adTransformType transform;
+            std::wstring group;
+        };
+        typedef std::map<std::wstring, TRecord> TRecords;
+
+        void Insert(const TRecord & record);
+        static void Print(FILE *out, wchar_t sign, const TRecord & record);
+
+        TRecords m_records;
+    };
+}
+
+#endif//__adGolden_h__
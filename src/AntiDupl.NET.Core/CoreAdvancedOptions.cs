@@ -41,6 +41,10 @@ namespace AntiDupl.NET.Core
         public int resultCountMax;
         public int ignoreFrameWidth;
         public bool useLibJpegTurbo;
+        public bool useThumbnails;
+        public bool performanceCounters;
+        public bool trace;
+        public int memoryLimit;
 
         public CoreAdvancedOptions()
         {
@@ -58,6 +62,10 @@ namespace AntiDupl.NET.Core
             resultCountMax = advancedOptions.resultCountMax;
             ignoreFrameWidth = advancedOptions.ignoreFrameWidth;
             useLibJpegTurbo = advancedOptions.useLibJpegTurbo;
+            useThumbnails = advancedOptions.useThumbnails;
+            performanceCounters = advancedOptions.performanceCounters;
+            trace = advancedOptions.trace;
+            memoryLimit = advancedOptions.memoryLimit;
         }
 
         public CoreAdvancedOptions(ref CoreDll.adAdvancedOptions advancedOptions)
@@ -72,6 +80,10 @@ namespace AntiDupl.NET.Core
             resultCountMax = advancedOptions.resultCountMax;
             ignoreFrameWidth = advancedOptions.ignoreFrameWidth;
             useLibJpegTurbo = advancedOptions.useLibJpegTurbo != CoreDll.FALSE;
+            useThumbnails = advancedOptions.useThumbnails != CoreDll.FALSE;
+            performanceCounters = advancedOptions.performanceCounters != CoreDll.FALSE;
+            trace = advancedOptions.trace != CoreDll.FALSE;
+            memoryLimit = advancedOptions.memoryLimit;
         }
 
         public void ConvertTo(ref CoreDll.adAdvancedOptions advancedOptions)
@@ -86,6 +98,10 @@ namespace AntiDupl.NET.Core
             advancedOptions.resultCountMax = resultCountMax;
             advancedOptions.ignoreFrameWidth = ignoreFrameWidth;
             advancedOptions.useLibJpegTurbo = useLibJpegTurbo ? CoreDll.TRUE : CoreDll.FALSE;
+            advancedOptions.useThumbnails = useThumbnails ? CoreDll.TRUE : CoreDll.FALSE;
+            advancedOptions.performanceCounters = performanceCounters ? CoreDll.TRUE : CoreDll.FALSE;
+            advancedOptions.trace = trace ? CoreDll.TRUE : CoreDll.FALSE;
+            advancedOptions.memoryLimit = memoryLimit;
         }
 
         public CoreAdvancedOptions Clone()
@@ -105,7 +121,11 @@ namespace AntiDupl.NET.Core
                 undoQueueSize == advancedOptions.undoQueueSize &&
                 resultCountMax == advancedOptions.resultCountMax &&
                 ignoreFrameWidth == advancedOptions.ignoreFrameWidth &&
-                useLibJpegTurbo == advancedOptions.useLibJpegTurbo;
+                useLibJpegTurbo == advancedOptions.useLibJpegTurbo &&
+                useThumbnails == advancedOptions.useThumbnails &&
+                performanceCounters == advancedOptions.performanceCounters &&
+                trace == advancedOptions.trace &&
+                memoryLimit == advancedOptions.memoryLimit;
         }
 
         public int RatioResolution
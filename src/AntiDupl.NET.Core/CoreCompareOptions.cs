@@ -44,6 +44,8 @@ namespace AntiDupl.NET.Core
         public bool compareInsideOneFolder;
         public bool compareInsideOneSearchPath;
         public AlgorithmComparing algorithmComparing;
+        public int nearestCount;
+        public int clusterThreshold;
 
         public CoreCompareOptions()
         {
@@ -62,6 +64,8 @@ namespace AntiDupl.NET.Core
             maximalImageSize = compareOptions.maximalImageSize;
             compareInsideOneFolder = compareOptions.compareInsideOneFolder;
             compareInsideOneSearchPath = compareOptions.compareInsideOneSearchPath;
+            nearestCount = compareOptions.nearestCount;
+            clusterThreshold = compareOptions.clusterThreshold;
         }
 
         public CoreCompareOptions(ref CoreDll.adCompareOptions compareOptions)
@@ -77,6 +81,8 @@ namespace AntiDupl.NET.Core
             maximalImageSize = compareOptions.maximalImageSize;
             compareInsideOneFolder = compareOptions.compareInsideOneFolder != CoreDll.FALSE;
             compareInsideOneSearchPath = compareOptions.compareInsideOneSearchPath != CoreDll.FALSE;
+            nearestCount = compareOptions.nearestCount;
+            clusterThreshold = compareOptions.clusterThreshold;
         }
 
         public void ConvertTo(ref CoreDll.adCompareOptions compareOptions)
@@ -92,6 +98,8 @@ namespace AntiDupl.NET.Core
             compareOptions.maximalImageSize = maximalImageSize;
             compareOptions.compareInsideOneFolder = compareInsideOneFolder ? CoreDll.TRUE : CoreDll.FALSE;
             compareOptions.compareInsideOneSearchPath = compareInsideOneSearchPath ? CoreDll.TRUE : CoreDll.FALSE;
+            compareOptions.nearestCount = nearestCount;
+            compareOptions.clusterThreshold = clusterThreshold;
         }
 
         public CoreCompareOptions Clone()
@@ -112,7 +120,9 @@ namespace AntiDupl.NET.Core
                 minimalImageSize == compareOptions.minimalImageSize &&
                 maximalImageSize == compareOptions.maximalImageSize &&
                 compareInsideOneFolder == compareOptions.compareInsideOneFolder &&
-                compareInsideOneSearchPath == compareOptions.compareInsideOneSearchPath;
+                compareInsideOneSearchPath == compareOptions.compareInsideOneSearchPath &&
+                nearestCount == compareOptions.nearestCount &&
+                clusterThreshold == compareOptions.clusterThreshold;
         }
 
         public bool CheckOnEquality
@@ -225,6 +235,26 @@ namespace AntiDupl.NET.Core
             }
         }
 
+        public int NearestCount
+        {
+            get { return nearestCount; }
+            set
+            {
+                nearestCount = value;
+                NotifyPropertyChanged("NearestCount");
+            }
+        }
+
+        public int ClusterThreshold
+        {
+            get { return clusterThreshold; }
+            set
+            {
+                clusterThreshold = value;
+                NotifyPropertyChanged("ClusterThreshold");
+            }
+        }
+
         #region Члены INotifyPropertyChanged
 
         public event PropertyChangedEventHandler PropertyChanged;
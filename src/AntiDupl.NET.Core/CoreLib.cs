@@ -145,6 +145,11 @@ namespace AntiDupl.NET.Core
             return m_dll.adSearch(m_handle) == Error.Ok;
         }
 
+        public bool Watch()
+        {
+            return m_dll.adWatch(m_handle) == Error.Ok;
+        }
+
         public bool Load(CoreDll.FileType fileType, string fileName, bool check)
         {
             return m_dll.adLoadW(m_handle, fileType, fileName, check ? CoreDll.TRUE : CoreDll.FALSE) == Error.Ok;
@@ -192,6 +197,60 @@ namespace AntiDupl.NET.Core
             return null;
         }
 
+        public CorePerformance GetPerformance(CoreDll.PerformanceType performanceType)
+        {
+            try
+            {
+                object performanceO = new CoreDll.adPerformance();
+                byte[] performanceB = new byte[Marshal.SizeOf(performanceO)];
+                GCHandle performanceH = GCHandle.Alloc(performanceB, GCHandleType.Pinned);
+                try
+                {
+                    IntPtr performanceP = performanceH.AddrOfPinnedObject();
+                    if (m_dll.adPerformanceGet(m_handle, performanceType, performanceP) == Error.Ok)
+                    {
+                        CoreDll.adPerformance performance = (CoreDll.adPerformance)Marshal.PtrToStructure(performanceP, performanceO.GetType());
+                        return new CorePerformance(ref performance);
+                    }
+                }
+                finally
+                {
+                    performanceH.Free();
+                }
+            }
+            catch (Exception)
+            {
+            }
+            return null;
+        }
+
+        public CoreMemory GetMemory(CoreDll.MemoryType memoryType)
+        {
+            try
+            {
+                object memoryO = new CoreDll.adMemory();
+                byte[] memoryB = new byte[Marshal.SizeOf(memoryO)];
+                GCHandle memoryH = GCHandle.Alloc(memoryB, GCHandleType.Pinned);
+                try
+                {
+                    IntPtr memoryP = memoryH.AddrOfPinnedObject();
+                    if (m_dll.adMemoryGet(m_handle, memoryType, memoryP) == Error.Ok)
+                    {
+                        CoreDll.adMemory memory = (CoreDll.adMemory)Marshal.PtrToStructure(memoryP, memoryO.GetType());
+                        return new CoreMemory(ref memory);
+                    }
+                }
+                finally
+                {
+                    memoryH.Free();
+                }
+            }
+            catch (Exception)
+            {
+            }
+            return null;
+        }
+
         public CoreStatus StatusGet(CoreDll.ThreadType threadType, int threadId)
         {
             try
@@ -522,6 +581,49 @@ namespace AntiDupl.NET.Core
             return m_dll.adLoadBitmapW(m_handle, path, Marshal.UnsafeAddrOfPinnedArrayElement(pBitmap, 0));
         }
 
+        public bool BuildIndex(string path)
+        {
+            return m_dll.adIndexBuildW(m_handle, path) == Error.Ok;
+        }
+
+        public bool OpenIndex(string path)
+        {
+            return m_dll.adIndexOpenW(m_handle, path) == Error.Ok;
+        }
+
+        /// <summary>
+        /// Обслуживает запросы к открытому индексу через именованный канал до вызова Stop.
+        /// </summary>
+        public bool Serve(string pipeName)
+        {
+            return m_dll.adServeW(m_handle, pipeName) == Error.Ok;
+        }
+
+        /// <summary>
+        /// Возвращает не более k изображений из индекса, совпадающих с переданным, по возрастанию различия.
+        /// </summary>
+        public CoreMatch[] Query(string fileName, uint k, double threshold)
+        {
+            object matchObject = new CoreDll.adMatchW();
+            int sizeOfMatch = Marshal.SizeOf(matchObject);
+            byte[] buffer = new byte[sizeOfMatch * k];
+            UIntPtr[] pSize = new UIntPtr[1];
+            pSize[0] = new UIntPtr(k);
+            if (m_dll.adQueryW(m_handle, fileName, new UIntPtr(k), threshold,
+                Marshal.UnsafeAddrOfPinnedArrayElement(buffer, 0),
+                Marshal.UnsafeAddrOfPinnedArrayElement(pSize, 0)) != Error.Ok)
+                return null;
+
+            CoreMatch[] matches = new CoreMatch[pSize[0].ToUInt32()];
+            for (int i = 0; i < matches.Length; ++i)
+            {
+                IntPtr pMatch = Marshal.UnsafeAddrOfPinnedArrayElement(buffer, i * sizeOfMatch);
+                CoreDll.adMatchW match = (CoreDll.adMatchW)Marshal.PtrToStructure(pMatch, matchObject.GetType());
+                matches[i] = new CoreMatch(ref match);
+            }
+            return matches;
+        }
+
         //-----------Public properties----------------------------------------------
 
         #region Public properties
@@ -26,6 +26,7 @@ using System.Collections.Generic;
 using System.Collections;
 using System.Text;
 using AntiDupl.NET.Core.Original;
+using AntiDupl.NET.Core.Enums;
 using System.ComponentModel;
 
 namespace AntiDupl.NET.Core
@@ -70,6 +71,7 @@ namespace AntiDupl.NET.Core
         public bool HEIF;
         public bool AVIF;
         public bool JXL;
+        public RescanMode rescanMode;
 
         public CoreSearchOptions()
         {
@@ -96,6 +98,7 @@ namespace AntiDupl.NET.Core
             HEIF = searchOptions.HEIF;
             AVIF = searchOptions.AVIF;
             JXL = searchOptions.JXL;
+            rescanMode = searchOptions.rescanMode;
         }
 
         public CoreSearchOptions(CoreDll.adSearchOptions searchOptions)
@@ -119,6 +122,7 @@ namespace AntiDupl.NET.Core
             HEIF = searchOptions.HEIF != CoreDll.FALSE;
             AVIF = searchOptions.AVIF != CoreDll.FALSE;
             JXL = searchOptions.JXL != CoreDll.FALSE;
+            rescanMode = searchOptions.rescanMode;
         }
 
         public void ConvertTo(ref CoreDll.adSearchOptions searchOptions)
@@ -142,6 +146,7 @@ namespace AntiDupl.NET.Core
             searchOptions.HEIF = HEIF ? CoreDll.TRUE : CoreDll.FALSE;
             searchOptions.AVIF = AVIF ? CoreDll.TRUE : CoreDll.FALSE;
             searchOptions.JXL = JXL ? CoreDll.TRUE : CoreDll.FALSE;
+            searchOptions.rescanMode = rescanMode;
         }
 
         public CoreSearchOptions Clone()
@@ -170,7 +175,8 @@ namespace AntiDupl.NET.Core
                 WEBP == searchOptions.WEBP &&
                 HEIF == searchOptions.HEIF &&
                 AVIF == searchOptions.AVIF &&
-                JXL == searchOptions.JXL;
+                JXL == searchOptions.JXL &&
+                rescanMode == searchOptions.rescanMode;
         }
 
         public string[] GetActualExtensions()
@@ -42,6 +42,18 @@ namespace AntiDupl.NET.Core
         public uint renamedImageNumber;
         public uint deletedImageNumber;
         public UInt64 deletedImageSize;
+        public UInt64 readSize;
+        public double readTime;
+        public uint[] decodedImageNumber;
+        public double[] decodeTime;
+        public double reduceTime;
+        public UInt64 visitedCandidateNumber;
+        public UInt64 prunedCandidateNumber;
+        public UInt64 mainComparisonNumber;
+        public uint collectQueueSize;
+        public uint collectQueueSizeMax;
+        public uint compareQueueSize;
+        public uint compareQueueSizeMax;
         
         public CoreStatistic(ref CoreDll.adStatistic statistic)
         {
@@ -57,6 +69,20 @@ namespace AntiDupl.NET.Core
             renamedImageNumber = statistic.renamedImageNumber.ToUInt32();
             deletedImageNumber = statistic.deletedImageNumber.ToUInt32();
             deletedImageSize = statistic.deletedImageSize;
+            readSize = statistic.readSize;
+            readTime = statistic.readTime;
+            decodedImageNumber = new uint[statistic.decodedImageNumber.Length];
+            for (int i = 0; i < decodedImageNumber.Length; ++i)
+                decodedImageNumber[i] = statistic.decodedImageNumber[i].ToUInt32();
+            decodeTime = (double[])statistic.decodeTime.Clone();
+            reduceTime = statistic.reduceTime;
+            visitedCandidateNumber = statistic.visitedCandidateNumber;
+            prunedCandidateNumber = statistic.prunedCandidateNumber;
+            mainComparisonNumber = statistic.mainComparisonNumber;
+            collectQueueSize = statistic.collectQueueSize.ToUInt32();
+            collectQueueSizeMax = statistic.collectQueueSizeMax.ToUInt32();
+            compareQueueSize = statistic.compareQueueSize.ToUInt32();
+            compareQueueSizeMax = statistic.compareQueueSizeMax.ToUInt32();
         }
     }
 }
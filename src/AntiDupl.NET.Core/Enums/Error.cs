@@ -35,5 +35,10 @@
         InvalidInfoType = 30,
         InvalidGroupId = 31,
         InvalidSelectionType = 32,
+        DirectoryIsNotExist = 33,
+        IndexIsNotOpen = 34,
+        InvalidPerformanceType = 35,
+        InvalidKernelType = 36,
+        InvalidMemoryType = 37,
     }
 }
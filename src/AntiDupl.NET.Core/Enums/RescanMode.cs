@@ -0,0 +1,9 @@
+﻿namespace AntiDupl.NET.Core.Enums
+{
+    public enum RescanMode : int
+    {
+        Full = 0,
+        Cached = 1,
+        TrustDirectoryTime = 2,
+    };
+}
\ No newline at end of file
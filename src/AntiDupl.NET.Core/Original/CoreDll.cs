@@ -206,6 +206,8 @@ namespace AntiDupl.NET.Core.Original
             Jxl = 17,
         }
 
+        public const int IMAGE_TYPE_SIZE = 18;
+
         public enum DefectType : int
         {
             None = 0,
@@ -249,6 +251,29 @@ namespace AntiDupl.NET.Core.Original
             Compare = 2,
         }
 
+        public enum PerformanceType : int
+        {
+            Read = 0,
+            Decode = 1,
+            Collect = 2,
+            Compare = 3,
+            Result = 4,
+            Query = 5,
+        }
+
+        public enum MemoryType : int
+        {
+            ImageData = 0,
+            PixelData = 1,
+            Comparer = 2,
+            FileBuffer = 3,
+            Decode = 4,
+            Result = 5,
+            ImageInfo = 6,
+            Undo = 7,
+            Total = 8,
+        }
+
         public enum VersionType : int
         {
             AntiDupl = 0,
@@ -294,6 +319,7 @@ namespace AntiDupl.NET.Core.Original
             public int HEIF;
             public int AVIF;
             public int JXL;
+            public RescanMode rescanMode;
         }
 
         [StructLayout(LayoutKind.Sequential)]
@@ -310,6 +336,8 @@ namespace AntiDupl.NET.Core.Original
             public int compareInsideOneFolder;
             public int compareInsideOneSearchPath;
             public AlgorithmComparing algorithmComparing;
+            public int nearestCount;
+            public int clusterThreshold;
         }
 
         [StructLayout(LayoutKind.Sequential)]
@@ -336,6 +364,10 @@ namespace AntiDupl.NET.Core.Original
             public int resultCountMax;
             public int ignoreFrameWidth;
             public int useLibJpegTurbo;
+            public int useThumbnails;
+            public int performanceCounters;
+            public int trace;
+            public int memoryLimit;
         }
 
         [StructLayout(LayoutKind.Sequential)]
@@ -353,6 +385,40 @@ namespace AntiDupl.NET.Core.Original
             public UIntPtr renamedImageNumber;
             public UIntPtr deletedImageNumber;
             public ulong deletedImageSize;
+            public ulong readSize;
+            public double readTime;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = IMAGE_TYPE_SIZE)]
+            public UIntPtr[] decodedImageNumber;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = IMAGE_TYPE_SIZE)]
+            public double[] decodeTime;
+            public double reduceTime;
+            public ulong visitedCandidateNumber;
+            public ulong prunedCandidateNumber;
+            public ulong mainComparisonNumber;
+            public UIntPtr collectQueueSize;
+            public UIntPtr collectQueueSizeMax;
+            public UIntPtr compareQueueSize;
+            public UIntPtr compareQueueSizeMax;
+        };
+
+        public const int PERFORMANCE_HISTOGRAM_SIZE = 32;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct adPerformance
+        {
+            public ulong count;
+            public double total;
+            public double min;
+            public double max;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = PERFORMANCE_HISTOGRAM_SIZE)]
+            public ulong[] histogram;
+        };
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct adMemory
+        {
+            public ulong current;
+            public ulong peak;
         };
 
         [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Unicode)]
@@ -422,6 +488,15 @@ namespace AntiDupl.NET.Core.Original
             public HintType hint;
         }
 
+        [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Unicode)]
+        public class adMatchW
+        {
+            [MarshalAs(UnmanagedType.Struct)]
+            public adImageInfoW image;
+            public double difference;
+            public TransformType transform;
+        }
+
         [StructLayout(LayoutKind.Sequential)]
         public struct adGroup
         {
@@ -474,6 +549,11 @@ namespace AntiDupl.NET.Core.Original
         [DynamicModuleApi]
         public adSearch_fn adSearch = null;
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adWatch_fn(IntPtr handle);
+        [DynamicModuleApi]
+        public adWatch_fn adWatch = null;
+
         [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public delegate Error adLoadW_fn(IntPtr handle, FileType fileType, string fileName, int check);
         [DynamicModuleApi]
@@ -534,6 +614,16 @@ namespace AntiDupl.NET.Core.Original
         [DynamicModuleApi]
         public adStatusGetW_fn adStatusGetW = null;
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adPerformanceGet_fn(IntPtr handle, PerformanceType performanceType, IntPtr pPerformance);
+        [DynamicModuleApi]
+        public adPerformanceGet_fn adPerformanceGet = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adMemoryGet_fn(IntPtr handle, MemoryType memoryType, IntPtr pMemory);
+        [DynamicModuleApi]
+        public adMemoryGet_fn adMemoryGet = null;
+
         [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
         public delegate Error adResultSort_fn(IntPtr handle, SortType sortType, int increasing);
         [DynamicModuleApi]
@@ -623,5 +713,30 @@ namespace AntiDupl.NET.Core.Original
         public delegate Error adLoadBitmapW_fn(IntPtr handle, string fileName, IntPtr pBitmap);
         [DynamicModuleApi]
         public adLoadBitmapW_fn adLoadBitmapW = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adIndexBuildW_fn(IntPtr handle, string path);
+        [DynamicModuleApi]
+        public adIndexBuildW_fn adIndexBuildW = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adIndexOpenW_fn(IntPtr handle, string path);
+        [DynamicModuleApi]
+        public adIndexOpenW_fn adIndexOpenW = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adQueryW_fn(IntPtr handle, string fileName, UIntPtr k, double threshold, IntPtr pMatch, IntPtr pMatchSize);
+        [DynamicModuleApi]
+        public adQueryW_fn adQueryW = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adQueryBitmapW_fn(IntPtr handle, IntPtr pBitmap, UIntPtr k, double threshold, IntPtr pMatch, IntPtr pMatchSize);
+        [DynamicModuleApi]
+        public adQueryBitmapW_fn adQueryBitmapW = null;
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl, CharSet = CharSet.Unicode)]
+        public delegate Error adServeW_fn(IntPtr handle, string pipeName);
+        [DynamicModuleApi]
+        public adServeW_fn adServeW = null;
     }
 }
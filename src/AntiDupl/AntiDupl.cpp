@@ -57,6 +57,11 @@ typedef ad::TEngine* adEngineHandle;
 #include "adMistakeStorage.h"
 #include "adImageDataStorage.h"
 #include "adEngine.h"
+#include "adImageIndex.h"
+#include "adServer.h"
+#include "adKernelBenchmark.h"
+#include "adPerformance.h"
+#include "adMemory.h"
 #include "adImageUtils.h"
 #include "adRecycleBin.h"
 #include "adExternal.h"
@@ -188,6 +193,15 @@ DLLAPI adError adSearch(adEngineHandle handle)
 	return AD_OK;
 }
 
+DLLAPI adError adWatch(adEngineHandle handle)
+{
+	CHECK_HANDLE CHECK_ACCESS LOCK
+
+	handle->Watch();
+
+	return AD_OK;
+}
+
 template <class TChar> adError Load(adEngineHandle handle, adFileType fileType, const TChar *fileName, adBool check)
 {
 	CHECK_HANDLE CHECK_ACCESS LOCK
@@ -204,6 +218,7 @@ template <class TChar> adError Load(adEngineHandle handle, adFileType fileType,
 	case AD_FILE_MISTAKE_DATA_BASE:
 		return handle->MistakeStorage()->Load(pPath, check != FALSE);
 	case AD_FILE_IMAGE_DATA_BASE:
+		handle->ImageIndex()->Clear();
 		if(check)
 			return handle->ImageDataStorage()->ClearDatabase(pPath);
 		else
@@ -271,6 +286,7 @@ DLLAPI adError adClear(adEngineHandle handle, adFileType fileType)
         handle->MistakeStorage()->Clear();
         break;
     case AD_FILE_IMAGE_DATA_BASE:
+        handle->ImageIndex()->Clear();
         handle->ImageDataStorage()->ClearMemory();
         break;
     case AD_FILE_TEMPORARY:
@@ -439,16 +455,43 @@ DLLAPI adError adStatusGetW(adEngineHandle handle, adThreadType threadType, adSi
     return handle->Status()->Export(threadType, threadId, pStatus);
 }
 
+DLLAPI adError adPerformanceGet(adEngineHandle handle, adPerformanceType performanceType, adPerformancePtr pPerformance)
+{
+    CHECK_HANDLE CHECK_POINTER(pPerformance)
+
+    return ad::TPerformanceCounters::Export(performanceType, pPerformance);
+}
+
+DLLAPI adError adMemoryGet(adEngineHandle handle, adMemoryType memoryType, adMemoryPtr pMemory)
+{
+    CHECK_HANDLE CHECK_POINTER(pMemory)
+
+    return ad::TMemoryCounters::Export(memoryType, pMemory);
+}
+
 DLLAPI adError adResultGetA(adEngineHandle handle, adSizePtr pStartFrom, adResultPtrA pResult, adSizePtr pResultSize)
 {
-    CHECK_HANDLE CHECK_ACCESS LOCK
+    CHECK_HANDLE
+
+    // Во время adWatch движок заблокирован, но новые результаты можно читать по мере появления.
+    adError error = handle->Result()->ExportPublished(pStartFrom, pResult, pResultSize);
+    if(error != AD_ERROR_ACCESS_DENIED)
+        return error;
+
+    CHECK_ACCESS LOCK
 
     return handle->Result()->Export(pStartFrom, pResult, pResultSize);
 }
 
 DLLAPI adError adResultGetW(adEngineHandle handle, adSizePtr pStartFrom, adResultPtrW pResult, adSizePtr pResultSize)
 {
-    CHECK_HANDLE CHECK_ACCESS LOCK
+    CHECK_HANDLE
+
+    adError error = handle->Result()->ExportPublished(pStartFrom, pResult, pResultSize);
+    if(error != AD_ERROR_ACCESS_DENIED)
+        return error;
+
+    CHECK_ACCESS LOCK
 
     return handle->Result()->Export(pStartFrom, pResult, pResultSize);
 }
@@ -633,3 +676,133 @@ DLLAPI adError adLoadBitmapW(adEngineHandle handle, const adCharW* fileName, adB
     return ad::LoadBitmap(fileName, pBitmap, handle->Options());
 }
 
+template <class TChar> adError IndexBuild(adEngineHandle handle, const TChar *path)
+{
+	CHECK_HANDLE CHECK_ACCESS LOCK CHECK_POINTER(path)
+
+	return handle->BuildIndex(ad::TString(path));
+}
+
+DLLAPI adError adIndexBuildA(adEngineHandle handle, const adCharA* path)
+{
+	return IndexBuild(handle, path);
+}
+
+DLLAPI adError adIndexBuildW(adEngineHandle handle, const adCharW* path)
+{
+	return IndexBuild(handle, path);
+}
+
+template <class TChar> adError IndexOpen(adEngineHandle handle, const TChar *path)
+{
+	CHECK_HANDLE CHECK_ACCESS LOCK CHECK_POINTER(path)
+
+	return handle->OpenIndex(ad::TString(path));
+}
+
+DLLAPI adError adIndexOpenA(adEngineHandle handle, const adCharA* path)
+{
+	return IndexOpen(handle, path);
+}
+
+DLLAPI adError adIndexOpenW(adEngineHandle handle, const adCharW* path)
+{
+	return IndexOpen(handle, path);
+}
+
+// Запросы не захватывают блокировку движка и могут выполняться одновременно из нескольких потоков.
+template <class TMatchPtr> adError Query(adEngineHandle handle, const ad::TString & fileName, adSize k, double threshold, TMatchPtr pMatch, adSizePtr pMatchSize)
+{
+	ad::TImageDataPtr pQuery = NULL;
+	adError error = handle->ImageIndex()->Create(fileName, pQuery);
+	if(error == AD_OK)
+	{
+		error = handle->ImageIndex()->Query(pQuery, k, threshold, pMatch, pMatchSize);
+		delete pQuery;
+	}
+	return error;
+}
+
+DLLAPI adError adQueryA(adEngineHandle handle, const adCharA* fileName, adSize k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize)
+{
+	CHECK_HANDLE CHECK_ACCESS CHECK_POINTER(fileName)
+
+	return Query(handle, ad::TString(fileName), k, threshold, pMatch, pMatchSize);
+}
+
+DLLAPI adError adQueryW(adEngineHandle handle, const adCharW* fileName, adSize k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize)
+{
+	CHECK_HANDLE CHECK_ACCESS CHECK_POINTER(fileName)
+
+	return Query(handle, ad::TString(fileName), k, threshold, pMatch, pMatchSize);
+}
+
+template <class TMatchPtr> adError QueryBitmap(adEngineHandle handle, adBitmapPtr pBitmap, adSize k, double threshold, TMatchPtr pMatch, adSizePtr pMatchSize)
+{
+	CHECK_HANDLE CHECK_ACCESS CHECK_POINTER(pBitmap)
+
+	ad::TImageDataPtr pQuery = NULL;
+	adError error = handle->ImageIndex()->Create(*pBitmap, pQuery);
+	if(error == AD_OK)
+	{
+		error = handle->ImageIndex()->Query(pQuery, k, threshold, pMatch, pMatchSize);
+		delete pQuery;
+	}
+	return error;
+}
+
+DLLAPI adError adQueryBitmapA(adEngineHandle handle, adBitmapPtr pBitmap, adSize k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize)
+{
+	return QueryBitmap(handle, pBitmap, k, threshold, pMatch, pMatchSize);
+}
+
+DLLAPI adError adQueryBitmapW(adEngineHandle handle, adBitmapPtr pBitmap, adSize k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize)
+{
+	return QueryBitmap(handle, pBitmap, k, threshold, pMatch, pMatchSize);
+}
+
+template <class TChar> adError Serve(adEngineHandle handle, const TChar *pipeName)
+{
+	CHECK_HANDLE CHECK_ACCESS LOCK CHECK_POINTER(pipeName)
+
+	return handle->Serve(ad::TString(pipeName));
+}
+
+DLLAPI adError adServeA(adEngineHandle handle, const adCharA* pipeName)
+{
+	return Serve(handle, pipeName);
+}
+
+DLLAPI adError adServeW(adEngineHandle handle, const adCharW* pipeName)
+{
+	return Serve(handle, pipeName);
+}
+
+template <class TChar, class TPathPtr> adError ServerBenchmark(const TChar *pipeName, TPathPtr pPath, adSize pathSize, 
+	adSize clientCount, adSize requestCount, adSize batchSize, adServerBenchmarkPtr pBenchmark)
+{
+	CHECK_POINTER(pipeName) CHECK_POINTER(pPath)
+
+	ad::TStrings paths;
+	for(adSize i = 0; i < pathSize; ++i)
+		paths.push_back(ad::TString(pPath[i]));
+	return ad::ServerBenchmark(ad::TString(pipeName), paths, clientCount, requestCount, batchSize, pBenchmark);
+}
+
+DLLAPI adError adServerBenchmarkA(const adCharA* pipeName, adPathPtrA pPath, adSize pathSize, adSize clientCount, adSize requestCount, adSize batchSize, adServerBenchmarkPtr pBenchmark)
+{
+	return ServerBenchmark(pipeName, pPath, pathSize, clientCount, requestCount, batchSize, pBenchmark);
+}
+
+DLLAPI adError adServerBenchmarkW(const adCharW* pipeName, adPathPtrW pPath, adSize pathSize, adSize clientCount, adSize requestCount, adSize batchSize, adServerBenchmarkPtr pBenchmark)
+{
+	return ServerBenchmark(pipeName, pPath, pathSize, clientCount, requestCount, batchSize, pBenchmark);
+}
+
+DLLAPI adError adBenchmarkKernel(adEngineHandle handle, adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark)
+{
+	CHECK_HANDLE CHECK_ACCESS LOCK CHECK_POINTER(pBenchmark)
+
+	return ad::KernelBenchmark(handle, kernelType, minTime, pBenchmark);
+}
+
@@ -136,6 +136,10 @@ extern "C"
 		AD_ERROR_INVALID_GROUP_ID = 31,
 		AD_ERROR_INVALID_SELECTION_TYPE = 32,
 		AD_ERROR_DIRECTORY_IS_NOT_EXIST = 33,
+		AD_ERROR_INDEX_IS_NOT_OPEN = 34,
+		AD_ERROR_INVALID_PERFORMANCE_TYPE = 35,
+		AD_ERROR_INVALID_KERNEL_TYPE = 36,
+		AD_ERROR_INVALID_MEMORY_TYPE = 37,
 	};
     
     enum adPathType : adInt32
@@ -389,6 +393,59 @@ extern "C"
 		AD_COMPARING_SIZE
 	};
 
+	enum adRescanMode : adInt32
+	{
+		AD_RESCAN_FULL = 0, // Все каталоги перечисляются заново.
+		AD_RESCAN_CACHED = 1, // Неизмененные каталоги берутся из кэша, файлы изображений проверяются.
+		AD_RESCAN_TRUST_DIRECTORY_TIME = 2, // Неизмененные каталоги берутся из кэша без проверки файлов.
+		AD_RESCAN_SIZE
+	};
+
+	enum adPerformanceType : adInt32
+	{
+		AD_PERFORMANCE_READ = 0, // Чтение файла в память.
+		AD_PERFORMANCE_DECODE = 1, // Декодирование изображения.
+		AD_PERFORMANCE_COLLECT = 2, // Сбор данных об изображении целиком.
+		AD_PERFORMANCE_COMPARE = 3, // Сравнение изображения с наборами потока сравнения.
+		AD_PERFORMANCE_RESULT = 4, // Добавление пары в результаты.
+		AD_PERFORMANCE_QUERY = 5, // Запрос к индексу.
+		AD_PERFORMANCE_SIZE
+	};
+
+	enum adMemoryType : adInt32
+	{
+		AD_MEMORY_IMAGE_DATA = 0, // Записи TImageData (без уменьшенных изображений).
+		AD_MEMORY_PIXEL_DATA = 1, // Уменьшенные изображения TPixelData.
+		AD_MEMORY_COMPARER = 2, // Наборы сравнивателей.
+		AD_MEMORY_FILE_BUFFER = 3, // Прочитанные, но еще не декодированные файлы.
+		AD_MEMORY_DECODE = 4, // Декодированные изображения.
+		AD_MEMORY_RESULT = 5, // Результаты.
+		AD_MEMORY_IMAGE_INFO = 6, // Сведения об изображениях, на которые ссылаются результаты.
+		AD_MEMORY_UNDO = 7, // Записи очереди отмены.
+		AD_MEMORY_TOTAL = 8, // Сумма по всем подсистемам.
+		AD_MEMORY_SIZE
+	};
+
+	enum adKernelType : adInt32
+	{
+		AD_KERNEL_FILL_FAST = 0, // TPixelData::FillFast.
+		AD_KERNEL_TURN = 1, // TPixelData::Turn.
+		AD_KERNEL_MIRROR = 2, // TPixelData::Mirror.
+		AD_KERNEL_DUPL_PAIR = 3, // TImageComparer::IsDuplPair для пары, проходящей быструю проверку.
+		AD_KERNEL_DUPL_PAIR_SSIM = 4, // TImageComparer_SSIM::IsDuplPair.
+		AD_KERNEL_INDEX_3D = 5, // TImageComparer_3D::GetIndex.
+		AD_KERNEL_BLOCKINESS = 6, // TDataCollector::GetBlockiness.
+		AD_KERNEL_PATH_FILTER = 7, // TPathFilter::IsWanted, IsIgnored и IsIgnoredParent для пути файла.
+		AD_KERNEL_SIZE
+	};
+
+	enum adSimdType : adInt32
+	{
+		AD_SIMD_SSE41 = 1,
+		AD_SIMD_AVX2 = 2,
+		AD_SIMD_AVX512BW = 4,
+	};
+
     /*------------Structures-----------------------------------------------------*/
 
     struct adSearchOptions
@@ -412,6 +469,7 @@ extern "C"
         adBool HEIF;
         adBool AVIF;
         adBool JXL;
+        adRescanMode rescanMode;
     };
     typedef adSearchOptions* adSearchOptionsPtr;
 
@@ -428,6 +486,8 @@ extern "C"
         adBool compareInsideOneFolder;
 		adBool compareInsideOneSearchPath;
 		adAlgorithmComparing algorithmComparing;
+		adInt32 nearestCount; // если больше 0, для каждого изображения остается не больше nearestCount ближайших пар
+		adInt32 clusterThreshold; // если больше 0, изображения, отличающиеся не больше чем на clusterThreshold, объединяются в кластер
     };
     typedef adCompareOptions* adCompareOptionsPtr;
 	
@@ -454,6 +514,10 @@ extern "C"
         adInt32 resultCountMax;        
         adInt32 ignoreFrameWidth;
         adBool useLibJpegTurbo;
+        adBool useThumbnails;
+        adBool performanceCounters; // счетчики производительности общие для всех движков процесса
+        adBool trace; // по окончании поиска в каталог пользователя пишется trace.json
+        adInt32 memoryLimit; // мегабайты, 0 - без ограничения; чтение файлов приостанавливается, пока прочитанные, но не обработанные файлы движка занимают больше, а при превышении общей памяти процесса (AD_MEMORY_TOTAL) файлы читаются по мере разбора очередей сбора
     };
     typedef adAdvancedOptions* adAdvancedOptionsPtr;
 
@@ -471,9 +535,41 @@ extern "C"
         adSize renamedImageNumber;
         adSize deletedImageNumber;
         adUInt64 deletedImageSize;
+        // Показатели стадий поиска. Время суммируется по всем потокам, в миллисекундах.
+        adUInt64 readSize; // байты, прочитанные с диска потоком поиска
+        double readTime;
+        adSize decodedImageNumber[AD_IMAGE_SIZE]; // по форматам, AD_IMAGE_NONE - неудачное декодирование
+        double decodeTime[AD_IMAGE_SIZE];
+        double reduceTime; // построение уменьшенного изображения
+        adUInt64 visitedCandidateNumber; // пары, проверенные при сравнении
+        adUInt64 prunedCandidateNumber; // отброшенные быстрой проверкой
+        adUInt64 mainComparisonNumber; // полные сравнения уменьшенных изображений
+        adSize collectQueueSize; // сумма очередей потоков сбора
+        adSize collectQueueSizeMax;
+        adSize compareQueueSize; // наибольшая из очередей потоков сравнения
+        adSize compareQueueSizeMax;
     };
     typedef adStatistic* adStatisticPtr;
 
+#define AD_PERFORMANCE_HISTOGRAM_SIZE 32
+
+    struct adPerformance
+    {
+        adUInt64 count;
+        double total; // миллисекунды
+        double min;
+        double max;
+        adUInt64 histogram[AD_PERFORMANCE_HISTOGRAM_SIZE]; // 0 - меньше 1 мкс, i - от 2^(i-1) до 2^i мкс
+    };
+    typedef adPerformance* adPerformancePtr;
+
+    struct adMemory
+    {
+        adUInt64 current; // байты
+        adUInt64 peak; // с начала последнего поиска
+    };
+    typedef adMemory* adMemoryPtr;
+
     struct adStatusA
     {
         adStateType state;
@@ -597,6 +693,44 @@ extern "C"
     };
     typedef adBitmap* adBitmapPtr;
 
+    struct adMatchA
+    {
+        adImageInfoA image;
+        double difference;
+        adTransformType transform;
+    };
+    typedef adMatchA* adMatchPtrA;
+
+    struct adMatchW
+    {
+        adImageInfoW image;
+        double difference;
+        adTransformType transform;
+    };
+    typedef adMatchW* adMatchPtrW;
+
+    struct adServerBenchmark
+    {
+        adSize requestCount;
+        adSize errorCount; // включая запросы клиентов, не сумевших подключиться
+        double throughput; // изображений в секунду
+        double latencyP50; // миллисекунды, только по отправленным запросам
+        double latencyP99;
+        double latencyMax;
+    };
+    typedef adServerBenchmark* adServerBenchmarkPtr;
+
+    struct adKernelBenchmark
+    {
+        adSize reducedImageSize;
+        adInt32 simd; // флаги adSimdType, доступные процессору
+        adSize count; // число вызовов
+        double total; // миллисекунды
+        double average; // наносекунды на вызов
+        double min; // наносекунды на вызов в лучшем из проходов
+    };
+    typedef adKernelBenchmark* adKernelBenchmarkPtr;
+
     /*------------Functions-------------------------------------------------------*/
 
     DLLAPI adError adVersionGet(adVersionType versionType, adCharA * pVersion, adSizePtr pVersionSize);
@@ -607,6 +741,7 @@ extern "C"
 
 	DLLAPI adError adStop(adEngineHandle handle);
     DLLAPI adError adSearch(adEngineHandle handle);
+    DLLAPI adError adWatch(adEngineHandle handle);
 
     DLLAPI adError adLoadA(adEngineHandle handle, adFileType fileType, const adCharA* fileName, adBool check);
     DLLAPI adError adLoadW(adEngineHandle handle, adFileType fileType, const adCharW* fileName, adBool check);
@@ -630,7 +765,10 @@ extern "C"
     DLLAPI adError adStatisticGet(adEngineHandle handle, adStatisticPtr pStatistic);
     DLLAPI adError adStatusGetA(adEngineHandle handle, adThreadType threadType, adSize threadId, adStatusPtrA pStatus);
     DLLAPI adError adStatusGetW(adEngineHandle handle, adThreadType threadType, adSize threadId, adStatusPtrW pStatus);
+    DLLAPI adError adPerformanceGet(adEngineHandle handle, adPerformanceType performanceType, adPerformancePtr pPerformance);
+    DLLAPI adError adMemoryGet(adEngineHandle handle, adMemoryType memoryType, adMemoryPtr pMemory);
 
+    // Во время adWatch (из другого потока) возвращает результаты, найденные к этому моменту.
     DLLAPI adError adResultGetA(adEngineHandle handle, adSizePtr pStartFrom, adResultPtrA pResult, adSizePtr pResultSize);
     DLLAPI adError adResultGetW(adEngineHandle handle, adSizePtr pStartFrom, adResultPtrW pResult, adSizePtr pResultSize);
     DLLAPI adError adResultSort(adEngineHandle handle, adSortType sortType, adBool increasing);
@@ -659,6 +797,22 @@ extern "C"
     DLLAPI adError adLoadBitmapA(adEngineHandle handle, const adCharA* fileName, adBitmapPtr pBitmap);
     DLLAPI adError adLoadBitmapW(adEngineHandle handle, const adCharW* fileName, adBitmapPtr pBitmap);
 
+    DLLAPI adError adIndexBuildA(adEngineHandle handle, const adCharA* path);
+    DLLAPI adError adIndexBuildW(adEngineHandle handle, const adCharW* path);
+    DLLAPI adError adIndexOpenA(adEngineHandle handle, const adCharA* path);
+    DLLAPI adError adIndexOpenW(adEngineHandle handle, const adCharW* path);
+    DLLAPI adError adQueryA(adEngineHandle handle, const adCharA* fileName, adSize k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize);
+    DLLAPI adError adQueryW(adEngineHandle handle, const adCharW* fileName, adSize k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize);
+    DLLAPI adError adQueryBitmapA(adEngineHandle handle, adBitmapPtr pBitmap, adSize k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize);
+    DLLAPI adError adQueryBitmapW(adEngineHandle handle, adBitmapPtr pBitmap, adSize k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize);
+
+    DLLAPI adError adServeA(adEngineHandle handle, const adCharA* pipeName);
+    DLLAPI adError adServeW(adEngineHandle handle, const adCharW* pipeName);
+    DLLAPI adError adServerBenchmarkA(const adCharA* pipeName, adPathPtrA pPath, adSize pathSize, adSize clientCount, adSize requestCount, adSize batchSize, adServerBenchmarkPtr pBenchmark);
+    DLLAPI adError adServerBenchmarkW(const adCharW* pipeName, adPathPtrW pPath, adSize pathSize, adSize clientCount, adSize requestCount, adSize batchSize, adServerBenchmarkPtr pBenchmark);
+
+    DLLAPI adError adBenchmarkKernel(adEngineHandle handle, adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark);
+
     /*------------Unicode/Ansi defines-------------------------------------------*/
 
 #ifdef UNICODE
@@ -672,6 +826,8 @@ extern "C"
     typedef adImageInfoPtrW adImageInfoPtr;
     typedef adResultW adResult; 
     typedef adResultPtrW adResultPtr;
+    typedef adMatchW adMatch;
+    typedef adMatchPtrW adMatchPtr;
 
 #define adCreate adCreateW
 #define adLoad adLoadW
@@ -683,6 +839,12 @@ extern "C"
 #define adRenameCurrent adRenameCurrentW
 #define adImageInfoGet adImageInfoGetW
 #define adLoadBitmap adLoadBitmapW
+#define adIndexBuild adIndexBuildW
+#define adIndexOpen adIndexOpenW
+#define adQuery adQueryW
+#define adQueryBitmap adQueryBitmapW
+#define adServe adServeW
+#define adServerBenchmark adServerBenchmarkW
 
 #else/*UNICODE*/
 
@@ -695,6 +857,8 @@ extern "C"
     typedef adImageInfoPtrA adImageInfoPtr;
     typedef adResultA adResult; 
     typedef adResultPtrA adResultPtr;
+    typedef adMatchA adMatch;
+    typedef adMatchPtrA adMatchPtr;
 
 #define adCreate adCreateA
 #define adLoad adLoadA
@@ -706,6 +870,12 @@ extern "C"
 #define adRenameCurrent adRenameCurrentA
 #define adImageInfoGet adImageInfoGetA
 #define adLoadBitmap adLoadBitmapA
+#define adIndexBuild adIndexBuildA
+#define adIndexOpen adIndexOpenA
+#define adQuery adQueryA
+#define adQueryBitmap adQueryBitmapA
+#define adServe adServeA
+#define adServerBenchmark adServerBenchmarkA
 
 #endif/*UNICODE*/
 
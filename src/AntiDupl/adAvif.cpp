@@ -48,91 +48,80 @@ namespace ad
 		return false;
 	}
 
+	// Декодер переиспользуется в пределах потока: avifDecoderSetIOMemory сбрасывает его состояние перед разбором нового файла.
+	struct AvifContext
+	{
+		AvifContext()
+		{
+			decoder = avifDecoderCreate();
+		}
+
+		~AvifContext()
+		{
+			if (decoder)
+				avifDecoderDestroy(decoder);
+		}
+
+		avifDecoder* decoder;
+	};
+
+	thread_local AvifContext avifContext;
+
 	TAvif* TAvif::Load(HGLOBAL hGlobal)
 	{
 		AD_FUNCTION_PERFORMANCE_TEST
 
 		TAvif* pAvif = NULL;
-		if (hGlobal)
+		if (hGlobal && avifContext.decoder)
 		{
 			uint8_t* data = (uint8_t*)::GlobalLock(hGlobal);
 			size_t data_size = ::GlobalSize(hGlobal);
 
-			avifDecoder* decoder = avifDecoderCreate();
+			avifDecoder* decoder = avifContext.decoder;
 
 			avifResult result = avifDecoderSetIOMemory(decoder, data, data_size);
-			if (result != AVIF_RESULT_OK)
+			if (result == AVIF_RESULT_OK)
+				result = avifDecoderParse(decoder);
+			if (result == AVIF_RESULT_OK)
+				result = avifDecoderNextImage(decoder);
+			if (result == AVIF_RESULT_OK)
 			{
-				avifDecoderDestroy(decoder);
-#ifdef AD_LOGGER_ENABLE
-				AD_LOG(avifResultToString(result));
-#endif//AD_LOGGER_ENABLE
-				return NULL;
+				avifRGBImage bgra_image;
+				memset(&bgra_image, 0, sizeof(bgra_image));
+
+				avifRGBImageSetDefaults(&bgra_image, decoder->image);
+				bgra_image.format = AVIF_RGB_FORMAT_BGRA;
+				bgra_image.depth = 8;
+
+				// Конвертируем сразу в буфер результата, без промежуточного буфера и копирования.
+				TView* pView_BGRA = new TView(bgra_image.width, bgra_image.height, TView::Bgra32);
+				bgra_image.pixels = pView_BGRA->data;
+				bgra_image.rowBytes = (uint32_t)pView_BGRA->stride;
+
+				AD_PERFORMANCE_TEST_SET_SIZE(bgra_image.width * bgra_image.height)
+
+				result = avifImageYUVToRGB(decoder->image, &bgra_image);
+				if (result == AVIF_RESULT_OK)
+				{
+					pAvif = new TAvif();
+					pAvif->m_pView = pView_BGRA;
+					pAvif->m_format = TImage::Avif;
+				}
+				else
+				{
+					delete pView_BGRA;
+				}
 			}
 
-			result = avifDecoderParse(decoder);
-			if (result != AVIF_RESULT_OK)
-			{
-				avifDecoderDestroy(decoder);
 #ifdef AD_LOGGER_ENABLE
-				AD_LOG(avifResultToString(result));
-#endif//AD_LOGGER_ENABLE
-				return NULL;
-			}
-
-			result = avifDecoderNextImage(decoder);
 			if (result != AVIF_RESULT_OK)
-			{
-				avifDecoderDestroy(decoder);
-#ifdef AD_LOGGER_ENABLE
 				AD_LOG(avifResultToString(result));
 #endif//AD_LOGGER_ENABLE
-				return NULL;
-			}
-
-
-			avifRGBImage bgra_image;
-			memset(&bgra_image, 0, sizeof(bgra_image));
-
-			avifRGBImageSetDefaults(&bgra_image, decoder->image);
-			bgra_image.format = AVIF_RGB_FORMAT_BGRA;
-			bgra_image.depth = 8;
 
-			avifRGBImageAllocatePixels(&bgra_image);
-
-			result = avifImageYUVToRGB(decoder->image, &bgra_image);
-			if (result != AVIF_RESULT_OK)
-			{
-				avifRGBImageFreePixels(&bgra_image);
-				avifDecoderDestroy(decoder);
-#ifdef AD_LOGGER_ENABLE
-				AD_LOG(avifResultToString(result));
-#endif//AD_LOGGER_ENABLE
-				return NULL;
-
-			}
+			// Отвязываем декодер от данных, которые будут освобождены вместе с hGlobal.
+			avifDecoderSetIOMemory(decoder, NULL, 0);
 			::GlobalUnlock(hGlobal);
-
-			TView* pView_BGRA = new TView(bgra_image.width, bgra_image.height, bgra_image.rowBytes, TView::Bgra32, NULL);
-
-			AD_PERFORMANCE_TEST_SET_SIZE(bgra_image.width * bgra_image.height)
-
-			if (pView_BGRA)
-			{
-				memcpy(pView_BGRA->data, bgra_image.pixels, bgra_image.height * bgra_image.rowBytes);
-				pAvif = new TAvif();
-				pAvif->m_pView = pView_BGRA;
-				pAvif->m_format = TImage::Avif;
-			}
-			else
-			{
-				delete pView_BGRA;
-			}
-
-			avifRGBImageFreePixels(&bgra_image);
-			avifDecoderDestroy(decoder);
-			return pAvif;
 		}
-		return NULL;
+		return pAvif;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adImageData.h"
+#include "adResultStorage.h"
+#include "adCluster.h"
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+    TClusters::TClusters(double threshold)
+        :m_threshold(threshold)
+    {
+    }
+
+	// Возвращает false, если отличие больше порога кластеризации и пару нужно обработать как обычно.
+    bool TClusters::Join(TImageDataPtr pImageData, TImageDataPtr pRepresentative, double difference, adTransformType transform)
+    {
+        if(difference > m_threshold)
+            return false;
+
+        TMember member;
+        member.representative = pRepresentative;
+        member.difference = difference;
+        member.transform = transform;
+        Join(pImageData, member);
+        return true;
+    }
+
+    bool TClusters::Joined(TImageDataPtr pImageData) const
+    {
+        return m_map.find(pImageData) != m_map.end();
+    }
+
+	// Изображение сравнивается только с ранее добавленными, поэтому ссылки на представителей 
+	// не образуют циклов. Изображение, ставшее представителем в одном потоке, может оказаться 
+	// членом кластера другого потока - так кластеры разных потоков связываются в одну группу.
+    void TClusters::Merge(const TClusters & clusters)
+    {
+        for(TMap::const_iterator it = clusters.m_map.begin(); it != clusters.m_map.end(); ++it)
+            Join(it->first, it->second);
+    }
+
+    void TClusters::Export(TResultStorage *pResult) const
+    {
+        for(TMap::const_iterator it = m_map.begin(); it != m_map.end(); ++it)
+            pResult->AddDuplImagePair(it->first, it->second.representative, it->second.difference, it->second.transform);
+    }
+
+	// Из нескольких подходящих представителей остается ближайший.
+    void TClusters::Join(TImageDataPtr pImageData, const TMember & member)
+    {
+        TMap::iterator it = m_map.find(pImageData);
+        if(it == m_map.end())
+            m_map[pImageData] = member;
+        else if(member.difference < it->second.difference)
+            it->second = member;
+    }
+    //-------------------------------------------------------------------------
+}
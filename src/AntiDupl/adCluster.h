@@ -0,0 +1,64 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adCluster_h__
+#define __adCluster_h__
+
+#include "adConfig.h"
+
+namespace ad
+{
+    struct TImageData;
+    class TResultStorage;
+    typedef TImageData* TImageDataPtr;
+    //-------------------------------------------------------------------------
+	// Кластеры почти одинаковых изображений. Изображение, отличающееся от уже добавленного 
+	// представителя не больше чем на порог, становится членом его кластера и само в набор 
+	// сравниваемых не добавляется. Вместо всех пар кластера выдаются пары член-представитель.
+	// Один экземпляр используется одним потоком, общий результат собирается через Merge.
+    class TClusters
+    {
+        struct TMember
+        {
+            TImageDataPtr representative;
+            double difference;
+            adTransformType transform;
+        };
+        typedef std::map<TImageDataPtr, TMember> TMap;
+    public:
+        TClusters(double threshold);
+
+        bool Join(TImageDataPtr pImageData, TImageDataPtr pRepresentative, double difference, adTransformType transform);
+        bool Joined(TImageDataPtr pImageData) const;
+        void Merge(const TClusters & clusters);
+        void Export(TResultStorage *pResult) const;
+
+    private:
+        void Join(TImageDataPtr pImageData, const TMember & member);
+
+        double m_threshold;
+        TMap m_map;
+    };
+    //-------------------------------------------------------------------------
+}
+#endif//__adCluster_h__
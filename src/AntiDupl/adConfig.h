@@ -81,6 +81,14 @@ namespace ad
     typedef Simd::View<Simd::Allocator> TView;
 	typedef Simd::Point<ptrdiff_t> TPoint;
 
+    // Способ, которым было получено изображение для построения эскиза.
+    enum TDecodeMode
+    {
+        DECODE_MODE_FULL = 0, // полное разрешение
+        DECODE_MODE_REDUCED = 1, // отброшены уровни разрешения, не нужные для эскиза (JPEG 2000)
+        DECODE_MODE_THUMBNAIL = 2, // встроенный эскиз или прогрессивный проход (JPEG XL, HEIF, PSD)
+    };
+
     //-------------------------------------------------------------------------
 
     const TUInt32 DENOMINATOR = 100;
@@ -98,13 +106,16 @@ namespace ad
     const TUInt32 D3_THRESHOLD_DIFFERENCE_MAX = TUInt32(DENOMINATOR*0.100);
     const TUInt32 D3_MAX_RANGES_STEP = TUInt32(DENOMINATOR*0.010);
     const TUInt32 INITIAL_REDUCED_IMAGE_SIZE = 256;
+    const size_t GRAY_BUFFER_SIZE_MAX = 4096*4096; // полутоновый буфер потока сбора
+    const size_t DEFECT_ANALYSIS_SIZE_MAX = 1024; // наибольшая сторона изображения для оценки блочности и размытия
     const TUInt32 REDUCED_IMAGE_SIZE_MIN = 16;
     const TUInt32 COLLECT_THREAD_QUEUE_SIZE_MAX = 16;
     const TUInt32 DEAFAULT_THREAD_SLEEP_INTERVAL = 10;
     const TUInt32 LARGE_IMAGE_COLLECTION_SIZE_MIN = 100000;
+    const size_t WATCH_IMAGE_COUNT_MAX = 0x400000; // при наблюдении за каталогами больше изображений не принимается
 
 	const size_t IMAGE_DATA_FILE_SIZE_MAX = 0x10000;
-	const TUInt32 FILE_VERSION = 4;
+	const TUInt32 FILE_VERSION = 6;
 	const size_t SIZE_CHECK_LIMIT = 2147483646; //string.max_size()
 
 	const size_t BLOCKINESS_SIZE = 8;
@@ -22,6 +22,7 @@
 * SOFTWARE.
 */
 #include "adPerformance.h"
+#include "adTracer.h"
 #include "adEngine.h"
 #include "adImageData.h"
 #include "adOptions.h"
@@ -37,7 +38,21 @@ namespace ad
 {
     TDataCollector::TDataCollector(TEngine *pEngine)
         :m_pOptions(pEngine->Options()),
-        m_pResult(pEngine->Result())
+        m_pResult(pEngine->Result()),
+        m_pStatus(pEngine->Status())
+    {
+        Init();
+    }
+
+    TDataCollector::TDataCollector(TOptions *pOptions)
+        :m_pOptions(pOptions),
+        m_pResult(NULL),
+        m_pStatus(NULL)
+    {
+        Init();
+    }
+
+    void TDataCollector::Init()
     {
         for(int size = INITIAL_REDUCED_IMAGE_SIZE; size > m_pOptions->advanced.reducedImageSize; size >>= 1)
 			m_pGrayBuffers.push_back(new TView(size, size, size, TView::Gray8, NULL));
@@ -53,6 +68,7 @@ namespace ad
     void TDataCollector::Fill(TImageData* pImageData)
     {
         AD_FUNCTION_PERFORMANCE_TEST
+        AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_COLLECT)
         if(!pImageData->crc32c)
             SetCrc32c(pImageData);
         if(pImageData->PixelDataFillingNeed(m_pOptions))
@@ -60,24 +76,71 @@ namespace ad
         if(pImageData->DefectCheckingNeed(m_pOptions))
             CheckOnDefect(pImageData);
 		TDefectType defect = pImageData->GetDefect(m_pOptions);
-        if(defect > AD_DEFECT_NONE)
+        if(defect > AD_DEFECT_NONE && m_pResult)
             m_pResult->AddDefectImage(pImageData, defect);
         pImageData->FillOther(m_pOptions);
         pImageData->FreeGlobal();
     }
 
+	// Заполнение из изображения в памяти, у которого нет файла: контрольная сумма и проверка на дефекты не выполняются.
+    void TDataCollector::Fill(TImageData* pImageData, const TView & view)
+    {
+        AD_FUNCTION_PERFORMANCE_TEST
+        pImageData->width = (TUInt32)view.width;
+        pImageData->height = (TUInt32)view.height;
+        pImageData->type = AD_IMAGE_BMP;
+        pImageData->crc32c = -1;
+
+        if(m_grayBuffer.size() < view.width*view.height)
+            m_grayBuffer.resize(view.width*view.height);
+        TView gray(view.width, view.height, view.width, TView::Gray8, m_grayBuffer.data());
+        Simd::BgraToGray(view, gray);
+        FillReducedData(pImageData, gray);
+        pImageData->data->decodeMode = DECODE_MODE_FULL;
+        pImageData->FillOther(m_pOptions);
+    }
+
 	// Заполняем переданный TImageData из TImage хранящейся в глобальном хуке pImageData, создание уменьшенного изображения
     void TDataCollector::FillPixelData(TImageData* pImageData)
     {
         AD_FUNCTION_PERFORMANCE_TEST
-        TImage *pImage = TImage::Load(pImageData->hGlobal, m_pOptions);
+        AD_TRACE("FillPixelData")
+        // Для оценки блочности нужна сетка 8x8 исходного изображения, поэтому оно декодируется в полном разрешении. 
+        // Для оценки размытия достаточно копии со стороной не меньше DEFECT_ANALYSIS_SIZE_MAX. Иначе уменьшенное 
+        // изображение и эскиз должны быть не меньше INITIAL_REDUCED_IMAGE_SIZE, до которого FillReducedData 
+        // масштабирует изображение, чтобы не было увеличения.
+        size_t reducedSize = INITIAL_REDUCED_IMAGE_SIZE;
+        size_t thumbnailSize = INITIAL_REDUCED_IMAGE_SIZE;
+        if(m_pOptions->defect.checkOnBlockiness == TRUE)
+            reducedSize = thumbnailSize = 0;
+        else if(m_pOptions->defect.checkOnBlurring == TRUE)
+            reducedSize = thumbnailSize = DEFECT_ANALYSIS_SIZE_MAX;
+        double start = Time();
+        TImage *pImage = TImage::Load(pImageData->hGlobal, m_pOptions, reducedSize, thumbnailSize);
+        if(m_pStatus)
+            m_pStatus->Decode(pImage ? (TImageType)pImage->Format() : AD_IMAGE_NONE, Time() - start);
         if(pImage)
         {
-            pImageData->height = (TUInt32)pImage->View()->height; 
-            pImageData->width = (TUInt32)pImage->View()->width;
+            pImageData->height = (TUInt32)pImage->OriginalSize().y; 
+            pImageData->width = (TUInt32)pImage->OriginalSize().x;
             pImageData->type = (TImageType)pImage->Format();
 
-			TView gray(pImage->View()->width, pImage->View()->height, TView::Gray8, NULL);
+			// Буфер потока растет не больше GRAY_BUFFER_SIZE_MAX, для изображений крупнее память выделяется на одно изображение.
+			size_t width = pImage->View()->width, height = pImage->View()->height;
+			std::vector<TUInt8> oversized;
+			TUInt8 *pGray;
+			if(width*height <= GRAY_BUFFER_SIZE_MAX)
+			{
+				if(m_grayBuffer.size() < width*height)
+					m_grayBuffer.resize(width*height);
+				pGray = m_grayBuffer.data();
+			}
+			else
+			{
+				oversized.resize(width*height);
+				pGray = oversized.data();
+			}
+			TView gray(width, height, width, TView::Gray8, pGray);
             if (pImage->View()->format == TView::Format::Rgb24)
             {
                 Simd::RgbToGray(*pImage->View(), gray);
@@ -91,20 +154,16 @@ namespace ad
                 Simd::BgraToGray(*pImage->View(), gray);
             }
 
-			pImageData->blockiness = GetBlockiness(gray);
+			if(m_pOptions->defect.checkOnBlockiness == TRUE)
+				pImageData->blockiness = GetBlockiness(gray);
 
-			TBlurringDetector blurringDetector;
-			pImageData->blurring = blurringDetector.Detect(gray);
+			if(m_pOptions->defect.checkOnBlurring == TRUE)
+				pImageData->blurring = GetBlurring(gray, double(pImageData->width)/double(width));
 
 			pImageData->imageExif = pImage->ImageExif();
 
-			Simd::Resize(gray, *m_pGrayBuffers.front());
-            for(size_t i = 1; i < m_pGrayBuffers.size(); ++i)
-				Simd::ReduceGray2x2(*m_pGrayBuffers[i - 1], *m_pGrayBuffers[i]);
-			TPixelData & data = *pImageData->data;
-            TView reducedView(data.side, data.side, data.side, TView::Gray8, data.main);
-            ReduceGray2x2(*m_pGrayBuffers.back(), reducedView);
-            data.filled = true;
+            FillReducedData(pImageData, gray);
+            pImageData->data->decodeMode = pImage->DecodeMode();
 
 			delete pImage;
         }
@@ -116,6 +175,21 @@ namespace ad
         }
     }
 
+	// Построение уменьшенного изображения для сравнения из полутонового
+    void TDataCollector::FillReducedData(TImageData* pImageData, const TView & gray)
+    {
+        double start = Time();
+        Simd::Resize(gray, *m_pGrayBuffers.front());
+        for(size_t i = 1; i < m_pGrayBuffers.size(); ++i)
+            Simd::ReduceGray2x2(*m_pGrayBuffers[i - 1], *m_pGrayBuffers[i]);
+        TPixelData & data = *pImageData->data;
+        TView reducedView(data.side, data.side, data.side, TView::Gray8, data.main);
+        ReduceGray2x2(*m_pGrayBuffers.back(), reducedView);
+        data.filled = true;
+        if(m_pStatus)
+            m_pStatus->Reduce(Time() - start);
+    }
+
     void TDataCollector::CheckOnDefect(TImageData* pImageData)
     {
         if(pImageData->type == AD_IMAGE_NONE || pImageData->hGlobal == NULL)
@@ -171,12 +245,20 @@ namespace ad
 		if(gray.height < BLOCKINESS_SIZE + 1 || gray.width < BLOCKINESS_SIZE + 1)
 			return 0;
 
-		std::vector<unsigned int> rowSums(gray.height);
-		Simd::GetAbsDyRowSums(gray, &rowSums[0]);
+		// Масштабирование разрушает сетку 8x8, поэтому большие изображения обрезаем по центру, 
+		// сохраняя выравнивание по границе блока. Оценка - отношение сумм по фазам сетки, от размера она не зависит.
+		size_t width = std::min<size_t>(gray.width, DEFECT_ANALYSIS_SIZE_MAX + 1);
+		size_t height = std::min<size_t>(gray.height, DEFECT_ANALYSIS_SIZE_MAX + 1);
+		size_t left = (gray.width - width)/2/BLOCKINESS_SIZE*BLOCKINESS_SIZE;
+		size_t top = (gray.height - height)/2/BLOCKINESS_SIZE*BLOCKINESS_SIZE;
+		TView region = gray.Region(left, top, left + width, top + height);
+
+		std::vector<unsigned int> rowSums(region.height);
+		Simd::GetAbsDyRowSums(region, &rowSums[0]);
 		double verticalBlockiness = GetBlockiness(rowSums);
 
-		std::vector<unsigned int> colSums(gray.width);
-		Simd::GetAbsDxColSums(gray, &colSums[0]);
+		std::vector<unsigned int> colSums(region.width);
+		Simd::GetAbsDxColSums(region, &colSums[0]);
 		double horizontalBlockiness = GetBlockiness(colSums);
 
 		return std::min(verticalBlockiness, horizontalBlockiness);
@@ -191,4 +273,33 @@ namespace ad
 		std::sort(block.rbegin(), block.rend());
 		return double(block[0] - block[1])/double(block[0] + block[1])*100.0;
 	}
+
+	// Детектор размытия работает с пирамидой уменьшенных в 2 раза изображений, поэтому большое изображение 
+	// заранее уменьшаем в 2^n раз до размера не более DEFECT_ANALYSIS_SIZE_MAX. scale - во сколько раз 
+	// переданное изображение уже уменьшено декодером.
+	double TDataCollector::GetBlurring(const TView & gray, double scale)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+
+		TBlurringDetector blurringDetector;
+		TView reduced[2];
+		const TView * pSrc = &gray;
+		for(size_t i = 0; pSrc->width > DEFECT_ANALYSIS_SIZE_MAX || pSrc->height > DEFECT_ANALYSIS_SIZE_MAX; ++i)
+		{
+			TView & dst = reduced[i&1];
+			dst.Recreate((pSrc->width + 1) >> 1, (pSrc->height + 1) >> 1, TView::Gray8);
+			Simd::ReduceGray2x2(*pSrc, dst);
+			pSrc = &dst;
+			scale *= 2.0;
+		}
+		double radius = blurringDetector.Detect(*pSrc);
+		if(scale <= 1.0 || radius <= 1.0)
+			return radius;
+
+		// Радиус меньше одного пикселя детектор не различает, а уменьшение само размывает изображение на пиксель 
+		// копии. Поэтому радиус в пикселях оригинала восстанавливаем вычитанием этого пикселя в квадратуре: 
+		// резкое изображение (радиус 1 на копии) получает радиус 1, как и в полном разрешении, и порог 
+		// BlurringThreshold сохраняет смысл, а не срабатывает на любом изображении больше 4*DEFECT_ANALYSIS_SIZE_MAX.
+		return ::sqrt(scale*scale*(radius*radius - 1.0) + 1.0);
+	}
 }
@@ -35,25 +35,35 @@ namespace ad
     struct TPixelData; 
     class TEngine;
     class TResultStorage;
+    class TStatus;
     //-------------------------------------------------------------------------
     class TDataCollector
     {
         TOptions *m_pOptions;
         TResultStorage *m_pResult;
+        TStatus *m_pStatus;
         std::vector<TView*> m_pGrayBuffers;
+        std::vector<TUInt8> m_grayBuffer; // переиспользуется для всех изображений, обрабатываемых потоком
+
+        friend class TKernelBenchmark;
 
     public:
         TDataCollector(TEngine *pEngine);
+        TDataCollector(TOptions *pOptions); // без добавления дефектных изображений в результаты и статистики
         ~TDataCollector();
 
         void Fill(TImageData* pImageData);
+        void Fill(TImageData* pImageData, const TView & view); // из уже декодированного изображения
 
     private:
+        void Init();
         void FillPixelData(TImageData* pImageData);
+        void FillReducedData(TImageData* pImageData, const TView & gray);
         void CheckOnDefect(TImageData* pImageData);
         void SetCrc32c(TImageData* pImageData);
 		double GetBlockiness(const TView & gray);
 		double GetBlockiness(const std::vector<unsigned int> & sums);
+		double GetBlurring(const TView & gray, double scale);
 	};
 }
 #endif//__adDataCollector_h__ 
\ No newline at end of file
@@ -0,0 +1,246 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adFileUtils.h"
+#include "adFileStream.h"
+#include "adDirectoryCache.h"
+
+namespace ad
+{
+	const TChar DIRECTORY_CACHE_FILE_NAME[] = TEXT("directory.adi");
+	const char DIRECTORY_CACHE_CONTROL_BYTES[] = "adid"; // "adic" - без набора расширений
+	const size_t DIRECTORY_CACHE_RECORD_SIZE_MAX = 0x40000000;
+	const size_t DIRECTORY_CACHE_ENTRY_SIZE_MIN = 2*sizeof(TUInt32) + 2*sizeof(TUInt64);
+
+	template <class T> static inline T Read(const TUInt8 *& p, const TUInt8 *end)
+	{
+		if(size_t(end - p) < sizeof(T))
+			throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+		T t;
+		memcpy(&t, p, sizeof(T));
+		p += sizeof(T);
+		return t;
+	}
+
+	template <class T> static inline void Write(std::vector<TUInt8> & buffer, const T & t)
+	{
+		buffer.insert(buffer.end(), (const TUInt8*)&t, (const TUInt8*)(&t + 1));
+	}
+
+	TDirectoryCache::TDirectoryCache()
+		: m_changed(false)
+	{
+	}
+
+	bool TDirectoryCache::Get(const TString & directory, TUInt64 time, TEntries & entries)
+	{
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		TListings::iterator it = m_listings.find(Key(directory));
+		if(it == m_listings.end() || it->second.time != time)
+			return false;
+		it->second.visited = true;
+		entries = it->second.entries;
+		return true;
+	}
+
+	void TDirectoryCache::Set(const TString & directory, TUInt64 time, const TEntries & entries)
+	{
+		TListing listing;
+		listing.time = time;
+		listing.count = (TUInt32)entries.size();
+		listing.nameHash = NameHash(entries);
+		listing.entries = entries;
+
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		TListing & stored = m_listings[Key(directory)];
+		if(stored.time != listing.time || stored.count != listing.count || stored.nameHash != listing.nameHash)
+			m_changed = true;
+		stored.time = listing.time;
+		stored.count = listing.count;
+		stored.nameHash = listing.nameHash;
+		stored.entries.swap(listing.entries);
+		stored.visited = true;
+	}
+
+	void TDirectoryCache::SetExtensions(const TStrings & extensions)
+	{
+		TString key;
+		for(size_t i = 0; i < extensions.size(); ++i)
+		{
+			TString extension(extensions[i]);
+			extension.ToUpper();
+			key += extension;
+			key += TEXT('|');
+		}
+
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		if(key == m_extensions)
+			return;
+		m_extensions = key;
+		m_changed = true;
+		m_listings.clear();
+	}
+
+	void TDirectoryCache::Prune()
+	{
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		for(TListings::iterator it = m_listings.begin(); it != m_listings.end();)
+		{
+			if(it->second.visited)
+			{
+				it->second.visited = false;
+				++it;
+			}
+			else
+			{
+				it = m_listings.erase(it);
+				m_changed = true;
+			}
+		}
+	}
+
+	void TDirectoryCache::Clear()
+	{
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		m_listings.clear();
+		m_extensions.clear();
+		m_changed = false;
+	}
+
+	bool TDirectoryCache::Load(const TChar *path)
+	{
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		m_listings.clear();
+		m_extensions.clear();
+		m_changed = false;
+		try
+		{
+			TInputFileStream inputFile(CreatePath(path, DIRECTORY_CACHE_FILE_NAME).c_str(), DIRECTORY_CACHE_CONTROL_BYTES);
+
+			inputFile.Load(m_extensions);
+			size_t size = inputFile.LoadSize();
+			std::vector<TUInt8> buffer;
+			for(size_t i = 0; i < size; ++i)
+			{
+				TString directory;
+				inputFile.Load(directory);
+
+				// Запись каталога читается одним блоком и разбирается в памяти.
+				buffer.resize(inputFile.LoadSizeChecked(DIRECTORY_CACHE_RECORD_SIZE_MAX));
+				if(!buffer.empty())
+					inputFile.Load(buffer.data(), buffer.size());
+
+				const TUInt8 *p = buffer.data(), *end = p + buffer.size();
+				TListing listing;
+				listing.time = Read<TUInt64>(p, end);
+				listing.count = Read<TUInt32>(p, end);
+				listing.nameHash = Read<TUInt32>(p, end);
+				listing.visited = false;
+				if(listing.count > size_t(end - p)/DIRECTORY_CACHE_ENTRY_SIZE_MIN)
+					throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+				listing.entries.resize(listing.count);
+				for(size_t j = 0; j < listing.entries.size(); ++j)
+				{
+					TEntry & entry = listing.entries[j];
+					entry.attributes = Read<TUInt32>(p, end);
+					entry.size = Read<TUInt64>(p, end);
+					entry.time = Read<TUInt64>(p, end);
+					size_t length = Read<TUInt32>(p, end);
+					if(size_t(end - p) < length*sizeof(TChar))
+						throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+					entry.name.assign((const TChar*)p, length);
+					p += length*sizeof(TChar);
+				}
+
+				// Поврежденная запись просто отбрасывается, каталог будет перечислен заново.
+				if(p == end && NameHash(listing.entries) == listing.nameHash)
+					m_listings[Key(directory)] = listing;
+			}
+		}
+		catch (TException e)
+		{
+			m_listings.clear();
+			m_extensions.clear();
+			return e.Error == AD_OK;
+		}
+		return true;
+	}
+
+	bool TDirectoryCache::Save(const TChar *path)
+	{
+		TCriticalSection::TLocker locker(&m_criticalSection);
+		if(!m_changed)
+			return true;
+		try
+		{
+			TOutputFileStream outputFile(CreatePath(path, DIRECTORY_CACHE_FILE_NAME).c_str(), DIRECTORY_CACHE_CONTROL_BYTES);
+
+			outputFile.Save(m_extensions);
+			outputFile.SaveSize(m_listings.size());
+			std::vector<TUInt8> buffer;
+			for(TListings::const_iterator it = m_listings.begin(); it != m_listings.end(); ++it)
+			{
+				const TListing & listing = it->second;
+				buffer.clear();
+				Write(buffer, listing.time);
+				Write(buffer, listing.count);
+				Write(buffer, listing.nameHash);
+				for(size_t i = 0; i < listing.entries.size(); ++i)
+				{
+					const TEntry & entry = listing.entries[i];
+					Write(buffer, entry.attributes);
+					Write(buffer, entry.size);
+					Write(buffer, entry.time);
+					Write(buffer, (TUInt32)entry.name.size());
+					buffer.insert(buffer.end(), (const TUInt8*)entry.name.c_str(), (const TUInt8*)(entry.name.c_str() + entry.name.size()));
+				}
+
+				outputFile.Save(it->first);
+				outputFile.SaveSize(buffer.size());
+				if(!buffer.empty())
+					outputFile.Save(buffer.data(), buffer.size());
+			}
+		}
+		catch (TException e)
+		{
+			return e.Error == AD_OK;
+		}
+		m_changed = false;
+		return true;
+	}
+
+	TString TDirectoryCache::Key(const TString & directory)
+	{
+		TString key(directory);
+		key.ToUpper();
+		return key;
+	}
+
+	TUInt32 TDirectoryCache::NameHash(const TEntries & entries)
+	{
+		TUInt32 hash = 0;
+		for(size_t i = 0; i < entries.size(); ++i)
+			hash = hash*31 ^ SimdCrc32c(entries[i].name.c_str(), entries[i].name.size()*sizeof(TChar));
+		return hash;
+	}
+}
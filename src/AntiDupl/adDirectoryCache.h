@@ -0,0 +1,87 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adDirectoryCache_h__
+#define __adDirectoryCache_h__
+
+#include "adConfig.h"
+#include "adStrings.h"
+#include "adThreads.h"
+
+namespace ad
+{
+	// Кэш содержимого каталогов для быстрого повторного поиска. Для каждого каталога хранится
+	// время его изменения, подкаталоги и файлы с искомыми расширениями; остальные фильтры поиска 
+	// применяются заново при каждом поиске. Смена набора расширений сбрасывает кэш. Каталоги, 
+	// не посещенные последним завершенным обходом, удаляются. Кэш сохраняется рядом с индексом 
+	// базы изображений (directory.adi).
+	class TDirectoryCache
+	{
+	public:
+		struct TEntry
+		{
+			TString name;
+			TUInt32 attributes;
+			TUInt64 size;
+			TUInt64 time;
+		};
+		typedef std::vector<TEntry> TEntries;
+
+		TDirectoryCache();
+
+		// Возвращает список каталога, если время его изменения совпадает с сохраненным.
+		bool Get(const TString & directory, TUInt64 time, TEntries & entries);
+		void Set(const TString & directory, TUInt64 time, const TEntries & entries);
+
+		// Вызывается перед обходом: при другом наборе расширений сохраненные списки неполны.
+		void SetExtensions(const TStrings & extensions);
+		// Вызывается после завершенного обхода: удаляет каталоги, которые он не посетил.
+		void Prune();
+
+		void Clear();
+		bool Load(const TChar *path);
+		bool Save(const TChar *path);
+
+	private:
+		// Отпечаток каталога: время изменения, число элементов и хеш их имен.
+		struct TListing
+		{
+			TUInt64 time;
+			TUInt32 count;
+			TUInt32 nameHash;
+			TEntries entries;
+			bool visited; // не сохраняется
+		};
+		typedef std::map<TString, TListing> TListings;
+
+		static TString Key(const TString & directory);
+		static TUInt32 NameHash(const TEntries & entries);
+
+		TCriticalSection m_criticalSection;
+		TListings m_listings;
+		TString m_extensions;
+		bool m_changed;
+	};
+}
+
+#endif//__adDirectoryCache_h__
@@ -36,9 +36,16 @@
 #include "adPerformance.h"
 #include "adLogger.h"
 #include "adFileUtils.h"
+#include "adWatcher.h"
+#include "adImageIndex.h"
+#include "adServer.h"
+#include "adTracer.h"
+#include "adMemory.h"
 
 namespace ad
 {
+    const DWORD WATCH_WAIT_INTERVAL = 100;
+
     TEngine::TEngine(const TString & userPath)
         : _userPath(userPath)
     {
@@ -57,10 +64,12 @@ namespace ad
         m_pCompareManager = new TCompareManager(this);
         m_pCollectManager = new TCollectManager(this, m_pCompareManager);
         m_pSearcher = new TSearcher(this, m_pImageDataPtrs);
+        m_pImageIndex = new TImageIndex(this);
     }
 
     TEngine::~TEngine()
     {
+        delete m_pImageIndex;
         delete m_pMistakeStorage;
         delete m_pImageDataStorage;
         delete m_pResult;
@@ -85,31 +94,185 @@ namespace ad
     void TEngine::Search()
     {
         AD_FUNCTION_PERFORMANCE_TEST
-        m_pStatus->ClearStatistic();
-        m_pStatus->SetProgress(0, 0);
-        m_pResult->Clear();
+        Prepare();
 
         m_pSearcher->SearchImages();
 
-        if(m_pOptions->compare.checkOnEquality == TRUE)
+        StartManagers();
+
+        size_t total = m_pImageDataPtrs->size();
+        size_t current = CollectFound(NULL, NULL);
+
+        FinishManagers(current, total);
+
+        if(TTracer::Enabled())
+            TTracer::Write(UserPath() + TEXT("\\trace.json"));
+    }
+
+    void TEngine::Watch()
+    {
+        AD_FUNCTION_PERFORMANCE_TEST
+        Prepare();
+
+        // Наблюдение включается до обхода каталогов, чтобы не потерять файлы, появившиеся во время поиска.
+        TWatcher watcher(m_pStatus);
+        watcher.Start(m_pOptions->searchPaths);
+
+        m_pSearcher->SearchImages();
+
+        StartManagers();
+        m_pResult->Publish(true);
+
+        std::set<TString> accepted;
+        adUInt64 searchedSize = 0;
+        size_t total = m_pImageDataPtrs->size();
+        size_t current = CollectFound(&accepted, &searchedSize);
+        m_pImageDataPtrs->clear(); // изображения уже переданы на сбор, список больше не нужен
+
+        // Новые файлы сразу сравниваются с уже собранными в потоках сравнения. Изображение, 
+        // которое уже передано на сравнение, повторно не передается, даже если файл изменился.
+        TStrings paths;
+        while(!m_pStatus->Stopped())
         {
-            m_pCompareManager->Start(m_pImageDataPtrs->size());
-            m_pCompareManager->SetPriority(THREAD_PRIORITY_LOWEST);
+            paths.clear();
+            watcher.Pop(paths, WATCH_WAIT_INTERVAL);
+            for(size_t i = 0; i < paths.size() && !m_pStatus->Stopped(); ++i)
+            {
+                WIN32_FILE_ATTRIBUTE_DATA fileAttributeData;
+                if(::GetFileAttributesEx(paths[i].c_str(), GetFileExInfoStandard, &fileAttributeData) == FALSE)
+                    continue;
+                if(!m_pSearcher->IsWanted(paths[i], fileAttributeData.dwFileAttributes))
+                    continue;
+                TString path = paths[i].GetUpper();
+                if(accepted.find(path) != accepted.end())
+                    continue;
+                if(accepted.size() >= WATCH_IMAGE_COUNT_MAX)
+                {
+                    m_pStatus->Stop(); // как и при превышении resultCountMax
+                    break;
+                }
+                accepted.insert(path);
+
+                TUInt64 size = TUInt64(fileAttributeData.nFileSizeLow) + TUInt64(fileAttributeData.nFileSizeHigh)*0x100000000;
+                TImageDataPtr pImageData = m_pImageDataStorage->Get(TImageInfo(paths[i], size, *(TUInt64*)&fileAttributeData.ftLastWriteTime));
+                m_pCollectManager->Add(pImageData);
+
+                searchedSize += size;
+                current++;
+                total++;
+                m_pStatus->Search(NULL, total, searchedSize);
+                m_pStatus->SetProgress(current, total);
+            }
         }
-        m_pCollectManager->Start();
-        m_pCollectManager->SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
 
+        m_pResult->Publish(false);
+        FinishManagers(current, total);
+
+        if(TTracer::Enabled())
+            TTracer::Write(UserPath() + TEXT("\\trace.json"));
+    }
+
+    // Изображения из путей поиска собираются в базу без сравнения между собой, 
+    // после чего по всей базе строится индекс и база сохраняется в path.
+    adError TEngine::BuildIndex(const TString & path)
+    {
+        AD_FUNCTION_PERFORMANCE_TEST
+        Prepare();
+
+        m_pSearcher->SearchImages();
+
+        StartManagers(false);
+
+        size_t total = m_pImageDataPtrs->size();
+        size_t current = CollectFound(NULL, NULL);
+
+        FinishManagers(current, total, false);
+
+        adError error = m_pImageDataStorage->Save(path.c_str());
+        if(error != AD_OK)
+            return error;
+
+        TImageDataPtrs imageDataPtrs;
+        m_pImageDataStorage->GetAll(imageDataPtrs);
+        m_pImageIndex->Assign(imageDataPtrs);
+        return AD_OK;
+    }
+
+    // Несохраненные изменения базы в памяти теряются: она целиком заменяется базой из path.
+    adError TEngine::OpenIndex(const TString & path)
+    {
+        AD_FUNCTION_PERFORMANCE_TEST
+        m_pImageIndex->Clear();
+        m_pImageDataStorage->ClearMemory();
+        adError error = m_pImageDataStorage->Load(path.c_str(), true);
+        if(error != AD_OK)
+            return error;
+
+        TImageDataPtrs imageDataPtrs;
+        m_pImageDataStorage->GetAll(imageDataPtrs);
+        m_pImageIndex->Assign(imageDataPtrs);
+        return AD_OK;
+    }
+
+    // Индекс должен быть открыт заранее, добавленные клиентами изображения сохраняет вызывающий.
+    adError TEngine::Serve(const TString & pipeName)
+    {
+        AD_FUNCTION_PERFORMANCE_TEST
+        if(!m_pImageIndex->Opened())
+            return AD_ERROR_INDEX_IS_NOT_OPEN;
+
+        m_pStatus->SetProgress(0, 0);
+        TServer server(this);
+        adError error = server.Run(pipeName);
+        m_pStatus->Reset();
+        return error;
+    }
+
+    // Общее начало Search, Watch и BuildIndex: сбрасываются результаты и статистика предыдущего запуска.
+    void TEngine::Prepare()
+    {
+        m_pImageIndex->Clear();
+        m_pStatus->ClearStatistic();
+        m_pStatus->SetProgress(0, 0);
+        m_pResult->Clear();
+        TMemoryCounters::ResetPeak();
+    }
+
+    // Передает на сбор изображения, найденные обходом каталогов, и возвращает число переданных.
+    // Если задан pAccepted, в него добавляются пути переданных изображений, в pSearchedSize - их размер.
+    size_t TEngine::CollectFound(std::set<TString> * pAccepted, adUInt64 * pSearchedSize)
+    {
         size_t current = 0, total = m_pImageDataPtrs->size(); 
         for(TImageDataPtrs::iterator it = m_pImageDataPtrs->begin(); 
             it != m_pImageDataPtrs->end() && !m_pStatus->Stopped(); ++it, ++current)
         {
             TImageDataPtr pImageData = *it;
+            if(pAccepted)
+                pAccepted->insert(TString(pImageData->path.Original()).GetUpper());
+            if(pSearchedSize)
+                *pSearchedSize += pImageData->size;
             m_pCollectManager->Add(pImageData);
             m_pStatus->SetProgress(current, total);
         }
+        return current;
+    }
+
+    void TEngine::StartManagers(bool compare)
+    {
+        if(compare && m_pOptions->compare.checkOnEquality == TRUE)
+        {
+            m_pCompareManager->Start(m_pImageDataPtrs->size());
+            m_pCompareManager->SetPriority(THREAD_PRIORITY_LOWEST);
+        }
+        m_pCollectManager->Start();
+        m_pCollectManager->SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
+    }
+
+    void TEngine::FinishManagers(size_t current, size_t total, bool compare)
+    {
         m_pCollectManager->Finish();
 
-        if(m_pOptions->compare.checkOnEquality == TRUE)
+        if(compare && m_pOptions->compare.checkOnEquality == TRUE)
         {
             m_pStatus->SetProgress(current, total);
             m_pStatus->Wait(AD_THREAD_TYPE_MAIN, 0);
@@ -43,6 +43,7 @@ namespace ad
     class TCollectManager;
     class TSearcher;
     class TRecycleBin;
+    class TImageIndex;
 	class TCriticalSection;
 
     typedef TImageData *TImageDataPtr; 
@@ -55,6 +56,11 @@ namespace ad
         ~TEngine();
 
         void Search();
+        void Watch();
+
+        adError BuildIndex(const TString & path);
+        adError OpenIndex(const TString & path);
+        adError Serve(const TString & pipeName);
 
         const TString & UserPath() const { return _userPath; }
         TStatus* Status() {return m_pStatus;}
@@ -64,8 +70,14 @@ namespace ad
         TResultStorage* Result() {return m_pResult;}
         TCriticalSection* CriticalSection() {return m_pCriticalSection;}
         TRecycleBin* RecycleBin() {return m_pRecycleBin;}
+        TImageIndex* ImageIndex() {return m_pImageIndex;}
 
     private:
+        void Prepare();
+        size_t CollectFound(std::set<TString> * pAccepted, adUInt64 * pSearchedSize);
+        void StartManagers(bool compare = true);
+        void FinishManagers(size_t current, size_t total, bool compare = true);
+
         TString _userPath;
         TImageDataPtrs *m_pImageDataPtrs;
         TCompareManager *m_pCompareManager;
@@ -79,6 +91,7 @@ namespace ad
         TInit *m_pInit;
         TSearcher *m_pSearcher;
         TRecycleBin *m_pRecycleBin;
+        TImageIndex *m_pImageIndex;
     };
     //-------------------------------------------------------------------------
 }
@@ -0,0 +1,230 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adThreads.h"
+#include "adStatus.h"
+#include "adFileUtils.h"
+#include "adImageInfo.h"
+#include "adFileChecker.h"
+
+namespace ad
+{
+	// Минимальное число проверяемых файлов в каталоге, при котором каталог выгоднее перечислить целиком.
+	const size_t FILE_CHECK_ENUMERATION_THRESHOLD = 8;
+	const size_t FILE_CHECK_THREAD_COUNT_MAX = 16;
+	const DWORD FILE_CHECK_PROGRESS_INTERVAL = 100;
+
+	TFileChecker::TFileChecker(TStatus *pStatus)
+		: m_pStatus(pStatus)
+		, m_next(0)
+		, m_checked(0)
+	{
+	}
+
+	void TFileChecker::Add(TImageInfo *pImageInfo)
+	{
+		TItem item;
+		item.image = pImageInfo;
+		item.checked = false;
+		item.exists = false;
+		item.size = 0;
+		item.time = 0;
+		m_items.push_back(item);
+	}
+
+	void TFileChecker::Check()
+	{
+		struct TImageLesser
+		{
+			bool operator()(const TItem & a, const TItem & b) const {return a.image < b.image;}
+		};
+		struct TImageEqual
+		{
+			bool operator()(const TItem & a, const TItem & b) const {return a.image == b.image;}
+		};
+		struct TPathLesser
+		{
+			bool operator()(const TItem & a, const TItem & b) const 
+			{
+				return a.directory < b.directory || (a.directory == b.directory && a.name < b.name);
+			}
+		};
+
+		std::sort(m_items.begin(), m_items.end(), TImageLesser());
+		m_items.erase(std::unique(m_items.begin(), m_items.end(), TImageEqual()), m_items.end());
+
+		// Группируем файлы по каталогам без учета регистра.
+		for(size_t i = 0; i < m_items.size(); ++i)
+		{
+			TItem & item = m_items[i];
+			item.directory = item.image->path.GetDirectory();
+			item.directory.ToUpper();
+			item.name = item.image->path.GetName();
+			item.name.ToUpper();
+		}
+		std::sort(m_items.begin(), m_items.end(), TPathLesser());
+		m_directories.clear();
+		for(size_t i = 0; i < m_items.size(); ++i)
+		{
+			if(i == 0 || m_items[i].directory != m_items[i - 1].directory)
+				m_directories.push_back(i);
+		}
+		m_directories.push_back(m_items.size());
+
+		size_t directoryCount = m_directories.size() - 1;
+		size_t threadCount = std::min<size_t>(directoryCount, FILE_CHECK_THREAD_COUNT_MAX);
+		m_next = 0;
+		m_checked = 0;
+		if(threadCount > 1)
+		{
+			std::vector<TThread*> threads(threadCount);
+			std::vector<HANDLE> handles(threadCount);
+			for(size_t i = 0; i < threadCount; ++i)
+			{
+				threads[i] = new TThread(this, &TFileChecker::Work);
+				handles[i] = threads[i]->Handle();
+				threads[i]->Resume();
+			}
+			while(::WaitForMultipleObjects((DWORD)threadCount, handles.data(), TRUE, FILE_CHECK_PROGRESS_INTERVAL) == WAIT_TIMEOUT)
+				m_pStatus->SetProgress(m_checked, m_items.size());
+			for(size_t i = 0; i < threadCount; ++i)
+				delete threads[i];
+		}
+		else if(threadCount == 1)
+			Work();
+
+		// Для поиска по указателю возвращаем порядок по изображениям.
+		std::sort(m_items.begin(), m_items.end(), TImageLesser());
+		for(size_t i = 0; i < m_items.size(); ++i)
+		{
+			m_items[i].directory.clear();
+			m_items[i].name.clear();
+		}
+	}
+
+	void TFileChecker::Work()
+	{
+		size_t directoryCount = m_directories.size() - 1;
+		for(;;)
+		{
+			size_t directory = (size_t)::InterlockedIncrement(&m_next) - 1;
+			if(directory >= directoryCount || m_pStatus->Stopped())
+				break;
+			CheckDirectory(m_directories[directory], m_directories[directory + 1]);
+			::InterlockedExchangeAdd(&m_checked, LONG(m_directories[directory + 1] - m_directories[directory]));
+		}
+	}
+
+	void TFileChecker::CheckDirectory(size_t begin, size_t end)
+	{
+		if(end - begin >= FILE_CHECK_ENUMERATION_THRESHOLD)
+		{
+			WIN32_FIND_DATA findData;
+			TString mask = CreatePath(m_items[begin].image->path.GetDirectory(), TEXT("*"));
+			HANDLE hFind = ::FindFirstFileEx(mask.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+			if(hFind != INVALID_HANDLE_VALUE)
+			{
+				std::vector<TEntry> entries;
+				do
+				{
+					TEntry entry;
+					entry.name = findData.cFileName;
+					entry.name.ToUpper();
+					entry.size = TUInt64(findData.nFileSizeLow) + TUInt64(findData.nFileSizeHigh)*0x100000000;
+					entry.time = *(TUInt64*)&findData.ftLastWriteTime;
+					entries.push_back(entry);
+				} 
+				while(::FindNextFile(hFind, &findData) != FALSE);
+				::FindClose(hFind);
+
+				std::sort(entries.begin(), entries.end());
+				for(size_t i = begin; i < end; ++i)
+				{
+					TItem & item = m_items[i];
+					TEntry key;
+					key.name = item.name;
+					std::vector<TEntry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+					item.checked = true;
+					item.exists = it != entries.end() && it->name == item.name;
+					if(item.exists)
+					{
+						item.size = it->size;
+						item.time = it->time;
+					}
+				}
+				return;
+			}
+			DWORD error = ::GetLastError();
+			if(error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+			{
+				for(size_t i = begin; i < end; ++i)
+					m_items[i].checked = true;
+				return;
+			}
+		}
+
+		for(size_t i = begin; i < end; ++i)
+		{
+			TItem & item = m_items[i];
+			WIN32_FILE_ATTRIBUTE_DATA fileAttributeData;
+			item.checked = true;
+			item.exists = ::GetFileAttributesEx(item.image->path.Original().c_str(), GetFileExInfoStandard, &fileAttributeData) != FALSE;
+			if(item.exists)
+			{
+				item.size = TUInt64(fileAttributeData.nFileSizeLow) + TUInt64(fileAttributeData.nFileSizeHigh)*0x100000000;
+				item.time = *(TUInt64*)&fileAttributeData.ftLastWriteTime;
+			}
+		}
+	}
+
+	const TFileChecker::TItem * TFileChecker::Find(const TImageInfo *pImageInfo) const
+	{
+		size_t lo = 0, hi = m_items.size();
+		while(lo < hi)
+		{
+			size_t mid = (lo + hi)/2;
+			if(m_items[mid].image < pImageInfo)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo < m_items.size() && m_items[lo].image == pImageInfo ? &m_items[lo] : NULL;
+	}
+
+	// Файлы, не проверенные из-за остановки, считаются существующими, как и при прерванной поштучной проверке.
+	bool TFileChecker::Exists(const TImageInfo *pImageInfo) const
+	{
+		const TItem * pItem = Find(pImageInfo);
+		if(pItem == NULL)
+			return IsFileExists(pImageInfo->path.Original().c_str());
+		return !pItem->checked || pItem->exists;
+	}
+
+	bool TFileChecker::Actual(const TImageInfo *pImageInfo) const
+	{
+		const TItem * pItem = Find(pImageInfo);
+		if(pItem == NULL)
+			return ((TImageInfo*)pImageInfo)->Actual(true);
+		return !pItem->checked || (pItem->exists && pItem->size == pImageInfo->size && pItem->time == pImageInfo->time);
+	}
+}
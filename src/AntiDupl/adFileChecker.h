@@ -0,0 +1,81 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adFileChecker_h__
+#define __adFileChecker_h__
+
+#include "adConfig.h"
+#include "adStrings.h"
+
+namespace ad
+{
+	struct TImageInfo;
+	class TStatus;
+
+	// Пакетная проверка существования и актуальности файлов. Пути группируются по каталогам:
+	// каталог с большим числом проверяемых файлов перечисляется один раз, остальные файлы
+	// проверяются по одному. Каталоги обрабатываются параллельно, результат хранится до конца операции.
+	class TFileChecker
+	{
+	public:
+		TFileChecker(TStatus *pStatus);
+
+		void Add(TImageInfo *pImageInfo);
+		void Check();
+
+		bool Exists(const TImageInfo *pImageInfo) const;
+		bool Actual(const TImageInfo *pImageInfo) const;
+
+	private:
+		struct TItem
+		{
+			TImageInfo *image;
+			TString directory;
+			TString name;
+			bool checked;
+			bool exists;
+			TUInt64 size;
+			TUInt64 time;
+		};
+
+		struct TEntry
+		{
+			TString name;
+			TUInt64 size;
+			TUInt64 time;
+			bool operator < (const TEntry & entry) const {return name < entry.name;}
+		};
+
+		void Work();
+		void CheckDirectory(size_t begin, size_t end);
+		const TItem * Find(const TImageInfo *pImageInfo) const;
+
+		TStatus *m_pStatus;
+		std::vector<TItem> m_items;
+		std::vector<size_t> m_directories;
+		volatile LONG m_next;
+		volatile LONG m_checked;
+	};
+}
+
+#endif//__adFileChecker_h__
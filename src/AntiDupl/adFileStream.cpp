@@ -149,6 +149,8 @@ namespace ad
 			Load(pixelData.average);
 			Load(pixelData.varianceSquare);
 		}
+		if(m_version > 4)
+			Load(pixelData.decodeMode);
 	}
 
 	void TInputFileStream::Load(TImageData & imageData) const
@@ -270,6 +272,7 @@ namespace ad
 		Save(pixelData.main, pixelData.size);
 		Save(pixelData.average);
 		Save(pixelData.varianceSquare);
+		Save(pixelData.decodeMode);
 	}
 
 	// Сохранение в потоке изображения
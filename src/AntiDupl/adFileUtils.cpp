@@ -28,6 +28,8 @@
 #include <io.h>
 
 #include "adPerformance.h"
+#include "adTracer.h"
+#include "adMemory.h"
 #include "adFileUtils.h"
 
 namespace ad
@@ -331,6 +333,8 @@ namespace ad
     HGLOBAL LoadFileToMemory(const TChar* path)
     {
         AD_FUNCTION_PERFORMANCE_TEST
+        AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_READ)
+        AD_TRACE("read")
         HGLOBAL hGlobal = NULL;
         HANDLE hFile = ::CreateFile(path, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
         if (hFile != INVALID_HANDLE_VALUE)
@@ -350,6 +354,8 @@ namespace ad
                         ::GlobalFree(hGlobal);
                         hGlobal = NULL;
                     }
+                    else
+                        TMemoryCounters::Add(AD_MEMORY_FILE_BUFFER, ::GlobalSize(hGlobal));
                 }
             }
             ::CloseHandle(hFile);
@@ -357,6 +363,13 @@ namespace ad
         return hGlobal;
     }
 
+    // Освобождает память, выделенную LoadFileToMemory.
+    void FreeFileFromMemory(HGLOBAL hGlobal)
+    {
+        TMemoryCounters::Remove(AD_MEMORY_FILE_BUFFER, ::GlobalSize(hGlobal));
+        ::GlobalFree(hGlobal);
+    }
+
 	bool SearchFiles(const TString& directory, TStrings & files, bool subFolders, const TString & mask)
 	{
 		if(!IsDirectoryExists(directory.c_str()))
@@ -64,6 +64,7 @@ namespace ad
     TString CreatePath(const TString& path1, const TString& path2 = TString());
     
     HGLOBAL LoadFileToMemory(const TChar* path);
+    void FreeFileFromMemory(HGLOBAL hGlobal);
 
 	bool SearchFiles(const TString& directory, TStrings & files, bool subFolders = true, const TString & mask = TString("*"));
 
@@ -46,96 +46,139 @@ namespace ad
         return false;
     }
 
-	THeif* THeif::Load(HGLOBAL hGlobal)
+	// heif_init выполняет регистрацию плагинов и довольно дорогой, поэтому вызываем его один раз на поток.
+	struct HeifLibrary
+	{
+		HeifLibrary()
+			: options(NULL)
+		{
+			struct heif_error heif_error = heif_init(NULL);
+			initialized = heif_error.code == heif_error_Ok;
+			if (initialized)
+			{
+				options = heif_decoding_options_alloc();
+				options->ignore_transformations = 0;
+			}
+			threads = SimdCpuInfo(SimdCpuInfoCores);
+		}
+
+		~HeifLibrary()
+		{
+			if (initialized)
+			{
+				heif_decoding_options_free(options);
+				heif_deinit();
+			}
+		}
+
+		bool initialized;
+		heif_decoding_options* options;
+		int threads;
+	};
+
+	thread_local HeifLibrary heifLibrary;
+
+	// Выбираем наименьший встроенный эскиз, меньшая сторона которого не меньше thumbnailSize.
+	static heif_image_handle* HeifThumbnail(heif_image_handle* heif_handle, size_t thumbnailSize)
+	{
+		int count = heif_image_handle_get_number_of_thumbnails(heif_handle);
+		if (thumbnailSize == 0 || count <= 0)
+			return NULL;
+
+		std::vector<heif_item_id> ids(count);
+		count = heif_image_handle_get_list_of_thumbnail_IDs(heif_handle, ids.data(), count);
+
+		heif_image_handle* best = NULL;
+		size_t bestArea = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			heif_image_handle* thumbnail = NULL;
+			if (heif_image_handle_get_thumbnail(heif_handle, ids[i], &thumbnail).code != heif_error_Ok)
+				continue;
+			size_t width = heif_image_handle_get_width(thumbnail);
+			size_t height = heif_image_handle_get_height(thumbnail);
+			if (std::min(width, height) >= thumbnailSize && (best == NULL || width * height < bestArea))
+			{
+				if (best)
+					heif_image_handle_release(best);
+				best = thumbnail;
+				bestArea = width * height;
+			}
+			else
+				heif_image_handle_release(thumbnail);
+		}
+		return best;
+	}
+
+	THeif* THeif::Load(HGLOBAL hGlobal, size_t thumbnailSize)
 	{
 		AD_FUNCTION_PERFORMANCE_TEST
 
 		THeif* pHeif = NULL;
-		if (hGlobal)
+		if (hGlobal && heifLibrary.initialized)
 		{
 			uint8_t* data = (uint8_t*)::GlobalLock(hGlobal);
 			size_t data_size = ::GlobalSize(hGlobal);
-			
-			struct heif_error heif_error = heif_init(NULL);
-			if (heif_error.code != heif_error_Ok)
-			{
-#ifdef AD_LOGGER_ENABLE
-				AD_LOG(heif_error.message);
-#endif//AD_LOGGER_ENABLE
-				return NULL;
-			}
 
 			heif_context* heif_ctx = heif_context_alloc();
 
 			assert(heif_ctx);
 
-			heif_error = heif_context_read_from_memory_without_copy(heif_ctx, data, data_size, nullptr);
-
-			int numCPU = SimdCpuInfo(SimdCpuInfoCores);
-			heif_context_set_max_decoding_threads(heif_ctx, numCPU);
-
-			::GlobalUnlock(hGlobal);
+			heif_context_set_max_decoding_threads(heif_ctx, heifLibrary.threads);
 
+			struct heif_error heif_error = heif_context_read_from_memory_without_copy(heif_ctx, data, data_size, nullptr);
 			if (heif_error.code == heif_error_Ok)
 			{  
-				heif_image_handle* heif_handle;
+				heif_image_handle* heif_handle = NULL;
 				heif_error = heif_context_get_primary_image_handle(heif_ctx, &heif_handle);
 				if (heif_error.code == heif_error_Ok)
 				{
 					struct heif_image* heif_img;
-					struct heif_decoding_options* decode_options;
-					decode_options = heif_decoding_options_alloc();
-					decode_options->ignore_transformations = 0;
-
-					int img_has_alpha = heif_image_handle_has_alpha_channel(heif_handle);
 
-					heif_error = heif_decode_image(heif_handle, &heif_img, heif_colorspace_RGB, img_has_alpha ? heif_chroma_interleaved_RGBA : heif_chroma_interleaved_RGB, decode_options);
+					heif_image_handle* heif_thumbnail = HeifThumbnail(heif_handle, thumbnailSize);
+					heif_image_handle* heif_decode = heif_thumbnail ? heif_thumbnail : heif_handle;
 
-					heif_decoding_options_free(decode_options);
+					int img_has_alpha = heif_image_handle_has_alpha_channel(heif_decode);
 
+					heif_error = heif_decode_image(heif_decode, &heif_img, heif_colorspace_RGB, img_has_alpha ? heif_chroma_interleaved_RGBA : heif_chroma_interleaved_RGB, heifLibrary.options);
 					if (heif_error.code == heif_error_Ok)
 					{
+						size_t img_width = heif_image_handle_get_width(heif_decode);
+						size_t img_height = heif_image_handle_get_height(heif_decode);
 
-						size_t img_width = heif_image_handle_get_width(heif_handle);
-						size_t img_height = heif_image_handle_get_height(heif_handle);
-
-						// Get interleaved RGB plane
-						int img_stride_RGB = 0;
-						const uint8_t* pData_RGB = heif_image_get_plane_readonly(heif_img, heif_channel_interleaved, &img_stride_RGB);
-						TView* pView_RGB = new TView(img_width, img_height, img_stride_RGB, TView::Rgb24, NULL);
+						// Get interleaved RGB(A) plane
+						int img_stride = 0;
+						const uint8_t* pData = heif_image_get_plane_readonly(heif_img, heif_channel_interleaved, &img_stride);
+						TView* pView = new TView(img_width, img_height, img_stride, img_has_alpha ? TView::Rgba32 : TView::Rgb24, NULL);
 
-						AD_PERFORMANCE_TEST_SET_SIZE(img_height * img_stride_RGB)
+						AD_PERFORMANCE_TEST_SET_SIZE(img_height * img_stride)
 
-						if (pView_RGB)
+						memcpy(pView->data, pData, img_height * img_stride);
+						pHeif = new THeif();
+						pHeif->m_pView = pView;
+						pHeif->m_format = TImage::Heif;
+						if (heif_thumbnail)
 						{
-							memcpy(pView_RGB->data, pData_RGB, img_height * img_stride_RGB);
-							pHeif = new THeif();
-							pHeif->m_pView = pView_RGB;
-							pHeif->m_format = TImage::Heif;
-						}
-						else
-						{
-							delete pView_RGB;
+							pHeif->m_originalSize = TPoint(heif_image_handle_get_width(heif_handle), heif_image_handle_get_height(heif_handle));
+							pHeif->m_decodeMode = DECODE_MODE_THUMBNAIL;
 						}
+
 						heif_image_release(heif_img);
 					}
+					if (heif_thumbnail)
+						heif_image_handle_release(heif_thumbnail);
+					heif_image_handle_release(heif_handle);
 				}
-				heif_image_handle_release(heif_handle);
 			}
 
-			if (heif_error.code != heif_error_Ok)
-			{ 
 #ifdef AD_LOGGER_ENABLE
+			if (heif_error.code != heif_error_Ok)
 				AD_LOG(heif_error.message);
 #endif//AD_LOGGER_ENABLE
-				heif_deinit();
-				return NULL;
-			}
 
 			heif_context_free(heif_ctx);
-			heif_deinit();
-			return pHeif;
+			::GlobalUnlock(hGlobal);
         }
-		return NULL;
+		return pHeif;
 	}
 }
\ No newline at end of file
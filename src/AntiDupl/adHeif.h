@@ -32,7 +32,8 @@ namespace ad
 	class THeif : public TImage
 	{
 	public:
-		static THeif* Load(HGLOBAL hGlobal);
+		// thumbnailSize > 0: загрузить встроенный эскиз, если его меньшая сторона не меньше thumbnailSize.
+		static THeif* Load(HGLOBAL hGlobal, size_t thumbnailSize = 0);
 		static bool Supported(HGLOBAL hGlobal);
 
 		  private:
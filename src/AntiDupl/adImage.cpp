@@ -24,16 +24,10 @@
 #include "adOptions.h"
 #include "adFileUtils.h"
 #include "adImage.h"
-#include "adGdiplus.h"
-#include "adOpenJpeg.h"
-#include "adPsd.h"
-#include "adDds.h"
-#include "adTga.h"
-#include "adWebp.h"
-#include "adTurboJpeg.h"
-#include "adHeif.h"
-#include "adAvif.h"
-#include "adJxl.h"
+#include "adImageDecoder.h"
+#include "adPerformance.h"
+#include "adTracer.h"
+#include "adMemory.h"
 
 namespace ad
 {
@@ -63,7 +57,10 @@ namespace ad
 
     TImage::TImage()
         :m_pView(NULL),
-        m_format(None)
+        m_viewSize(0),
+        m_format(None),
+        m_originalSize(0, 0),
+        m_decodeMode(DECODE_MODE_FULL)
     {
     }
 
@@ -77,6 +74,17 @@ namespace ad
         if(m_pView)
             delete m_pView;
         m_pView = NULL;
+        TMemoryCounters::Remove(AD_MEMORY_DECODE, m_viewSize);
+        m_viewSize = 0;
+    }
+
+    void TImage::TakeView(TImage * pImage)
+    {
+        FreeView();
+        m_pView = pImage->m_pView;
+        m_viewSize = pImage->m_viewSize;
+        pImage->m_pView = NULL;
+        pImage->m_viewSize = 0;
     }
 
     TStrings TImage::Extensions(TImage::TFormat format)
@@ -92,30 +100,18 @@ namespace ad
     }
 
 	// Вызывается из adDataCollector.cpp
-    TImage* TImage::Load(HGLOBAL hGlobal, const TOptions * pOptions)
+    TImage* TImage::Load(HGLOBAL hGlobal, const TOptions * pOptions, size_t reducedSize, size_t thumbnailSize)
     {
-        if(TOpenJpeg::Supported(hGlobal))
-            return TOpenJpeg::Load(hGlobal);
-        else if(TPsd::Supported(hGlobal))
-            return TPsd::Load(hGlobal);
-		else if(TDds::Supported(hGlobal))
-			return TDds::Load(hGlobal);
-		else if(TTga::Supported(hGlobal))
-			return TTga::Load(hGlobal);
-		else if (TWebp::Supported(hGlobal))
-			return TWebp::Load(hGlobal);
-        else if (TAvif::Supported(hGlobal))
-            return TAvif::Load(hGlobal);
-        else if (TJxl::Supported(hGlobal))
-            return TJxl::Load(hGlobal);
-        else if (THeif::Supported(hGlobal))
-            return THeif::Load(hGlobal);
-#ifdef AD_TURBO_JPEG_ENABLE
-        if (pOptions->advanced.useLibJpegTurbo && TTurboJpeg::Supported(hGlobal))
-            return TTurboJpeg::Load(hGlobal);
-#endif//AD_TURBO_JPEG_ENABLE
-        else
-            return TGdiplus::Load(hGlobal);
+        AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_DECODE)
+        AD_TRACE("decode")
+        TImage *pImage = TImageDecoderRegistry::Instance().Load(hGlobal, pOptions, reducedSize, thumbnailSize);
+        // Декодеры сами создают m_pView, поэтому память изображения учитывается здесь, один раз для всех форматов.
+        if(pImage && pImage->m_pView)
+        {
+            pImage->m_viewSize = pImage->m_pView->stride*pImage->m_pView->height;
+            TMemoryCounters::Add(AD_MEMORY_DECODE, pImage->m_viewSize);
+        }
+        return pImage;
     }
     
     TImage* TImage::Load(const TChar * fileName, const TOptions* pOptions)
@@ -125,7 +121,7 @@ namespace ad
         if(hGlobal)
         {
             pImage = Load(hGlobal, pOptions);
-            ::GlobalFree(hGlobal);
+            FreeFileFromMemory(hGlobal);
         }
         return pImage;
     }
@@ -68,18 +68,33 @@ namespace ad
 
         TFormat Format() const {return m_format;}
         TView* View() const {return m_pView;}
+
+        // Размер исходного изображения, View() может быть меньше, если декодер загрузил уменьшенную копию.
+        TPoint OriginalSize() const {return m_originalSize.x && m_originalSize.y ? m_originalSize : m_pView->Size();}
+        TDecodeMode DecodeMode() const {return m_decodeMode;}
         
         static TStrings Extensions(TFormat format);
-        static TImage* Load(HGLOBAL hGlobal, const TOptions * opOptions);
+        // reducedSize > 0 разрешает декодеру вернуть уменьшенное изображение, меньшая сторона которого не меньше reducedSize.
+        // thumbnailSize > 0 разрешает (при включенной опции useThumbnails) вернуть встроенный эскиз не меньше thumbnailSize.
+        static TImage* Load(HGLOBAL hGlobal, const TOptions * opOptions, size_t reducedSize = 0, size_t thumbnailSize = 0);
         static TImage* Load(const TChar * fileName, const TOptions* pOptions);
 
     protected:
         TImage();
 
         void FreeView();
+        // Забирает изображение у другого TImage без копирования.
+        void TakeView(TImage * pImage);
 
+        // Изображение выделяется декодером на каждый файл и освобождается вместе с TImage, общего пула нет: 
+        // декодеры сами выбирают размер и формат (встроенный эскиз, уменьшенный JPEG 2000, Rgba32 для HEIF с 
+        // альфа-каналом), а пул под полноразмерные изображения держал бы в каждом потоке сбора память 
+        // самого большого файла. Между изображениями переиспользуется только полутоновый буфер TDataCollector.
         TView *m_pView;
+        size_t m_viewSize; // учтено в AD_MEMORY_DECODE
         TFormat m_format;
+        TPoint m_originalSize;
+        TDecodeMode m_decodeMode;
 		TImageExif m_exifInfo;
     };
 }
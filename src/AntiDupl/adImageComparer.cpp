@@ -31,6 +31,11 @@
 #include "adResultStorage.h"
 #include "adImageComparer.h"
 #include "adImageDataStorage.h"
+#include "adNearest.h"
+#include "adCluster.h"
+#include "adPerformance.h"
+#include "adTracer.h"
+#include "adMemory.h"
 
 namespace ad
 {
@@ -41,10 +46,31 @@ namespace ad
     TImageComparer::TImageComparer(TEngine *pEngine)
         :m_pOptions(pEngine->Options()),
         m_pResult(pEngine->Result()),
+        m_pStatus(pEngine->Status()),
+        m_pNearest(NULL),
+        m_pClusters(NULL),
         m_pTransformedImageData(NULL),
         m_pBuffer(NULL),
-        m_pMask(NULL) 
+        m_pMask(NULL),
+        m_roleCount(1),
+        m_separateSearchPaths(false),
+        m_memory(0),
+        m_counting(false),
+        m_visitedCount(0),
+        m_prunedCount(0),
+        m_mainCount(0)
     {
+        if(m_pOptions->compare.compareInsideOneSearchPath == FALSE)
+        {
+            m_roleCount = m_pOptions->searchPaths.Size() + 1;
+            m_separateSearchPaths = true;
+        }
+
+        if(m_pOptions->compare.nearestCount > 0)
+            m_pNearest = new TNearest(m_pOptions->compare.nearestCount);
+        if(m_pOptions->compare.clusterThreshold > 0)
+            m_pClusters = new TClusters(m_pOptions->compare.clusterThreshold);
+
 		int thresholdPerPixel = Simd::Square(m_pOptions->compare.thresholdDifference*PIXEL_MAX_DIFFERENCE)/
 			Simd::Square(DENOMINATOR);
         m_fastThreshold = FAST_DATA_SIZE*thresholdPerPixel;
@@ -81,6 +107,8 @@ namespace ad
 
     TImageComparer::~TImageComparer()
     {
+        FlushStatistic();
+
         if(m_pOptions->advanced.ignoreFrameWidth > 0)
         {
             SimdFree(m_pMask);
@@ -91,30 +119,93 @@ namespace ad
             delete m_pTransformedImageData;
             SimdFree(m_pBuffer); 
         }
+
+        if(m_pNearest)
+            delete m_pNearest;
+        if(m_pClusters)
+            delete m_pClusters;
+
+        TMemoryCounters::Remove(AD_MEMORY_COMPARER, m_memory);
     }
 
     void TImageComparer::Accept(TImageDataPtr pImageData, bool add)
     {
-        Compare(pImageData, pImageData, AD_TRANSFORM_TURN_0);
+        AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_COMPARE)
+        AD_TRACE("compare")
+        m_counting = true;
+        Prepare(pImageData, true);
+        CompareTransformed(pImageData, m_pTransformedImageData, m_pBuffer, NULL);
+		// Член кластера дальше представлен своим представителем.
+        if(add && !(m_pClusters && m_pClusters->Joined(pImageData)))
+            Add(pImageData);
+        if(add)
+            FlushStatistic();
+    }
+
+	// Счетчики передаются в статистику раз на собственное изображение потока, а не на каждое сравнение.
+    void TImageComparer::FlushStatistic()
+    {
+        if(m_visitedCount == 0)
+            return;
+        m_pStatus->Compare(m_visitedCount, m_prunedCount, m_mainCount);
+        m_visitedCount = 0;
+        m_prunedCount = 0;
+        m_mainCount = 0;
+    }
+
+    void TImageComparer::Insert(TImageDataPtr pImageData)
+    {
+        Prepare(pImageData, true);
+        Add(pImageData);
+    }
+
+    void TImageComparer::Erase(TImageDataPtr pImageData)
+    {
+        Remove(pImageData);
+    }
+
+    void TImageComparer::IgnoreSearchPaths()
+    {
+        m_roleCount = 1;
+        m_separateSearchPaths = false;
+    }
+
+	// Буферы для трансформаций у каждого запроса свои, поэтому запросы не мешают друг другу.
+    void TImageComparer::Query(TImageDataPtr pImageData, TImageMatches & matches)
+    {
+        Prepare(pImageData, false);
         if(m_pOptions->compare.transformedImage == TRUE)
         {
-            *m_pTransformedImageData = *pImageData;
+            TImageData transformed(m_pOptions->advanced.reducedImageSize);
+            TUInt8 *pBuffer = (TUInt8*)SimdAllocate(m_mainSize + FAST_DATA_SIZE, SimdAlignment());
+            CompareTransformed(pImageData, &transformed, pBuffer, &matches);
+            SimdFree(pBuffer);
+        }
+        else
+            CompareTransformed(pImageData, NULL, NULL, &matches);
+    }
+
+    void TImageComparer::CompareTransformed(TImageDataPtr pImageData, TImageData *pTransformed, TUInt8 *pBuffer, TImageMatches *pMatches)
+    {
+        Compare(pImageData, pImageData, AD_TRANSFORM_TURN_0, pMatches);
+        if(m_pOptions->compare.transformedImage == TRUE)
+        {
+            *pTransformed = *pImageData;
             for(int i_transform = AD_TRANSFORM_TURN_90; i_transform < AD_TRANSFORM_SIZE; i_transform++)
             {
-                m_pTransformedImageData->Turn(m_pBuffer);
+                pTransformed->Turn(pBuffer);
                 if(i_transform == AD_TRANSFORM_MIRROR_TURN_0)
-                    m_pTransformedImageData->Mirror(m_pBuffer);
-                Compare(pImageData, m_pTransformedImageData, (adTransformType)i_transform);
+                    pTransformed->Mirror(pBuffer);
+                Compare(pImageData, pTransformed, (adTransformType)i_transform, pMatches);
             }
         }
-        if(add)
-            Add(pImageData);
     }
 
 	// Переданное изображение свравнивается с набором проверенных и остальных.
 	// pOriginal - оригинальное изображение.
 	// pTransformed - трансформированное, если применяется трансформация или то же что и оригинальное.
-    void TImageComparer::CompareWithSet(const Set &set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform)
+	// pMatches - список для результатов запроса, если NULL, то пары добавляются в результаты поиска (или в ближайшие).
+    void TImageComparer::CompareWithSet(const Set &set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
     {
         double difference;
 		// Если картинка не в проверенных
@@ -124,28 +215,116 @@ namespace ad
             for(TImageDataPtrList::const_iterator i = set.valid.begin(); i != set.valid.end(); ++i)
             {
                 if(IsDuplPair(pTransformed, *i, &difference))
-                    m_pResult->AddDuplImagePair(pOriginal, *i, difference, transform);
+                    Found(pOriginal, *i, difference, transform, pMatches);
             }
         }
 		// Сравниваем с набором остальных
 		for(TImageDataPtrList::const_iterator i = set.other.begin(); i != set.other.end(); ++i)
 		{
 			if(IsDuplPair(pTransformed, *i, &difference))
-				m_pResult->AddDuplImagePair(pOriginal, *i, difference, transform);
+				Found(pOriginal, *i, difference, transform, pMatches);
+		}
+	}
+
+	void TImageComparer::Found(TImageDataPtr pOriginal, TImageDataPtr pImageData, double difference, adTransformType transform, TImageMatches *pMatches)
+	{
+		if(pMatches)
+			pMatches->push_back(TImageMatch(pImageData, difference, transform));
+		else if(m_pClusters && m_pClusters->Join(pOriginal, pImageData, difference, transform))
+			return;
+		else if(m_pNearest)
+			m_pNearest->Add(pOriginal, pImageData, difference, transform);
+		else
+			m_pResult->AddDuplImagePair(pOriginal, pImageData, difference, transform);
+	}
+
+	// Изображения вне путей поиска (index == AD_IS_NOT_EXIST) получают роль 0.
+	size_t TImageComparer::Role(TImageDataPtr pImageData) const
+	{
+		if(m_roleCount == 1 || pImageData->index == AD_IS_NOT_EXIST)
+			return 0;
+		return std::min(pImageData->index + 1, m_roleCount - 1);
+	}
+
+	void TImageComparer::Resize(size_t setCount)
+	{
+		size_t capacity = m_sets.capacity();
+		m_sets.resize(setCount);
+		if(m_sets.capacity() > capacity)
+		{
+			size_t memory = (m_sets.capacity() - capacity)*sizeof(Sets);
+			TMemoryCounters::Add(AD_MEMORY_COMPARER, memory);
+			m_memory += memory;
 		}
 	}
 
-	void TImageComparer::AddToSet(Set &set, TImageDataPtr pImageData)
+	TImageComparer::Set* TImageComparer::FindSet(size_t set, size_t role)
 	{
+		Sets &sets = m_sets[set];
+		for(size_t i = 0; i < sets.size(); ++i)
+		{
+			if(sets[i].role == role)
+				return &sets[i];
+		}
+		return NULL;
+	}
+
+	void TImageComparer::AddToSet(size_t set, TImageDataPtr pImageData)
+	{
+		size_t role = Role(pImageData);
+		Set *pRoleSet = FindSet(set, role);
+		if(pRoleSet == NULL)
+		{
+			Sets &sets = m_sets[set];
+			size_t capacity = sets.capacity();
+			sets.push_back(Set(role));
+			size_t memory = (sets.capacity() - capacity)*sizeof(Set) + 2*TMemoryCounters::ListNode(sizeof(TImageDataPtr));
+			TMemoryCounters::Add(AD_MEMORY_COMPARER, memory);
+			m_memory += memory;
+			pRoleSet = &sets.back();
+		}
+		Set &roleSet = *pRoleSet;
 		if(pImageData->valid)
-			set.valid.push_back(pImageData);
+			roleSet.valid.push_back(pImageData);
 		else
-			set.other.push_back(pImageData);
+			roleSet.other.push_back(pImageData);
+		TMemoryCounters::Add(AD_MEMORY_COMPARER, TMemoryCounters::ListNode(sizeof(TImageDataPtr)));
+		m_memory += TMemoryCounters::ListNode(sizeof(TImageDataPtr));
+    }
+
+	void TImageComparer::RemoveFromSet(size_t set, TImageDataPtr pImageData)
+	{
+		Set *pRoleSet = FindSet(set, Role(pImageData));
+		if(pRoleSet == NULL)
+			return;
+		Set &roleSet = *pRoleSet;
+		size_t size = roleSet.valid.size() + roleSet.other.size();
+		roleSet.valid.remove(pImageData);
+		roleSet.other.remove(pImageData);
+		size_t memory = (size - roleSet.valid.size() - roleSet.other.size())*TMemoryCounters::ListNode(sizeof(TImageDataPtr));
+		TMemoryCounters::Remove(AD_MEMORY_COMPARER, memory);
+		m_memory -= memory;
     }
 
+	// Наборы своей роли пропускаются целиком: их изображения все равно отбросила бы проверка индекса пути в IsDuplPair.
+	void TImageComparer::CompareWithSet(size_t set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
+	{
+		const Sets &sets = m_sets[set];
+		bool skipOwn = m_roleCount > 1;
+		size_t role = Role(pTransformed);
+		for(size_t i = 0; i < sets.size(); ++i)
+		{
+			if(!skipOwn || sets[i].role != role)
+				CompareWithSet(sets[i], pOriginal, pTransformed, transform, pMatches);
+		}
+	}
+
 	// Сравнение двух картинок
 	bool TImageComparer::IsDuplPair(TImageDataPtr pFirst, TImageDataPtr pSecond, double *pDifference)
 	{
+		if(m_counting)
+			m_visitedCount++;
+
 		if(m_pOptions->compare.typeControl == TRUE && 
 			pFirst->type != pSecond->type)
 			return false;
@@ -164,15 +343,21 @@ namespace ad
 		if(m_pOptions->compare.compareInsideOneFolder == FALSE && TPath::EqualByDirectory(pFirst->path, pSecond->path))
 			return false;
 
-		if(m_pOptions->compare.compareInsideOneSearchPath == FALSE && pFirst->index == pSecond->index)
+		if(m_separateSearchPaths && pFirst->index == pSecond->index)
 			return false;
 
 		uint64_t fastDifference = 0;
 		SimdSquaredDifferenceSum(pFirst->data->fast, FAST_DATA_SIZE, pSecond->data->fast, FAST_DATA_SIZE, 
 			FAST_DATA_SIZE, 1, &fastDifference);
 		if(fastDifference > m_fastThreshold)
+		{
+			if(m_counting)
+				m_prunedCount++;
 			return false;
+		}
 
+		if(m_counting)
+			m_mainCount++;
         uint64_t mainDifference = 0;
         if(m_pOptions->advanced.ignoreFrameWidth > 0)
         {
@@ -196,36 +381,46 @@ namespace ad
     TImageComparer_0D::TImageComparer_0D(TEngine *pEngine)
         :TImageComparer(pEngine)
     {
-        m_sets.resize(1);
+        Resize(1);
     }
 
     void TImageComparer_0D::Add(TImageDataPtr pImageData)
     {
-        AddToSet(m_sets[0], pImageData);
+        AddToSet(0, pImageData);
     }
 
-    void TImageComparer_0D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform)
+    void TImageComparer_0D::Remove(TImageDataPtr pImageData)
     {
-        CompareWithSet(m_sets[0], pOriginal, pTransformed, transform);
+        RemoveFromSet(0, pImageData);
+    }
+
+    void TImageComparer_0D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
+    {
+        CompareWithSet(0, pOriginal, pTransformed, transform, pMatches);
     }
     //-------------------------------------------------------------------------
     TImageComparer_1D::TImageComparer_1D(TEngine *pEngine)
         :TImageComparer(pEngine)
     {
-        m_sets.resize(RANGE);
+        Resize(RANGE);
         m_halfCompareRange = (int)ceil(0.5 + double(RANGE)*m_pOptions->compare.thresholdDifference/DENOMINATOR);
     }
 
     void TImageComparer_1D::Add(TImageDataPtr pImageData)
     {
-        AddToSet(m_sets[GetIndex(pImageData)], pImageData);
+        AddToSet(GetIndex(pImageData), pImageData);
     }
 
-    void TImageComparer_1D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform)
+    void TImageComparer_1D::Remove(TImageDataPtr pImageData)
+    {
+        RemoveFromSet(GetIndex(pImageData), pImageData);
+    }
+
+    void TImageComparer_1D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
     {
         int index = GetIndex(pTransformed);
         for(int i = std::max(0, index - m_halfCompareRange), end = std::min(index + m_halfCompareRange, RANGE); i < end; ++i)
-            CompareWithSet(m_sets[i], pOriginal, pTransformed, transform);
+            CompareWithSet(i, pOriginal, pTransformed, transform, pMatches);
     }
 
     int TImageComparer_1D::GetIndex(TImageDataPtr pImageData)
@@ -254,7 +449,7 @@ namespace ad
         m_stride.x = m_range.y;
         m_stride.y = 1;
 
-        m_sets.resize(m_range.s*m_range.x*m_range.y);
+        Resize(m_range.s*m_range.x*m_range.y);
         m_halfCompareRange = (int)ceil(0.5 + double(m_maxRange)*m_pOptions->compare.thresholdDifference/DENOMINATOR);
     }
 
@@ -262,10 +457,17 @@ namespace ad
     {
         TIndex i;
         GetIndex(pImageData, i);
-        AddToSet(m_sets[i.s*m_stride.s + i.x*m_stride.x + i.y*m_stride.y], pImageData);
+        AddToSet(i.s*m_stride.s + i.x*m_stride.x + i.y*m_stride.y, pImageData);
+    }
+
+    void TImageComparer_3D::Remove(TImageDataPtr pImageData)
+    {
+        TIndex i;
+        GetIndex(pImageData, i);
+        RemoveFromSet(i.s*m_stride.s + i.x*m_stride.x + i.y*m_stride.y, pImageData);
     }
 
-    void TImageComparer_3D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform)
+    void TImageComparer_3D::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
     {
         TIndex i, lo, hi;
         GetIndex(pTransformed, i);
@@ -284,7 +486,7 @@ namespace ad
             {
                 for(int y = lo.y; y < hi.y; y += m_stride.y)
                 {
-                    CompareWithSet(m_sets[s + x + y], pOriginal, pTransformed, transform);
+                    CompareWithSet(s + x + y, pOriginal, pTransformed, transform, pMatches);
                 }
             }
         }
@@ -315,22 +517,55 @@ namespace ad
 		//константы
 		C1 = (float)pow(0.01 * PIXEL_MAX_DIFFERENCE, 2);
         C2 = (float)pow(0.03 * PIXEL_MAX_DIFFERENCE, 2);
-        m_sets.resize(1);
+        Resize(1);
     }
 
     void TImageComparer_SSIM::Add(TImageDataPtr pImageData)
     {
-        AddToSet(m_sets[0], pImageData);
+        AddToSet(0, pImageData);
     }
 
-    void TImageComparer_SSIM::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform)
+    void TImageComparer_SSIM::Remove(TImageDataPtr pImageData)
     {
-        CompareWithSet(m_sets[0], pOriginal, pTransformed, transform);
+        RemoveFromSet(0, pImageData);
+    }
+
+    void TImageComparer_SSIM::Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches)
+    {
+        CompareWithSet(0, pOriginal, pTransformed, transform, pMatches);
+    }
+
+	// Среднее и дисперсия вычисляются до сравнения, чтобы IsDuplPair не изменял изображения из набора. 
+	// stored - изображение из хранилища, его данные нужно будет сохранить.
+    void TImageComparer_SSIM::Prepare(TImageDataPtr pImageData, bool stored)
+    {
+		const int side = m_pOptions->advanced.reducedImageSize;
+		if (pImageData->data->average == 0)
+		{
+			uint64_t sum = 0;
+			SimdValueSum(pImageData->data->main, side, side, side, &sum);
+			pImageData->data->average = (float)sum / (side * side);
+			if(stored)
+				m_pImageDataStorage->SetSaveState(true);
+		}
+
+		if (pImageData->data->varianceSquare == 0)
+		{
+			uint64_t sumSquare = 0;
+			SimdSquareSum(pImageData->data->main, side, side, side, &sumSquare);
+			float averageSquare = (float)sumSquare / (side * side);
+			pImageData->data->varianceSquare = fabs(averageSquare - (pImageData->data->average * pImageData->data->average));
+			if(stored)
+				m_pImageDataStorage->SetSaveState(true);
+		}
     }
 
 	// Сравнение двух картинок SSIM методом
     bool TImageComparer_SSIM::IsDuplPair(TImageDataPtr pFirst, TImageDataPtr pSecond, double *pDifference)
     {
+		if(m_counting)
+			m_visitedCount++;
+
         if(m_pOptions->compare.typeControl == TRUE && 
             pFirst->type != pSecond->type)
             return false;
@@ -349,46 +584,11 @@ namespace ad
         if(m_pOptions->compare.compareInsideOneFolder == FALSE && TPath::EqualByDirectory(pFirst->path, pSecond->path))
             return false;
 
-		if(m_pOptions->compare.compareInsideOneSearchPath == FALSE && pFirst->index == pSecond->index)
+		if(m_separateSearchPaths && pFirst->index == pSecond->index)
             return false;
 
-		if (pFirst->data->average == 0)
-		{
-			uint64_t sum = 0;
-			SimdValueSum(pFirst->data->main,  m_pOptions->advanced.reducedImageSize, 
-					m_pOptions->advanced.reducedImageSize, m_pOptions->advanced.reducedImageSize, &sum);
-			pFirst->data->average = (float)sum / (m_pOptions->advanced.reducedImageSize * m_pOptions->advanced.reducedImageSize);
-			m_pImageDataStorage->SetSaveState(true);
-		}
-		if (pSecond->data->average == 0)
-		{
-			uint64_t sum = 0;
-			SimdValueSum(pSecond->data->main,  m_pOptions->advanced.reducedImageSize, 
-					m_pOptions->advanced.reducedImageSize, m_pOptions->advanced.reducedImageSize, &sum);
-			pSecond->data->average = (float)sum / (m_pOptions->advanced.reducedImageSize * m_pOptions->advanced.reducedImageSize);
-			m_pImageDataStorage->SetSaveState(true);
-		}
-
-		if (pFirst->data->varianceSquare == 0)
-		{
-			uint64_t sumSquare = 0;
-			SimdSquareSum(pFirst->data->main,  m_pOptions->advanced.reducedImageSize, 
-						m_pOptions->advanced.reducedImageSize, m_pOptions->advanced.reducedImageSize, &sumSquare);
-			float averageSquare = (float)sumSquare / (m_pOptions->advanced.reducedImageSize * m_pOptions->advanced.reducedImageSize);
-			pFirst->data->varianceSquare = fabs(averageSquare - (pFirst->data->average * pFirst->data->average));
-			m_pImageDataStorage->SetSaveState(true);
-		}
-
-		if (pSecond->data->varianceSquare == 0)
-		{
-			uint64_t sumSquare = 0;
-			SimdSquareSum(pSecond->data->main,  m_pOptions->advanced.reducedImageSize, 
-						m_pOptions->advanced.reducedImageSize, m_pOptions->advanced.reducedImageSize, &sumSquare);
-			float averageSquareSecond = (float)sumSquare / (m_pOptions->advanced.reducedImageSize * m_pOptions->advanced.reducedImageSize);
-			pSecond->data->varianceSquare = fabs(averageSquareSecond - (pSecond->data->average * pSecond->data->average));
-			m_pImageDataStorage->SetSaveState(true);
-		}
-
+		if(m_counting)
+			m_mainCount++;
         uint64_t correlationSum = 0;
         SimdCorrelationSum(
             pFirst->data->main, m_pOptions->advanced.reducedImageSize, 
@@ -419,16 +619,21 @@ namespace ad
     //-------------------------------------------------------------------------
 	// Фабрика возврашает движок
     TImageComparer* CreateImageComparer(TEngine *pEngine)
+    {
+		adStatistic statistic;
+		pEngine->Status()->Export(&statistic);
+		return CreateImageComparer(pEngine, statistic.searchedImageNumber);
+    }
+
+    TImageComparer* CreateImageComparer(TEngine *pEngine, size_t imageNumber)
     {
 		if (pEngine->Options()->compare.algorithmComparing == AD_COMPARING_SQUARED_SUM)
 		{
-			adStatistic statistic;
-			pEngine->Status()->Export(&statistic);
-			if(statistic.searchedImageNumber < D0_SEARCHED_FILE_NUMBER_MAX)
+			if(imageNumber < D0_SEARCHED_FILE_NUMBER_MAX)
 			{
 				return new TImageComparer_0D(pEngine);
 			}
-			else if(statistic.searchedImageNumber < D1_SEARCHED_FILE_NUMBER_MAX || 
+			else if(imageNumber < D1_SEARCHED_FILE_NUMBER_MAX || 
 				pEngine->Options()->compare.thresholdDifference > D3_THRESHOLD_DIFFERENCE_MAX)
 			{
 				return new TImageComparer_1D(pEngine);
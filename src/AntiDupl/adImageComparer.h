@@ -25,6 +25,7 @@
 #define __adImageComparer_h__
 
 #include <list>
+#include <vector>
 
 #include "adConfig.h"
 
@@ -34,8 +35,23 @@ namespace ad
     struct TOptions;
     class TEngine;
     class TResultStorage;
+    class TStatus;
 	class TImageDataStorage;
+	class TNearest;
+	class TClusters;
     typedef TImageData* TImageDataPtr;
+    //-------------------------------------------------------------------------
+	// Совпадение, найденное при запросе к индексу
+	struct TImageMatch
+	{
+		TImageDataPtr pImageData;
+		double difference;
+		adTransformType transform;
+
+		TImageMatch(TImageDataPtr pImageData_, double difference_, adTransformType transform_)
+			:pImageData(pImageData_), difference(difference_), transform(transform_) {}
+	};
+	typedef std::vector<TImageMatch> TImageMatches;
     //-------------------------------------------------------------------------
 	// Общий класс движка
     class TImageComparer
@@ -44,29 +60,78 @@ namespace ad
         typedef std::list<TImageDataPtr> TImageDataPtrList;
         struct Set
         {
+            size_t role;
             TImageDataPtrList valid; //проверенные
             TImageDataPtrList other;
+
+            Set(size_t role_) : role(role_) {}
         };
+        // При compareInsideOneSearchPath == FALSE наборы ведутся отдельно для каждого пути поиска 
+        // (роли), и изображение сравнивается только с наборами других путей. Ячейка индекса хранит 
+        // наборы только тех ролей, изображения которых в нее попадали, пустые ячейки память не занимают.
         typedef std::vector<Set> Sets;
-        Sets m_sets;
+        std::vector<Sets> m_sets;
+        size_t m_roleCount;
+        // Изображения одного пути поиска не сравниваются (compareInsideOneSearchPath == FALSE).
+        bool m_separateSearchPaths;
+        // Память наборов, учтенная в AD_MEMORY_COMPARER.
+        size_t m_memory;
 
         TOptions *m_pOptions;
+
+		// Счетчики для статистики поиска. Ведутся только при Accept, который вызывается из одного потока, 
+		// поэтому одновременные запросы Query к индексу их не трогают.
+        bool m_counting;
+        TUInt64 m_visitedCount;
+        TUInt64 m_prunedCount;
+        TUInt64 m_mainCount;
+
+        friend class TKernelBenchmark;
     public:
         TImageComparer(TEngine *pEngine);
         virtual ~TImageComparer();
 
         void Accept(TImageDataPtr pImageData, bool add);
 
+		// Добавление без сравнения, удаление и поиск совпадений без добавления. Query не меняет 
+		// состояние сравнивателя и может вызываться одновременно из нескольких потоков.
+        void Insert(TImageDataPtr pImageData);
+        void Erase(TImageDataPtr pImageData);
+        void Query(TImageDataPtr pImageData, TImageMatches & matches);
+
+		// Индекс не привязан к путям поиска: запрос не имеет индекса пути, а изображения библиотеки могут 
+		// лежать вне текущих searchPaths. Вызывается до добавления изображений.
+        void IgnoreSearchPaths();
+
+		// Ближайшие пары, накопленные при nearestCount > 0 вместо добавления в результаты, иначе NULL.
+        TNearest* Nearest() {return m_pNearest;}
+		// Члены кластеров при clusterThreshold > 0, иначе NULL.
+        TClusters* Clusters() {return m_pClusters;}
+
     protected:
         virtual void Add(TImageDataPtr pImageData) = 0; // pure virtual or abstract function and requires to be overwritten in an derived class
-        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform) = 0;
+        virtual void Remove(TImageDataPtr pImageData) = 0;
+        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches) = 0;
 		virtual bool IsDuplPair(TImageDataPtr pFirst, TImageDataPtr pSecond, double *pDifference); //виртуальная функция, но не обязательно ее переопределять
+		virtual void Prepare(TImageDataPtr pImageData, bool stored) {} // подготовка данных, которые не должны вычисляться при сравнении
 
-        void AddToSet(Set &set, TImageDataPtr pImageData);
-        void CompareWithSet(const Set &set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform);
+        void Resize(size_t setCount);
+        void AddToSet(size_t set, TImageDataPtr pImageData);
+        void RemoveFromSet(size_t set, TImageDataPtr pImageData);
+        void CompareWithSet(size_t set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
 
     private:
+        size_t Role(TImageDataPtr pImageData) const;
+        Set* FindSet(size_t set, size_t role);
+        void CompareWithSet(const Set &set, TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
+        void CompareTransformed(TImageDataPtr pImageData, TImageData *pTransformed, TUInt8 *pBuffer, TImageMatches *pMatches);
+        void FlushStatistic();
+        void Found(TImageDataPtr pOriginal, TImageDataPtr pImageData, double difference, adTransformType transform, TImageMatches *pMatches);
+
         TResultStorage *m_pResult;
+        TStatus *m_pStatus;
+        TNearest *m_pNearest;
+        TClusters *m_pClusters;
         TImageData *m_pTransformedImageData;
         TUInt8* m_pBuffer;
         TUInt8* m_pMask;
@@ -84,7 +149,8 @@ namespace ad
 
     protected:
         virtual void Add(TImageDataPtr pImageData);
-        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform);
+        virtual void Remove(TImageDataPtr pImageData);
+        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
     };
     //-------------------------------------------------------------------------
     class TImageComparer_1D : public TImageComparer
@@ -96,7 +162,8 @@ namespace ad
 
     protected:
         virtual void Add(TImageDataPtr pImageData);
-        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform);
+        virtual void Remove(TImageDataPtr pImageData);
+        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
 
     private:
         int GetIndex(TImageDataPtr pImageData);
@@ -113,12 +180,14 @@ namespace ad
             int x;//difference between left and right half of fast data pixels;
             int y;//difference between bottom and top half of fast data pixels;
         };
+        friend class TKernelBenchmark;
     public:
         TImageComparer_3D(TEngine *pEngine);
 
     protected:
         virtual void Add(TImageDataPtr pImageData);
-        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform);
+        virtual void Remove(TImageDataPtr pImageData);
+        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
 
     private:
         void GetIndex(TImageDataPtr pImageData, TIndex& index);
@@ -135,8 +204,10 @@ namespace ad
 
     protected:
         virtual void Add(TImageDataPtr pImageData);
-        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform);
+        virtual void Remove(TImageDataPtr pImageData);
+        virtual void Compare(TImageDataPtr pOriginal, TImageDataPtr pTransformed, adTransformType transform, TImageMatches *pMatches);
 		virtual bool IsDuplPair(TImageDataPtr pFirst, TImageDataPtr pSecond, double *pDifference);
+		virtual void Prepare(TImageDataPtr pImageData, bool stored);
 
     private:
 		float C1;
@@ -145,6 +216,7 @@ namespace ad
     };
     //-------------------------------------------------------------------------
     TImageComparer* CreateImageComparer(TEngine *pEngine);
+    TImageComparer* CreateImageComparer(TEngine *pEngine, size_t imageNumber);
     //-------------------------------------------------------------------------
 }
 #endif//__adImageComparer_h__ 
\ No newline at end of file
@@ -24,6 +24,8 @@
 #include "adOptions.h"
 #include "adImageData.h"
 #include "adIO.h"
+#include "adFileUtils.h"
+#include "adMemory.h"
 
 namespace ad
 {
@@ -56,6 +58,7 @@ namespace ad
 		data = NULL;
 		m_owner = false;
 		hGlobal = NULL;
+		TMemoryCounters::Add(AD_MEMORY_IMAGE_DATA, sizeof(TImageData));
 	}
 
 	void TImageData::SetData(size_t reducedImageSize)
@@ -79,6 +82,7 @@ namespace ad
 			delete data;
 		}
 		FreeGlobal();
+		TMemoryCounters::Remove(AD_MEMORY_IMAGE_DATA, sizeof(TImageData));
 	}
 
 	// Копируем TImageData
@@ -103,6 +107,8 @@ namespace ad
 		else
 		{
 			memcpy(data->fast, imageData.data->fast, data->full);
+			data->filled = imageData.data->filled;
+			data->decodeMode = imageData.data->decodeMode;
 			data->average = imageData.data->average;
 			data->varianceSquare = imageData.data->varianceSquare;
 		}
@@ -115,7 +121,10 @@ namespace ad
 			pOptions->defect.checkOnDefect == TRUE || 
 			pOptions->defect.checkOnBlockiness == TRUE  || 
 			pOptions->defect.checkOnBlurring == TRUE) && 
-			(!data->filled || blockiness < 0 || blurring < 0) &&
+			(!data->filled || 
+			(pOptions->defect.checkOnBlockiness == TRUE && blockiness < 0) || 
+			(pOptions->defect.checkOnBlurring == TRUE && blurring < 0) ||
+			(pOptions->advanced.useThumbnails != TRUE && data->decodeMode == DECODE_MODE_THUMBNAIL)) &&
 			type != AD_IMAGE_NONE;
 	}
 
@@ -189,7 +198,7 @@ namespace ad
 	{
 		if(hGlobal)
 		{
-			::GlobalFree(hGlobal);
+			FreeFileFromMemory(hGlobal);
 			hGlobal = NULL;
 		}
 	}
@@ -29,6 +29,7 @@
 #include "adIO.h"
 #include "adFileStream.h"
 #include "adException.h"
+#include "adTracer.h"
 
 namespace ad
 {
@@ -71,6 +72,7 @@ namespace ad
 		for(TStorage::iterator it = m_storage.begin(); it != m_storage.end(); ++it)
 			delete it->second;
 		m_storage.clear();
+		m_directoryCache.Clear();
 	}
 
 	void TImageDataStorage::Check()
@@ -117,11 +119,25 @@ namespace ad
 		return it->second;
 	}
 
+	TImageDataPtr TImageDataStorage::Lookup(const TImageInfo& imageInfo)
+	{
+		TStorage::iterator it = Find(imageInfo);
+		return it != m_storage.end() ? it->second : NULL;
+	}
+
+	void TImageDataStorage::GetAll(TImageDataPtrs & imageDataPtrs) const
+	{
+		for(TStorage::const_iterator it = m_storage.begin(); it != m_storage.end(); ++it)
+			imageDataPtrs.push_back(it->second);
+	}
+
 	adError TImageDataStorage::Load(const TChar *path, bool allLoad)
 	{
 		if(!IsDirectoryExists(path))
 			return AD_ERROR_DIRECTORY_IS_NOT_EXIST;
 
+		m_directoryCache.Load(path);
+
 		TIndex index;
 		if( LoadIndex(index, CreatePath(path, TString(INDEX_FILE_NAME) + FILE_EXTENSION).c_str(), allLoad) || 
 			LoadIndex(index, CreatePath(path, TString(BACKUP_FILE_NAME) + FILE_EXTENSION).c_str(), allLoad))
@@ -157,9 +173,12 @@ namespace ad
 
 	adError TImageDataStorage::Save(const TChar *path)
 	{
+		AD_TRACE("save image data base")
 		if(!IsDirectoryExists(path))
 			return AD_ERROR_DIRECTORY_IS_NOT_EXIST;
 
+		m_directoryCache.Save(path);
+
 		if (m_needToSave)
 		{
 			TIndex index;
@@ -186,6 +205,7 @@ namespace ad
 		if (Load(directory, true) == AD_OK)
 		{
 			DeleteFiles(directory, FILE_EXTENSION);
+			m_directoryCache.Clear();
 			
 			Check();
 
@@ -25,6 +25,7 @@
 #define __adImageDataStorage_h__
 
 #include "adImageData.h"
+#include "adDirectoryCache.h"
 
 namespace ad
 {
@@ -38,6 +39,8 @@ namespace ad
 		~TImageDataStorage() {ClearMemory();}
 
 		TImageDataPtr Get(const TImageInfo& imageInfo);
+		TImageDataPtr Lookup(const TImageInfo& imageInfo); // NULL, если изображения нет в хранилище
+		void GetAll(TImageDataPtrs & imageDataPtrs) const;
 
 		adError Load(const TChar *path, bool allLoad = false);
 		adError Save(const TChar *path);
@@ -48,6 +51,8 @@ namespace ad
 		void ClearMemory();
 		void SetSaveState(const bool needToSave);
 
+		TDirectoryCache* DirectoryCache() {return &m_directoryCache;}
+
 	private:
 		typedef std::multimap<TUInt32, TImageDataPtr> TStorage;
 		typedef std::vector<TImageDataPtr> TVector;
@@ -62,6 +67,8 @@ namespace ad
 
 		bool m_needToSave;
 
+		TDirectoryCache m_directoryCache;
+
 		struct TData
 		{
 			enum Type
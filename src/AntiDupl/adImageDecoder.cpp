@@ -0,0 +1,201 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adOptions.h"
+#include "adImageDecoder.h"
+#include "adGdiplus.h"
+#include "adOpenJpeg.h"
+#include "adPsd.h"
+#include "adDds.h"
+#include "adTga.h"
+#include "adWebp.h"
+#include "adTurboJpeg.h"
+#include "adHeif.h"
+#include "adAvif.h"
+#include "adJxl.h"
+
+namespace ad
+{
+    template <class T> static TImage* DecodeImage(HGLOBAL hGlobal)
+    {
+        return T::Load(hGlobal);
+    }
+
+    template <class T> static TImage* DecodeReducedImage(HGLOBAL hGlobal, size_t reducedSize)
+    {
+        return T::Load(hGlobal, reducedSize);
+    }
+
+    template <class T> static TImage* DecodeThumbnail(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions)
+    {
+        return T::Load(hGlobal, thumbnailSize);
+    }
+
+    // Эскиз PSD хранится в JFIF и декодируется тем же JPEG декодером, что и обычные файлы.
+    static TImage* DecodePsdThumbnail(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions)
+    {
+        return TPsd::Load(hGlobal, thumbnailSize, pOptions);
+    }
+
+    static bool SniffOpenJpeg(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        const TUInt8 j2k[2] = {0xff, 0x4f};
+        const TUInt8 jp2[4] = {0x6a, 0x50, 0x20, 0x20};
+        return (size >= 2 && memcmp(header, j2k, sizeof(j2k)) == 0) ||
+            (size >= 8 && memcmp(header + 4, jp2, sizeof(jp2)) == 0);
+    }
+
+    static bool SniffPsd(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        return size >= 4 && memcmp(header, "8BPS", 4) == 0;
+    }
+
+    static bool SniffDds(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        return size >= 4 && memcmp(header, "DDS ", 4) == 0;
+    }
+
+    static bool SniffWebp(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        return size >= 12 && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WEBP", 4) == 0;
+    }
+
+    // AVIF и HEIF используют контейнер ISO BMFF, окончательно формат определяется по списку брендов в Supported.
+    static bool SniffIsoBmff(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        return size >= 12 && memcmp(header + 4, "ftyp", 4) == 0;
+    }
+
+    static bool SniffJxl(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        const TUInt8 codestream[2] = {0xff, 0x0a};
+        const TUInt8 container[12] = {0x00, 0x00, 0x00, 0x0c, 0x4a, 0x58, 0x4c, 0x20, 0x0d, 0x0a, 0x87, 0x0a};
+        return (size >= 2 && memcmp(header, codestream, sizeof(codestream)) == 0) ||
+            (size >= 12 && memcmp(header, container, sizeof(container)) == 0);
+    }
+
+#ifdef AD_TURBO_JPEG_ENABLE
+    static bool SniffTurboJpeg(const TUInt8 * header, size_t size, const TOptions * pOptions)
+    {
+        return pOptions->advanced.useLibJpegTurbo && TTurboJpeg::Supported(header, size);
+    }
+#endif//AD_TURBO_JPEG_ENABLE
+
+    //-------------------------------------------------------------------------
+
+    TImageDecoderRegistry::TImageDecoderRegistry()
+        : m_size(0)
+        , m_fallback(DECODER_COUNT_MAX)
+    {
+        Register("OpenJpeg", SniffOpenJpeg, NULL, DecodeImage<TOpenJpeg>, DecodeReducedImage<TOpenJpeg>);
+        Register("Psd", SniffPsd, NULL, DecodeImage<TPsd>, NULL, DecodePsdThumbnail);
+        Register("Dds", SniffDds, NULL, DecodeImage<TDds>);
+        Register("Webp", SniffWebp, TWebp::Supported, DecodeImage<TWebp>);
+        Register("Avif", SniffIsoBmff, TAvif::Supported, DecodeImage<TAvif>);
+        Register("Heif", SniffIsoBmff, THeif::Supported, DecodeImage<THeif>, NULL, DecodeThumbnail<THeif>);
+        Register("Jxl", SniffJxl, NULL, DecodeImage<TJxl>, NULL, DecodeThumbnail<TJxl>);
+#ifdef AD_TURBO_JPEG_ENABLE
+        Register("TurboJpeg", SniffTurboJpeg, NULL, DecodeImage<TTurboJpeg>);
+#endif//AD_TURBO_JPEG_ENABLE
+        Register("Tga", NULL, TTga::Supported, DecodeImage<TTga>);
+        Register("Gdiplus", NULL, NULL, DecodeImage<TGdiplus>);
+    }
+
+    TImageDecoderRegistry & TImageDecoderRegistry::Instance()
+    {
+        static TImageDecoderRegistry registry;
+        return registry;
+    }
+
+    bool TImageDecoderRegistry::Register(const char * name, TSniff sniff, TSupported supported, TLoad load, 
+        TLoadReduced loadReduced, TLoadThumbnail loadThumbnail)
+    {
+        TCriticalSection::TLocker locker(&m_cs);
+        if((size_t)m_size >= DECODER_COUNT_MAX || load == NULL)
+            return false;
+        TDecoder & decoder = m_decoders[m_size];
+        decoder.name = name;
+        decoder.sniff = sniff;
+        decoder.supported = supported;
+        decoder.load = load;
+        decoder.loadReduced = loadReduced;
+        decoder.loadThumbnail = loadThumbnail;
+        if(sniff == NULL && supported == NULL)
+            m_fallback = m_size;
+        ::InterlockedIncrement(&m_size); // новая запись становится видимой только после заполнения
+        return true;
+    }
+
+    size_t TImageDecoderRegistry::Find(HGLOBAL hGlobal, const TOptions * pOptions) const
+    {
+        TUInt8 header[HEADER_SIZE];
+        size_t size = std::min<size_t>(::GlobalSize(hGlobal), HEADER_SIZE);
+        const void * data = ::GlobalLock(hGlobal);
+        if(data == NULL)
+            return m_fallback;
+        memcpy(header, data, size);
+        ::GlobalUnlock(hGlobal);
+
+        const size_t count = m_size;
+        for(size_t i = 0; i < count; ++i)
+        {
+            const TDecoder & decoder = m_decoders[i];
+            if(decoder.sniff && decoder.sniff(header, size, pOptions) && 
+                (decoder.supported == NULL || decoder.supported(hGlobal)))
+                return i;
+        }
+        for(size_t i = 0; i < count; ++i)
+        {
+            const TDecoder & decoder = m_decoders[i];
+            if(decoder.sniff == NULL && decoder.supported && decoder.supported(hGlobal))
+                return i;
+        }
+        return m_fallback;
+    }
+
+    TImage* TImageDecoderRegistry::Load(size_t index, HGLOBAL hGlobal, const TOptions * pOptions, size_t reducedSize, size_t thumbnailSize)
+    {
+        const TDecoder & decoder = m_decoders[index];
+        if(thumbnailSize && decoder.loadThumbnail)
+            return decoder.loadThumbnail(hGlobal, thumbnailSize, pOptions);
+        else if(reducedSize && decoder.loadReduced)
+            return decoder.loadReduced(hGlobal, reducedSize);
+        else
+            return decoder.load(hGlobal);
+    }
+
+    TImage* TImageDecoderRegistry::Load(HGLOBAL hGlobal, const TOptions * pOptions, size_t reducedSize, size_t thumbnailSize)
+    {
+        if(hGlobal == NULL)
+            return NULL;
+        size_t index = Find(hGlobal, pOptions);
+        if(index >= (size_t)m_size)
+            return NULL;
+        if(pOptions == NULL || pOptions->advanced.useThumbnails == FALSE)
+            thumbnailSize = 0;
+        TImage * pImage = Load(index, hGlobal, pOptions, reducedSize, thumbnailSize);
+        if(pImage == NULL && index != m_fallback && m_fallback < (size_t)m_size)
+            pImage = Load(m_fallback, hGlobal, pOptions, reducedSize, thumbnailSize); // например, CMYK JPEG, который не поддерживает libjpeg-turbo
+        return pImage;
+    }
+}
@@ -0,0 +1,86 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adImageDecoder_h__
+#define __adImageDecoder_h__
+
+#include "adThreads.h"
+#include "adImage.h"
+
+namespace ad
+{
+    struct TOptions;
+
+    //-------------------------------------------------------------------------
+
+    // Реестр декодеров: заголовок файла читается один раз, после чего сразу вызывается нужный кодек.
+    class TImageDecoderRegistry
+    {
+    public:
+        static const size_t HEADER_SIZE = 32;
+        static const size_t DECODER_COUNT_MAX = 32;
+
+        // Быстрая проверка по сигнатуре в первых HEADER_SIZE байтах файла.
+        typedef bool (*TSniff)(const TUInt8 * header, size_t size, const TOptions * pOptions);
+        // Полная (более дорогая) проверка поддержки по содержимому всего файла.
+        typedef bool (*TSupported)(HGLOBAL hGlobal);
+        typedef TImage* (*TLoad)(HGLOBAL hGlobal);
+        // Загрузка уменьшенного изображения, меньшая сторона которого не меньше reducedSize.
+        typedef TImage* (*TLoadReduced)(HGLOBAL hGlobal, size_t reducedSize);
+        // Загрузка встроенного эскиза, меньшая сторона которого не меньше thumbnailSize.
+        typedef TImage* (*TLoadThumbnail)(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions);
+
+        // Декодер без sniff проверяется через supported только если ни одна сигнатура не подошла.
+        // Декодер без sniff и supported используется как запасной, если остальные не справились.
+        // loadThumbnail используется только при включенной опции useThumbnails.
+        bool Register(const char * name, TSniff sniff, TSupported supported, TLoad load, 
+            TLoadReduced loadReduced = NULL, TLoadThumbnail loadThumbnail = NULL);
+
+        TImage* Load(HGLOBAL hGlobal, const TOptions * pOptions, size_t reducedSize = 0, size_t thumbnailSize = 0);
+
+        static TImageDecoderRegistry & Instance();
+
+    private:
+        TImageDecoderRegistry();
+
+        struct TDecoder
+        {
+            const char * name;
+            TSniff sniff;
+            TSupported supported;
+            TLoad load;
+            TLoadReduced loadReduced;
+            TLoadThumbnail loadThumbnail;
+        };
+
+        size_t Find(HGLOBAL hGlobal, const TOptions * pOptions) const;
+        TImage* Load(size_t index, HGLOBAL hGlobal, const TOptions * pOptions, size_t reducedSize, size_t thumbnailSize);
+
+        TDecoder m_decoders[DECODER_COUNT_MAX];
+        volatile LONG m_size;
+        size_t m_fallback;
+        TCriticalSection m_cs;
+    };
+}
+
+#endif//__adImageDecoder_h__
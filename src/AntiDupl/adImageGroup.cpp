@@ -133,93 +133,219 @@ namespace ad
 			m_map[it->first] = new TImageGroup(*it->second);
 	}
 
+	// Система непересекающихся множеств (union-find) со сжатием путей и объединением по рангу.
+	class TDisjointSets
+	{
+	public:
+		TDisjointSets(size_t size)
+			: m_parent(size)
+			, m_rank(size, 0)
+		{
+			for(size_t i = 0; i < size; ++i)
+				m_parent[i] = i;
+		}
+
+		size_t Find(size_t i)
+		{
+			size_t root = i;
+			while(m_parent[root] != root)
+				root = m_parent[root];
+			while(m_parent[i] != root)
+			{
+				size_t next = m_parent[i];
+				m_parent[i] = root;
+				i = next;
+			}
+			return root;
+		}
+
+		void Union(size_t a, size_t b)
+		{
+			a = Find(a);
+			b = Find(b);
+			if(a == b)
+				return;
+			if(m_rank[a] < m_rank[b])
+				std::swap(a, b);
+			m_parent[b] = a;
+			if(m_rank[a] == m_rank[b])
+				m_rank[a]++;
+		}
+
+	private:
+		std::vector<size_t> m_parent;
+		std::vector<TUInt8> m_rank;
+	};
+
 	// Устанавливает в переданном списке результатов группы из внутреннего хранилища групп и очищает его.
+	// Изображения - вершины графа, результаты - ребра; группа - компонента связности.
 	void TImageGroupStorage::Set(TResultPtrVector & results, TStatus * pStatus)
 	{
 		pStatus->SetProgress(0, 0);
-		size_t current = 0, total = results.size(), groupId = 0;
+		size_t current = 0, total = results.size()*3;
 		Clear();
-		// Идем по списку результатов
+
+		// Нумеруем изображения из необработанных результатов. Номер вершины временно хранится в поле group.
+		TResultPtrVector undefined;
+		undefined.reserve(results.size());
 		for(TResultPtrVector::iterator it = results.begin(); it != results.end(); ++it)
 		{
-			pStatus->SetProgress(current++, total);
 			TResultPtr pResult = *it;
 			if(pResult->group == AD_UNDEFINED)
 			{
+				pResult->first->group = AD_UNDEFINED;
 				if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR)
-				{
-					// Если обе группы не определены, находим ее с хранилише и заполняем значения.
-					if(pResult->first->group == AD_UNDEFINED && pResult->second->group == AD_UNDEFINED)
-					{
-						TImageGroup * pGroup = Get(groupId++);
-						pResult->group = pGroup->id;
-						pResult->first->group = pGroup->id;
-						pResult->second->group = pGroup->id;
-					}
-					else
-					{
-						// Если первая группа не определена, копируем значения из второй
-						if(pResult->first->group == AD_UNDEFINED)
-						{
-							pResult->group = pResult->second->group;
-							pResult->first->group = pResult->second->group;
-						}
-						else if(pResult->second->group == AD_UNDEFINED)
-						{
-							pResult->group = pResult->first->group;
-							pResult->second->group = pResult->first->group;
-						}
-						else if(pResult->first->group == pResult->second->group)
-						{
-							pResult->group = pResult->first->group;
-						}
-						else
-						{
-							TImageGroup * src = Get(std::min(pResult->first->group, pResult->second->group));
-							TImageGroup * dst = Get(std::max(pResult->first->group, pResult->second->group));
-							for(TResultPtrList::iterator srcIt = src->results.begin(); srcIt != src->results.end(); ++srcIt)
-							{
-								(*srcIt)->group = dst->id;
-								(*srcIt)->first->group = dst->id;
-								if((*srcIt)->type == AD_RESULT_DUPL_IMAGE_PAIR)
-									(*srcIt)->second->group = dst->id;
-								dst->results.push_back(*srcIt);
-							}
-							Erase(src->id);
-							pResult->group = dst->id;
-						}
-					}
-				}
-				else
-				{
-					if(pResult->first->group == AD_UNDEFINED)
-					{
-						TImageGroup * pGroup = Get(groupId++);
-						pResult->group = pGroup->id;
-						pResult->first->group = pGroup->id;
-					}
-					else
-					{
-						pResult->group = pResult->first->group;
-					}
-				}
-				Get(pResult->group)->results.push_back(pResult);
+					pResult->second->group = AD_UNDEFINED;
+				undefined.push_back(pResult);
+			}
+		}
+		TImageInfoPtrVector images;
+		images.reserve(undefined.size()*2);
+		for(size_t i = 0; i < undefined.size(); ++i)
+		{
+			pStatus->SetProgress(current++, total);
+			TResultPtr pResult = undefined[i];
+			if(pResult->first->group == AD_UNDEFINED)
+			{
+				pResult->first->group = images.size();
+				images.push_back(pResult->first);
+			}
+			if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR && pResult->second->group == AD_UNDEFINED)
+			{
+				pResult->second->group = images.size();
+				images.push_back(pResult->second);
 			}
 		}
 
-		for(TMap::iterator groupIt = m_map.begin(); groupIt != m_map.end(); ++groupIt)
+		// Объединение выполняется в одном потоке. Лес на каждый поток занимал бы массив на все изображения, а при 
+		// слиянии каждое его ребро пришлось бы повторить в общем лесу, что стоит столько же, сколько сами объединения. 
+		// 10 млн случайных пар объединяются примерно за секунду, дороже обходятся сами результаты и группы.
+		TDisjointSets sets(images.size());
+		for(size_t i = 0; i < undefined.size(); ++i)
 		{
-			TImageGroupPtr pImageGroup = groupIt->second;
-			pImageGroup->UpdateImages();
+			pStatus->SetProgress(current++, total);
+			TResultPtr pResult = undefined[i];
+			if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR)
+				sets.Union(pResult->first->group, pResult->second->group);
+		}
+
+		// Идентификаторы групп выдаются в порядке первого появления в списке результатов.
+		std::vector<size_t> groupOfRoot(images.size(), AD_UNDEFINED);
+		std::vector<size_t> groupOfResult(undefined.size());
+		TVector groups;
+		for(size_t i = 0; i < undefined.size(); ++i)
+		{
+			pStatus->SetProgress(current++, total);
+			size_t root = sets.Find(undefined[i]->first->group);
+			if(groupOfRoot[root] == AD_UNDEFINED)
+			{
+				groupOfRoot[root] = groups.size();
+				groups.push_back(new TImageGroup(groups.size()));
+			}
+			groupOfResult[i] = groupOfRoot[root];
+		}
+
+		for(size_t i = 0; i < images.size(); ++i)
+		{
+			TImageGroupPtr pImageGroup = groups[groupOfRoot[sets.Find(i)]];
+			pImageGroup->images.push_back(images[i]);
+			images[i]->group = pImageGroup->id;
+		}
+
+		for(size_t i = 0; i < undefined.size(); ++i)
+		{
+			TResultPtr pResult = undefined[i];
+			TImageGroupPtr pImageGroup = groups[groupOfResult[i]];
+			pResult->group = pImageGroup->id;
+			pImageGroup->results.push_back(pResult);
+		}
+
+		for(size_t i = 0; i < groups.size(); ++i)
+		{
+			// Порядок изображений такой же, как в TImageGroup::UpdateImages.
+			std::sort(groups[i]->images.begin(), groups[i]->images.end());
+			m_map.insert(m_map.end(), TMap::value_type(groups[i]->id, groups[i]));
 		}
 
 		SetGroupSize(results);
 
-		UpdateVector();
+		m_vector.swap(groups);
 
 		pStatus->Reset();
 	}
 
+	// Восстанавливаем группы по сводке, сохраненной в файле результатов, без поиска компонент связности.
+	// Возвращает false, если сводка не согласуется с результатами.
+	bool TImageGroupStorage::Set(TResultPtrVector & results, const TImageGroupSummary * summaries, size_t count)
+	{
+		Clear();
+
+		TVector groups;
+		groups.reserve(count);
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(i && summaries[i].id <= summaries[i - 1].id)
+				break;
+			TImageGroupPtr pImageGroup = new TImageGroup((size_t)summaries[i].id);
+			pImageGroup->images.reserve((size_t)summaries[i].imageCount);
+			groups.push_back(pImageGroup);
+			m_map.insert(m_map.end(), TMap::value_type(pImageGroup->id, pImageGroup));
+		}
+		bool valid = groups.size() == count;
+
+		for(size_t i = 0; i < results.size() && valid; ++i)
+		{
+			TResultPtr pResult = results[i];
+			TMap::iterator it = m_map.find(pResult->group);
+			if(it == m_map.end())
+			{
+				valid = false;
+				break;
+			}
+			TImageGroupPtr pImageGroup = it->second;
+			pImageGroup->results.push_back(pResult);
+			pImageGroup->images.push_back(pResult->first);
+			if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR)
+				pImageGroup->images.push_back(pResult->second);
+		}
+
+		for(size_t i = 0; i < groups.size() && valid; ++i)
+		{
+			// Порядок изображений такой же, как в TImageGroup::UpdateImages.
+			TImageInfoPtrVector & images = groups[i]->images;
+			std::sort(images.begin(), images.end());
+			images.erase(std::unique(images.begin(), images.end()), images.end());
+			valid = images.size() == summaries[i].imageCount && groups[i]->results.size() == summaries[i].resultCount;
+		}
+
+		if(!valid)
+		{
+			Clear();
+			m_vector.clear();
+			return false;
+		}
+
+		SetGroupSize(results);
+
+		m_vector.swap(groups);
+
+		return true;
+	}
+
+	void TImageGroupStorage::GetSummary(TImageGroupSummaryVector & summaries) const
+	{
+		summaries.clear();
+		summaries.reserve(m_map.size());
+		for(TMap::const_iterator it = m_map.begin(); it != m_map.end(); ++it)
+		{
+			TImageGroupSummary summary;
+			summary.id = it->first;
+			summary.imageCount = it->second->images.size();
+			summary.resultCount = it->second->results.size();
+			summaries.push_back(summary);
+		}
+	}
+
 	// Обновляем содержимое хранилиша групп в соответсвие с переданными результатами.
 	void TImageGroupStorage::Update(TResultPtrVector & results)
 	{
@@ -256,6 +382,48 @@ namespace ad
 		UpdateVector();
 	}
 
+	// Обновляем только группы переданных результатов: удаляем их из групп или добавляем обратно.
+	void TImageGroupStorage::Update(const TResultPtrList & changed, bool insert)
+	{
+		size_t groupCount = m_map.size();
+		std::vector<size_t> touched;
+		touched.reserve(changed.size());
+		for(TResultPtrList::const_iterator it = changed.begin(); it != changed.end(); ++it)
+		{
+			TResultPtr pResult = *it;
+			TImageGroupPtr pImageGroup = Get(pResult->group, insert);
+			if(pImageGroup == NULL)
+				continue;
+			if(insert)
+				pImageGroup->results.push_back(pResult);
+			else
+				pImageGroup->results.remove(pResult);
+			touched.push_back(pResult->group);
+		}
+		std::sort(touched.begin(), touched.end());
+		touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+		for(size_t i = 0; i < touched.size(); ++i)
+		{
+			TImageGroupPtr pImageGroup = Get(touched[i], false);
+			if(pImageGroup->results.empty())
+			{
+				Erase(touched[i]);
+				continue;
+			}
+			pImageGroup->UpdateImages();
+			pImageGroup->invalidHint = true;
+			for(TResultPtrList::iterator it = pImageGroup->results.begin(); it != pImageGroup->results.end(); ++it)
+			{
+				TResultPtr pResult = *it;
+				pResult->groupSize = pResult->type == AD_RESULT_DUPL_IMAGE_PAIR ? pImageGroup->images.size() : 1;
+			}
+		}
+
+		if(m_map.size() != groupCount)
+			UpdateVector();
+	}
+
 	void TImageGroupStorage::UpdateHints(TOptions *pOptions, bool force, TStatus * pStatus)
 	//void TImageGroupStorage::UpdateHints(TOptions *pOptions, bool force)
 	{
@@ -62,6 +62,15 @@ namespace ad
 		bool Export(adGroupPtr pGroup) const;
 	};
 	typedef TImageGroup* TImageGroupPtr;
+
+	// Сводка о группе, сохраняемая в файле результатов.
+	struct TImageGroupSummary
+	{
+		TUInt64 id;
+		TUInt64 imageCount;
+		TUInt64 resultCount;
+	};
+	typedef std::vector<TImageGroupSummary> TImageGroupSummaryVector;
 	//-------------------------------------------------------------------------
 	class TImageGroupStorage
 	{
@@ -73,7 +82,10 @@ namespace ad
 
 		void Assign(const TImageGroupStorage & storage);
 		void Set(TResultPtrVector & results, TStatus * pStatus);
+		bool Set(TResultPtrVector & results, const TImageGroupSummary * summaries, size_t count);
+		void GetSummary(TImageGroupSummaryVector & summaries) const;
 		void Update(TResultPtrVector & results);
+		void Update(const TResultPtrList & changed, bool insert);
 		void UpdateHints(TOptions *pOptions, bool force, TStatus *pStatus);
 
 		adError Export(adSizePtr pStartFrom, adGroupPtr pGroup, adSizePtr pGroupSize) const;
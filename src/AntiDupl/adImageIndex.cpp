@@ -0,0 +1,248 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <algorithm>
+#include <functional>
+
+#include "adEngine.h"
+#include "adOptions.h"
+#include "adImageData.h"
+#include "adImageDataStorage.h"
+#include "adDataCollector.h"
+#include "adFileUtils.h"
+#include "adPerformance.h"
+#include "adImageIndex.h"
+
+namespace ad
+{
+	static bool LesserByImage(const TImageMatch & match1, const TImageMatch & match2)
+	{
+		if(match1.pImageData != match2.pImageData)
+			return std::less<TImageDataPtr>()(match1.pImageData, match2.pImageData);
+		return match1.difference < match2.difference;
+	}
+
+	static bool LesserByDifference(const TImageMatch & match1, const TImageMatch & match2)
+	{
+		return match1.difference < match2.difference;
+	}
+
+	template<class TMatchPtr> adError ExportMatches(const TImageMatches & matches, TMatchPtr pMatch, adSizePtr pMatchSize)
+	{
+		if(pMatch == NULL || pMatchSize == NULL)
+			return AD_ERROR_INVALID_POINTER;
+
+		size_t size = std::min(*pMatchSize, matches.size());
+		for(size_t i = 0; i < size; ++i, ++pMatch)
+		{
+			matches[i].pImageData->Export(&pMatch->image);
+			pMatch->difference = matches[i].difference;
+			pMatch->transform = matches[i].transform;
+		}
+		*pMatchSize = size;
+		return AD_OK;
+	}
+	//-------------------------------------------------------------------------
+	TImageIndex::TImageIndex(TEngine *pEngine)
+		:m_pEngine(pEngine),
+		m_pOptions(pEngine->Options()),
+		m_pImageDataStorage(pEngine->ImageDataStorage()),
+		m_pComparer(NULL)
+	{
+	}
+
+	TImageIndex::~TImageIndex()
+	{
+		delete m_pComparer;
+	}
+
+	// Изображения остаются во владении хранилища, поэтому индекс нужно очищать до любого его изменения.
+	void TImageIndex::Assign(const TImageDataPtrs & imageDataPtrs)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		TReadWriteLock::TWriter writer(&m_lock);
+		delete m_pComparer;
+		m_pComparer = CreateImageComparer(m_pEngine, imageDataPtrs.size());
+		m_pComparer->IgnoreSearchPaths();
+		for(TImageDataPtrs::const_iterator it = imageDataPtrs.begin(); it != imageDataPtrs.end(); ++it)
+		{
+			TImageDataPtr pImageData = *it;
+			if(pImageData->type > AD_IMAGE_NONE && pImageData->data->filled)
+			{
+				pImageData->FillOther(m_pOptions);
+				m_pComparer->Insert(pImageData);
+			}
+		}
+	}
+
+	void TImageIndex::Clear()
+	{
+		TReadWriteLock::TWriter writer(&m_lock);
+		delete m_pComparer;
+		m_pComparer = NULL;
+	}
+
+	bool TImageIndex::Opened()
+	{
+		TReadWriteLock::TReader reader(&m_lock);
+		return m_pComparer != NULL;
+	}
+
+	adError TImageIndex::Create(const TString & fileName, TImageDataPtr & pQuery) const
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		if(!IsFileExists(fileName.c_str()))
+			return AD_ERROR_FILE_IS_NOT_EXIST;
+
+		pQuery = new TImageData(TImageInfo(fileName), m_pOptions->advanced.reducedImageSize);
+		pQuery->hGlobal = LoadFileToMemory(fileName.c_str());
+		if(pQuery->hGlobal == NULL)
+		{
+			delete pQuery;
+			pQuery = NULL;
+			return AD_ERROR_CANT_OPEN_FILE;
+		}
+
+		TDataCollector dataCollector(m_pOptions);
+		dataCollector.Fill(pQuery);
+		if(pQuery->type <= AD_IMAGE_NONE || !pQuery->data->filled)
+		{
+			delete pQuery;
+			pQuery = NULL;
+			return AD_ERROR_CANT_LOAD_IMAGE;
+		}
+		return AD_OK;
+	}
+
+	adError TImageIndex::Create(const adBitmap & bitmap, TImageDataPtr & pQuery) const
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		if(bitmap.width == 0 || bitmap.height == 0 || bitmap.stride == 0 || 
+			bitmap.format != AD_PIXEL_FORMAT_ARGB32 || bitmap.data == NULL)
+			return AD_ERROR_INVALID_BITMAP;
+
+		TView view(bitmap.width, bitmap.height, bitmap.stride, TView::Bgra32, bitmap.data);
+		pQuery = new TImageData(m_pOptions->advanced.reducedImageSize);
+		TDataCollector dataCollector(m_pOptions);
+		dataCollector.Fill(pQuery, view);
+		if(!pQuery->data->filled)
+		{
+			delete pQuery;
+			pQuery = NULL;
+			return AD_ERROR_CANT_LOAD_IMAGE;
+		}
+		return AD_OK;
+	}
+
+	adError TImageIndex::Query(TImageDataPtr pQuery, size_t k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize)
+	{
+		TReadWriteLock::TReader reader(&m_lock);
+		if(m_pComparer == NULL)
+			return AD_ERROR_INDEX_IS_NOT_OPEN;
+
+		TImageMatches matches;
+		Search(pQuery, k, threshold, matches);
+		return ExportMatches(matches, pMatch, pMatchSize);
+	}
+
+	adError TImageIndex::Query(TImageDataPtr pQuery, size_t k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize)
+	{
+		TReadWriteLock::TReader reader(&m_lock);
+		if(m_pComparer == NULL)
+			return AD_ERROR_INDEX_IS_NOT_OPEN;
+
+		TImageMatches matches;
+		Search(pQuery, k, threshold, matches);
+		return ExportMatches(matches, pMatch, pMatchSize);
+	}
+
+	adError TImageIndex::Query(TImageDataPtr pQuery, size_t k, double threshold, TMatches & matches)
+	{
+		TReadWriteLock::TReader reader(&m_lock);
+		if(m_pComparer == NULL)
+			return AD_ERROR_INDEX_IS_NOT_OPEN;
+
+		TImageMatches found;
+		Search(pQuery, k, threshold, found);
+		matches.resize(found.size());
+		for(size_t i = 0; i < found.size(); ++i)
+		{
+			matches[i].path = found[i].pImageData->path.Original();
+			matches[i].difference = found[i].difference;
+			matches[i].transform = found[i].transform;
+		}
+		return AD_OK;
+	}
+
+	// Изображение запроса копируется в хранилище и добавляется в индекс. Если файл уже 
+	// есть в индексе и не изменился, ничего не делается, изменившийся файл заменяется.
+	adError TImageIndex::Insert(TImageDataPtr pQuery)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		TReadWriteLock::TWriter writer(&m_lock);
+		if(m_pComparer == NULL)
+			return AD_ERROR_INDEX_IS_NOT_OPEN;
+
+		TImageDataPtr pImageData = m_pImageDataStorage->Lookup(*pQuery);
+		if(pImageData != NULL)
+		{
+			if(pImageData->size == pQuery->size && pImageData->time == pQuery->time && pImageData->data->filled)
+				return AD_OK;
+			m_pComparer->Erase(pImageData);
+		}
+
+		pImageData = m_pImageDataStorage->Get(*pQuery);
+		*pImageData = *pQuery;
+		m_pImageDataStorage->SetSaveState(true);
+		m_pComparer->Insert(pImageData);
+		return AD_OK;
+	}
+
+	// Возвращает не более k лучших совпадений с различием не больше threshold. Индекс находит только 
+	// изображения в пределах порога из настроек сравнения, поэтому больший threshold ничего не добавляет.
+	void TImageIndex::Search(TImageDataPtr pQuery, size_t k, double threshold, TImageMatches & matches)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_QUERY)
+		TImageMatches found;
+		m_pComparer->Query(pQuery, found);
+
+		// Для каждого изображения библиотеки оставляем лучшую из трансформаций.
+		std::sort(found.begin(), found.end(), LesserByImage);
+		for(size_t i = 0; i < found.size(); ++i)
+		{
+			const TImageMatch & match = found[i];
+			if(i > 0 && found[i - 1].pImageData == match.pImageData)
+				continue;
+			if(match.difference > threshold)
+				continue;
+			if(TPath::EqualByPath(match.pImageData->path, pQuery->path))
+				continue;
+			matches.push_back(match);
+		}
+
+		std::sort(matches.begin(), matches.end(), LesserByDifference);
+		if(matches.size() > k)
+			matches.erase(matches.begin() + k, matches.end());
+	}
+}
@@ -0,0 +1,80 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adImageIndex_h__
+#define __adImageIndex_h__
+
+#include "adConfig.h"
+#include "adStrings.h"
+#include "adThreads.h"
+#include "adImageData.h"
+#include "adImageComparer.h"
+
+namespace ad
+{
+	struct TOptions;
+	class TEngine;
+	class TImageDataStorage;
+
+	// Индекс изображений библиотеки (базы .adi) для поиска совпадений с произвольным изображением.
+	// Запрос обрабатывается тем же TDataCollector и тем же IsDuplPair, что и при обычном поиске.
+	// Запросы выполняются одновременно из нескольких потоков, перестроение индекса дожидается их окончания.
+	class TImageIndex
+	{
+	public:
+		struct TMatch
+		{
+			TString path;
+			double difference;
+			adTransformType transform;
+		};
+		typedef std::vector<TMatch> TMatches;
+
+		TImageIndex(TEngine *pEngine);
+		~TImageIndex();
+
+		void Assign(const TImageDataPtrs & imageDataPtrs);
+		void Clear();
+		bool Opened();
+
+		// Изображение запроса создается вне блокировки, его удаляет вызывающий.
+		adError Create(const TString & fileName, TImageDataPtr & pQuery) const;
+		adError Create(const adBitmap & bitmap, TImageDataPtr & pQuery) const;
+
+		adError Query(TImageDataPtr pQuery, size_t k, double threshold, adMatchPtrA pMatch, adSizePtr pMatchSize);
+		adError Query(TImageDataPtr pQuery, size_t k, double threshold, adMatchPtrW pMatch, adSizePtr pMatchSize);
+		adError Query(TImageDataPtr pQuery, size_t k, double threshold, TMatches & matches);
+		adError Insert(TImageDataPtr pQuery);
+
+	private:
+		void Search(TImageDataPtr pQuery, size_t k, double threshold, TImageMatches & matches);
+
+		TEngine *m_pEngine;
+		TOptions *m_pOptions;
+		TImageDataStorage *m_pImageDataStorage;
+		TImageComparer *m_pComparer;
+		TReadWriteLock m_lock;
+	};
+}
+
+#endif//__adImageIndex_h__
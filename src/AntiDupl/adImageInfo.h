@@ -65,6 +65,7 @@ namespace ad
         inline bool operator<(const TImageInfo& imageInfo) const { return TPath::LesserByPath(path, imageInfo.path); }
 
         bool Actual(bool update = false);
+        void SetActual(bool actual) {_actual = actual ? 1 : 0;}
 
         void Rename(const TString& newPath);
 
@@ -26,9 +26,15 @@
 #include "adStatus.h"
 #include "adImageInfoStorage.h"
 #include "adFileStream.h"
+#include "adResultFile.h"
+#include "adFileChecker.h"
+#include "adMemory.h"
 
 namespace ad
 {
+    // Сведения и узел основного списка; строки путей не учитываются.
+    const size_t IMAGE_INFO_MEMORY = sizeof(TImageInfo) + TMemoryCounters::ListNode(sizeof(TImageInfoPtr));
+
     TImageInfoStorage::TImageInfoStorage(TEngine *pEngine)
         :m_pStatus(pEngine->Status())
     {
@@ -42,6 +48,7 @@ namespace ad
             TImageInfoPtr &p = m_addMap[pImageInfo];
             p = new TImageInfo(*pImageInfo);
             m_mainList.push_back(p);
+            TMemoryCounters::Add(AD_MEMORY_IMAGE_INFO, IMAGE_INFO_MEMORY);
             return p;
         }
         return it->second;
@@ -65,40 +72,87 @@ namespace ad
 			TImageInfo *pImageInfo = new TImageInfo(imageInfo);
 			m_loadVector.push_back(pImageInfo);
 			m_mainList.push_back(pImageInfo);
+			TMemoryCounters::Add(AD_MEMORY_IMAGE_INFO, IMAGE_INFO_MEMORY);
 			m_pStatus->SetProgress(i, size);
 			if(m_pStatus->Stopped())
 				return;
 		}
 
+		if(check)
+			CheckLoaded();
+	}
+
+	void TImageInfoStorage::Save(const TOutputFileStream & outputFile) const
+	{
+		size_t size = m_mainList.size();
+		outputFile.SaveSize(size);
+		size_t index = 0;
+		for(TMainList::const_iterator it = m_mainList.begin(); it != m_mainList.end(); ++it, ++index)
+		{
+			(*it)->index = index;
+			outputFile.Save(**it);
+			m_pStatus->SetProgress(index, size);
+			if(m_pStatus->Stopped())
+				return;
+		}
+	}
+
+	void TImageInfoStorage::Load(const TResultFileReader & reader, bool check)
+	{
+		Clear();
+
+		size_t size = reader.ImageCount();
+		m_loadVector.reserve(size);
 		for(size_t i = 0; i < size; i++)
 		{
-			TImageInfo *pImageInfo = m_loadVector[i];
-			pImageInfo->removed = check && !pImageInfo->Actual();
+			TImageInfo *pImageInfo = new TImageInfo();
+			m_mainList.push_back(pImageInfo);
+			TMemoryCounters::Add(AD_MEMORY_IMAGE_INFO, IMAGE_INFO_MEMORY);
+			reader.Load(i, *pImageInfo);
+			m_loadVector.push_back(pImageInfo);
 			m_pStatus->SetProgress(i, size);
 			if(m_pStatus->Stopped())
 				return;
 		}
+
+		if(check)
+			CheckLoaded();
 	}
 
-	void TImageInfoStorage::Save(const TOutputFileStream & outputFile) const
+	// Проверяем актуальность загруженных изображений пакетно, по каталогам.
+	void TImageInfoStorage::CheckLoaded()
+	{
+		TFileChecker checker(m_pStatus);
+		for(size_t i = 0; i < m_loadVector.size(); i++)
+			checker.Add(m_loadVector[i]);
+		checker.Check();
+		for(size_t i = 0; i < m_loadVector.size(); i++)
+		{
+			TImageInfo *pImageInfo = m_loadVector[i];
+			pImageInfo->SetActual(checker.Actual(pImageInfo));
+			pImageInfo->removed = !pImageInfo->Actual();
+		}
+	}
+
+	void TImageInfoStorage::Save(TResultFileWriter & writer) const
 	{
 		size_t size = m_mainList.size();
-		outputFile.SaveSize(size);
 		size_t index = 0;
+		writer.BeginImages();
 		for(TMainList::const_iterator it = m_mainList.begin(); it != m_mainList.end(); ++it, ++index)
 		{
 			(*it)->index = index;
-			outputFile.Save(**it);
+			writer.Save(**it);
 			m_pStatus->SetProgress(index, size);
-			if(m_pStatus->Stopped())
-				return;
 		}
+		writer.EndImages();
 	}
 
     void TImageInfoStorage::Clear()
     {
         for(TMainList::iterator it = m_mainList.begin(); it != m_mainList.end(); ++it)
             delete *it;
+        TMemoryCounters::Remove(AD_MEMORY_IMAGE_INFO, m_mainList.size()*IMAGE_INFO_MEMORY);
         m_mainList.clear();
         m_loadVector.clear();
         m_addMap.clear();
@@ -112,6 +166,7 @@ namespace ad
             {
                 delete *it;
                 it = m_mainList.erase(it);
+                TMemoryCounters::Remove(AD_MEMORY_IMAGE_INFO, IMAGE_INFO_MEMORY);
             }
             else
                 ++it;
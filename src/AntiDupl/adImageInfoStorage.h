@@ -36,6 +36,8 @@ namespace ad
 
 	class TInputFileStream;
 	class TOutputFileStream;
+	class TResultFileReader;
+	class TResultFileWriter;
 
     typedef std::list<TImageInfoPtr> TImageInfoPtrList;
     //-------------------------------------------------------------------------
@@ -52,12 +54,16 @@ namespace ad
 
 		void Load(const TInputFileStream & inputFile, bool check);
 		void Save(const TOutputFileStream & outputFile) const;
+		void Load(const TResultFileReader & reader, bool check);
+		void Save(TResultFileWriter & writer) const;
 
         void Clear();
 
         void RemoveUnlinked();
 
     private:
+        void CheckLoaded();
+
         typedef std::map<TImageInfoPtr, TImageInfoPtr> TAddMap;
         typedef std::vector<TImageInfoPtr> TLoadVector;
         typedef TImageInfoPtrList TMainList;
@@ -46,7 +46,8 @@ namespace ad
         HGLOBAL hGlobal = LoadFileToMemory(fileName.c_str());
         if(hGlobal)
         {
-            TImage *pImage = TImage::Load(hGlobal, pOptions);
+            size_t size = std::max(pBitmap->width, pBitmap->height);
+            TImage *pImage = TImage::Load(hGlobal, pOptions, size, size);
             if(pImage)
             {
                 TView::Format format = TView::None;
@@ -83,7 +84,7 @@ namespace ad
             }
             else
                 result = AD_ERROR_CANT_LOAD_IMAGE;
-            ::GlobalFree(hGlobal);
+            FreeFileFromMemory(hGlobal);
         }
         else
             result = AD_ERROR_CANT_OPEN_FILE;
@@ -53,165 +53,151 @@ namespace ad
 		return false;
 	}
 
-	TJxl* TJxl::Load(HGLOBAL hGlobal)
+	// Декодер и пул потоков создаются один раз на поток и переиспользуются через JxlDecoderReset.
+	struct JxlContext
 	{
-		AD_FUNCTION_PERFORMANCE_TEST
-
-		TJxl* pJxl = NULL;
-		if (hGlobal)
+		JxlContext()
+			: runner(JxlResizableParallelRunnerMake(nullptr))
+			, decoder(JxlDecoderMake(nullptr))
 		{
-			uint8_t* data = (uint8_t*)::GlobalLock(hGlobal);
-			size_t data_size = ::GlobalSize(hGlobal);
+		}
 
-			auto runner = JxlResizableParallelRunnerMake(nullptr);
+		JxlResizableParallelRunnerPtr runner;
+		JxlDecoderPtr decoder;
+	};
 
-			auto decoder = JxlDecoderMake(nullptr);
-			if (JXL_DEC_SUCCESS !=
-				JxlDecoderSubscribeEvents(decoder.get(), JXL_DEC_BASIC_INFO |
-					JXL_DEC_COLOR_ENCODING |
-					JXL_DEC_FULL_IMAGE))
-			{
+	thread_local JxlContext jxlContext;
+
+	static TView* JxlDecode(JxlContext & context, const uint8_t* data, size_t data_size, size_t thumbnailSize, bool & thumbnail)
+	{
+		JxlDecoder* decoder = context.decoder.get();
+		JxlDecoderReset(decoder);
+		thumbnail = false;
+
+		int events = JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE | (thumbnailSize ? JXL_DEC_FRAME_PROGRESSION : 0);
+		if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(decoder, events))
+		{
 #ifdef AD_LOGGER_ENABLE
-				AD_LOG("JxlDecoderSubscribeEvents failed\n);
+			AD_LOG("JxlDecoderSubscribeEvents failed\n");
 #endif//AD_LOGGER_ENABLE
-				return NULL;
-			}
+			return NULL;
+		}
 
-			if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(decoder.get(),
-				JxlResizableParallelRunner,
-				runner.get()))
-			{
+		if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(decoder, JxlResizableParallelRunner, context.runner.get()))
+		{
 #ifdef AD_LOGGER_ENABLE
-				AD_LOG("JxlDecoderSetParallelRunner failed\n);
+			AD_LOG("JxlDecoderSetParallelRunner failed\n");
 #endif//AD_LOGGER_ENABLE
-				return NULL;
-			}
+			return NULL;
+		}
 
-			JxlBasicInfo info;
-			JxlPixelFormat format = { 4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0 };
-			size_t xsize = 0, ysize = 0;
-			std::vector<uint8_t> pixels;
+		JxlBasicInfo info;
+		JxlPixelFormat format = { 4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0 };
+		TView* pView = NULL;
 
-			JxlDecoderSetInput(decoder.get(), data, data_size);
-			JxlDecoderCloseInput(decoder.get());
+		JxlDecoderSetInput(decoder, data, data_size);
+		JxlDecoderCloseInput(decoder);
 
-			for (;;)
-			{
-				JxlDecoderStatus status = JxlDecoderProcessInput(decoder.get());
+		for (;;)
+		{
+			JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
 
-				if (status == JXL_DEC_ERROR)
+			if (status == JXL_DEC_BASIC_INFO)
+			{
+				if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(decoder, &info))
 				{
 #ifdef AD_LOGGER_ENABLE
-					AD_LOG("Decoder error\n");
+					AD_LOG("JxlDecoderGetBasicInfo failed\n");
 #endif//AD_LOGGER_ENABLE
-					return NULL;
+					break;
 				}
-				else if (status == JXL_DEC_NEED_MORE_INPUT)
+				JxlResizableParallelRunnerSetThreads(context.runner.get(),
+					JxlResizableParallelRunnerSuggestThreads(info.xsize, info.ysize));
+				if (thumbnailSize && std::min(info.xsize, info.ysize) / 8 >= thumbnailSize)
+					JxlDecoderSetProgressiveDetail(decoder, kDC);
+			}
+			else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER)
+			{
+				size_t buffer_size;
+				if (JXL_DEC_SUCCESS != JxlDecoderImageOutBufferSize(decoder, &format, &buffer_size) ||
+					buffer_size != info.xsize * info.ysize * 4)
 				{
 #ifdef AD_LOGGER_ENABLE
-					AD_LOG("Error, already provided all input\n");
+					AD_LOG("Invalid out buffer size\n");
 #endif//AD_LOGGER_ENABLE
-					return NULL;
+					break;
 				}
-				else if (status == JXL_DEC_BASIC_INFO)
+				// Декодируем сразу в буфер результата. Для анимации буфер переиспользуется и остается последний кадр.
+				if (pView == NULL)
+					pView = new TView(info.xsize, info.ysize, info.xsize * 4, TView::Rgba32, NULL);
+				if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(decoder, &format, pView->data, buffer_size))
 				{
-					if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(decoder.get(), &info))
-					{
 #ifdef AD_LOGGER_ENABLE
-						AD_LOG("JxlDecoderGetBasicInfo failed\n);
+					AD_LOG("JxlDecoderSetImageOutBuffer failed\n");
 #endif//AD_LOGGER_ENABLE
-						return NULL;
-					}
-					xsize = info.xsize;
-					ysize = info.ysize;
-					JxlResizableParallelRunnerSetThreads(
-						runner.get(),
-						JxlResizableParallelRunnerSuggestThreads(info.xsize, info.ysize));
+					break;
 				}
-				else if (status == JXL_DEC_COLOR_ENCODING)
+			}
+			else if (status == JXL_DEC_FRAME_PROGRESSION)
+			{
+				// DC проход соответствует изображению, уменьшенному в 8 раз; выдаем его, если этого достаточно для эскиза.
+				size_t ratio = JxlDecoderGetIntendedDownsamplingRatio(decoder);
+				if (pView && ratio > 1 && std::min(info.xsize, info.ysize) / ratio >= thumbnailSize &&
+					JxlDecoderFlushImage(decoder) == JXL_DEC_SUCCESS)
 				{
-					// Get the ICC color profile of the pixel data
-					size_t icc_size;
-					if (JXL_DEC_SUCCESS !=
-						JxlDecoderGetICCProfileSize(
-							decoder.get(), JXL_COLOR_PROFILE_TARGET_DATA, &icc_size))
-					{
-#ifdef AD_LOGGER_ENABLE
-						AD_LOG("JxlDecoderGetICCProfileSize failed\n);
-#endif//AD_LOGGER_ENABLE
-						return NULL;
-					}
-					//icc_profile->resize(icc_size);
-					//if (JXL_DEC_SUCCESS != JxlDecoderGetColorAsICCProfile(
-					//	decoder.get(), &format,
-					//	JXL_COLOR_PROFILE_TARGET_DATA,
-					//	icc_profile->data(), icc_profile->size())) {
-					//	return NULL;
-					//}
+					thumbnail = true;
+					JxlDecoderReleaseInput(decoder);
+					return pView;
 				}
-				else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER)
-				{
-					size_t buffer_size;
-					if (JXL_DEC_SUCCESS !=
-						JxlDecoderImageOutBufferSize(decoder.get(), &format, &buffer_size))
-					{
-#ifdef AD_LOGGER_ENABLE
-						AD_LOG("JxlDecoderImageOutBufferSize failed\n);
-#endif//AD_LOGGER_ENABLE
-						return NULL;
-					}
-					if (buffer_size != xsize * ysize * 4) {
-#ifdef AD_LOGGER_ENABLE
-						AD_LOG("Invalid out buffer size");
-#endif//AD_LOGGER_ENABLE
-						return NULL;
-					}
-					pixels.resize(xsize * ysize * 4);
-					void* pixels_buffer = (void*)pixels.data();
-					size_t pixels_buffer_size = pixels.size() * sizeof(uint8_t);
-					if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(decoder.get(), &format,
-						pixels_buffer,
-						pixels_buffer_size)) {
-#ifdef AD_LOGGER_ENABLE
-						AD_LOG("JxlDecoderSetImageOutBuffer failed\n");
-#endif//AD_LOGGER_ENABLE
-						return NULL;
-					}
-				}
-				else if (status == JXL_DEC_FULL_IMAGE) {
-					// Nothing to do. Do not yet return. If the image is an animation, more
-					// full frames may be decoded. This example only keeps the last one.
-				}
-				else if (status == JXL_DEC_SUCCESS) {
-					// All decoding successfully finished.
-					// It's not required to call JxlDecoderReleaseInput(dec.get()) here since
-					// the decoder will be destroyed.
-					break;
-				}
-				else {
-					fprintf(stderr, "Unknown decoder status\n");
+			}
+			else if (status == JXL_DEC_FULL_IMAGE)
+			{
+				// Nothing to do. If the image is an animation, more full frames may be decoded.
+			}
+			else if (status == JXL_DEC_SUCCESS)
+			{
+				// All decoding successfully finished.
+				JxlDecoderReleaseInput(decoder);
+				return pView;
+			}
+			else
+			{
 #ifdef AD_LOGGER_ENABLE
-					AD_LOG("Unknown decoder status\n");
+				AD_LOG(status == JXL_DEC_NEED_MORE_INPUT ? "Error, already provided all input\n" : "Decoder error\n");
 #endif//AD_LOGGER_ENABLE
-					return NULL;
-				}
+				break;
 			}
+		}
 
-			TView* pView_RGBA = new TView(xsize, ysize, xsize * 4, TView::Rgba32, NULL);
-			AD_PERFORMANCE_TEST_SET_SIZE(ysize * xsize * 4)
+		JxlDecoderReleaseInput(decoder);
+		delete pView;
+		return NULL;
+	}
+
+	TJxl* TJxl::Load(HGLOBAL hGlobal, size_t thumbnailSize)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+
+		TJxl* pJxl = NULL;
+		if (hGlobal && jxlContext.decoder && jxlContext.runner)
+		{
+			uint8_t* data = (uint8_t*)::GlobalLock(hGlobal);
+			size_t data_size = ::GlobalSize(hGlobal);
+
+			bool thumbnail = false;
+			TView* pView_RGBA = JxlDecode(jxlContext, data, data_size, thumbnailSize, thumbnail);
 			if (pView_RGBA)
 			{
-				memcpy(pView_RGBA->data, pixels.data(), ysize * xsize * 4);
+				AD_PERFORMANCE_TEST_SET_SIZE(pView_RGBA->height * pView_RGBA->stride)
 				pJxl = new TJxl();
 				pJxl->m_pView = pView_RGBA;
 				pJxl->m_format = TImage::Jxl;
+				if (thumbnail)
+					pJxl->m_decodeMode = DECODE_MODE_THUMBNAIL;
 			}
-			else
-			{
-				delete pView_RGBA;
-			}
-			return pJxl;
+
+			::GlobalUnlock(hGlobal);
 		}
-		return NULL;
+		return pJxl;
 	}
 }
\ No newline at end of file
@@ -32,7 +32,8 @@ namespace ad
 	class TJxl : public TImage
 	{
 	public:
-		static TJxl* Load(HGLOBAL hGlobal);
+		// thumbnailSize > 0: декодировать только прогрессивный DC проход, если его разрешение не меньше thumbnailSize.
+		static TJxl* Load(HGLOBAL hGlobal, size_t thumbnailSize = 0);
 		static bool Supported(HGLOBAL hGlobal);
 
 	private:
@@ -0,0 +1,269 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adEngine.h"
+#include "adOptions.h"
+#include "adImageData.h"
+#include "adImageComparer.h"
+#include "adDataCollector.h"
+#include "adImage.h"
+#include "adPath.h"
+#include "adPathFilter.h"
+#include "adPerformance.h"
+#include "adKernelBenchmark.h"
+
+namespace ad
+{
+	const size_t KERNEL_IMAGE_NUMBER = 256;
+	const size_t KERNEL_BLOCKINESS_WIDTH = 1024;
+	const size_t KERNEL_BLOCKINESS_HEIGHT = 768;
+	const size_t KERNEL_BLOCKINESS_NUMBER = 4;
+	const size_t KERNEL_IGNORE_PATH_NUMBER = 16;
+	const int KERNEL_NOISE = 2;
+
+	//-------------------------------------------------------------------------
+
+	// Изображения идут парами: нечетное - копия предыдущего с небольшим шумом, 
+	// поэтому IsDuplPair для пары доходит до полного сравнения уменьшенных изображений.
+	// Пути и индексы путей у всех изображений разные, чтобы не срабатывали ранние отказы.
+	// Пути для фильтра по очереди: подходящий файл, файл с чужим расширением и файл внутри игнорируемого 
+	// каталога, как при обходе каталогов TSearcher.
+	class TKernelBenchmark
+	{
+	public:
+		TKernelBenchmark(TEngine *pEngine);
+		~TKernelBenchmark();
+
+		void Run(adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark);
+
+	private:
+		size_t Pass(adKernelType kernelType);
+		TUInt8 Random();
+
+		TOptions *m_pOptions;
+		TImageDataPtrs m_images;
+		TUInt8 *m_pBuffer;
+		TImageComparer *m_pSquared;
+		TImageComparer *m_pSsim;
+		TImageComparer_3D *m_p3D;
+		TDataCollector *m_pCollector;
+		std::vector<TView*> m_grays;
+		TPathFilter m_filter;
+		TStrings m_paths;
+		TUInt32 m_random;
+		volatile double m_sink; // не дает компилятору выбросить результаты ядер
+	};
+
+	TKernelBenchmark::TKernelBenchmark(TEngine *pEngine)
+		: m_pOptions(pEngine->Options())
+		, m_random(1)
+		, m_sink(0)
+	{
+		const size_t side = m_pOptions->advanced.reducedImageSize;
+		for(size_t i = 0; i < KERNEL_IMAGE_NUMBER; ++i)
+		{
+			TChar path[MAX_PATH];
+			_stprintf_s(path, TEXT("C:\\kernel\\%u\\image.bmp"), (unsigned int)i);
+			// TImageInfo(path) запоминает путь, только если файл существует, поэтому размер и время задаются явно.
+			TImageData *pImageData = new TImageData(TImageInfo(path, side*side, i), side);
+			pImageData->index = i;
+			TPixelData & data = *pImageData->data;
+			for(size_t j = 0; j < data.size; ++j)
+			{
+				int value = (i & 1) ? m_images.back()->data->main[j] + Random()%(2*KERNEL_NOISE + 1) - KERNEL_NOISE : Random();
+				data.main[j] = TUInt8(Simd::Base::RestrictRange(value));
+			}
+			data.FillFast(m_pOptions->GetIgnoreWidthFrame());
+			data.filled = true;
+			m_images.push_back(pImageData);
+		}
+		m_pBuffer = (TUInt8*)SimdAllocate(side*side + FAST_DATA_SIZE, SimdAlignment());
+
+		m_pSquared = new TImageComparer_0D(pEngine);
+		m_pSsim = new TImageComparer_SSIM(pEngine);
+		m_p3D = new TImageComparer_3D(pEngine);
+		for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it)
+			m_pSsim->Prepare(*it, false);
+
+		m_pCollector = new TDataCollector(m_pOptions);
+		for(size_t i = 0; i < KERNEL_BLOCKINESS_NUMBER; ++i)
+		{
+			TView *pGray = new TView(KERNEL_BLOCKINESS_WIDTH, KERNEL_BLOCKINESS_HEIGHT, TView::Gray8);
+			for(size_t row = 0; row < pGray->height; ++row)
+				for(size_t col = 0; col < pGray->width; ++col)
+					pGray->At<TUInt8>(col, row) = Random();
+			m_grays.push_back(pGray);
+		}
+
+		TStrings extensions;
+		for(int format = TImage::None + 1; format < TImage::FormatSize; ++format)
+		{
+			TStrings formatExtensions = TImage::Extensions((TImage::TFormat)format);
+			extensions.insert(extensions.end(), formatExtensions.begin(), formatExtensions.end());
+		}
+		adPathWSF *pIgnorePaths = new adPathWSF[KERNEL_IGNORE_PATH_NUMBER];
+		for(size_t i = 0; i < KERNEL_IGNORE_PATH_NUMBER; ++i)
+		{
+			swprintf_s(pIgnorePaths[i], MAX_PATH_EX, L"C:\\kernel\\ignore\\%u", (unsigned int)i);
+			pIgnorePaths[i][MAX_PATH_EX] = TRUE;
+		}
+		TPathContainer ignorePaths(TEXT("IgnorePaths"));
+		ignorePaths.Import(pIgnorePaths, KERNEL_IGNORE_PATH_NUMBER);
+		delete[] pIgnorePaths;
+		m_filter.Init(extensions, TString(), ignorePaths);
+		for(size_t i = 0; i < KERNEL_IMAGE_NUMBER; ++i)
+		{
+			TChar path[MAX_PATH];
+			if(i%3 == 0)
+				_stprintf_s(path, TEXT("C:\\kernel\\%u\\image.jpg"), (unsigned int)i);
+			else if(i%3 == 1)
+				_stprintf_s(path, TEXT("C:\\kernel\\%u\\image.txt"), (unsigned int)i);
+			else
+				_stprintf_s(path, TEXT("C:\\kernel\\ignore\\%u\\sub\\image.png"), (unsigned int)(i%KERNEL_IGNORE_PATH_NUMBER));
+			m_paths.push_back(TString(path));
+		}
+	}
+
+	TKernelBenchmark::~TKernelBenchmark()
+	{
+		for(size_t i = 0; i < m_grays.size(); ++i)
+			delete m_grays[i];
+		delete m_pCollector;
+		delete m_p3D;
+		delete m_pSsim;
+		delete m_pSquared;
+		SimdFree(m_pBuffer);
+		for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it)
+			delete *it;
+	}
+
+	// Первый проход прогревает кэши и не учитывается.
+	void TKernelBenchmark::Run(adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark)
+	{
+		Pass(kernelType);
+
+		size_t count = 0;
+		double total = 0, best = std::numeric_limits<double>::max();
+		do
+		{
+			double start = Time();
+			size_t number = Pass(kernelType);
+			double time = Time() - start;
+			count += number;
+			total += time;
+			best = std::min(best, time/number);
+		} while(total < minTime);
+
+		pBenchmark->reducedImageSize = m_pOptions->advanced.reducedImageSize;
+		pBenchmark->count = count;
+		pBenchmark->total = total*1000.0;
+		pBenchmark->average = total/count*1000000000.0;
+		pBenchmark->min = best*1000000000.0;
+	}
+
+	// Возвращает число вызовов ядра за проход.
+	size_t TKernelBenchmark::Pass(adKernelType kernelType)
+	{
+		size_t number = 0;
+		double difference = 0;
+		switch(kernelType)
+		{
+		case AD_KERNEL_FILL_FAST:
+			for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it, ++number)
+				(*it)->data->FillFast(m_pOptions->GetIgnoreWidthFrame());
+			break;
+		// Четыре поворота и два отражения возвращают изображение в исходное состояние.
+		case AD_KERNEL_TURN:
+			for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it, number += 4)
+				for(int i = 0; i < 4; ++i)
+					(*it)->data->Turn(m_pBuffer);
+			break;
+		case AD_KERNEL_MIRROR:
+			for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it, number += 2)
+				for(int i = 0; i < 2; ++i)
+					(*it)->data->Mirror(m_pBuffer);
+			break;
+		case AD_KERNEL_DUPL_PAIR:
+		case AD_KERNEL_DUPL_PAIR_SSIM:
+			{
+				TImageComparer *pComparer = kernelType == AD_KERNEL_DUPL_PAIR ? m_pSquared : m_pSsim;
+				for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++number)
+				{
+					TImageDataPtr pFirst = *it++;
+					if(pComparer->IsDuplPair(pFirst, *it++, &difference))
+						m_sink += difference;
+				}
+			}
+			break;
+		case AD_KERNEL_INDEX_3D:
+			for(TImageDataPtrs::iterator it = m_images.begin(); it != m_images.end(); ++it, ++number)
+			{
+				TImageComparer_3D::TIndex index;
+				m_p3D->GetIndex(*it, index);
+				m_sink += index.s + index.x + index.y;
+			}
+			break;
+		case AD_KERNEL_BLOCKINESS:
+			for(size_t i = 0; i < m_grays.size(); ++i, ++number)
+				m_sink += m_pCollector->GetBlockiness(*m_grays[i]);
+			break;
+		case AD_KERNEL_PATH_FILTER:
+			for(size_t i = 0; i < m_paths.size(); ++i, ++number)
+			{
+				const TString & path = m_paths[i];
+				if(m_filter.IsWanted(path) && !m_filter.IsIgnored(path) && !m_filter.IsIgnoredParent(path))
+					m_sink += 1;
+			}
+			break;
+		}
+		return number;
+	}
+
+	TUInt8 TKernelBenchmark::Random()
+	{
+		m_random = m_random*1664525 + 1013904223;
+		return TUInt8(m_random >> 24);
+	}
+
+	//-------------------------------------------------------------------------
+
+	adError KernelBenchmark(TEngine *pEngine, adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark)
+	{
+		if(kernelType < AD_KERNEL_FILL_FAST || kernelType >= AD_KERNEL_SIZE)
+			return AD_ERROR_INVALID_KERNEL_TYPE;
+		if(minTime <= 0)
+			return AD_ERROR_INVALID_PARAMETER_COMBINATION;
+
+		TKernelBenchmark benchmark(pEngine);
+		benchmark.Run(kernelType, minTime, pBenchmark);
+
+		pBenchmark->simd = 0;
+		if(SimdCpuInfo(SimdCpuInfoSse41))
+			pBenchmark->simd |= AD_SIMD_SSE41;
+		if(SimdCpuInfo(SimdCpuInfoAvx2))
+			pBenchmark->simd |= AD_SIMD_AVX2;
+		if(SimdCpuInfo(SimdCpuInfoAvx512bw))
+			pBenchmark->simd |= AD_SIMD_AVX512BW;
+		return AD_OK;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adKernelBenchmark_h__
+#define __adKernelBenchmark_h__
+
+#include "adConfig.h"
+
+namespace ad
+{
+	class TEngine;
+
+	// Замер отдельного вычислительного ядра на синтетических данных с текущими настройками движка 
+	// (reducedImageSize, thresholdDifference, ignoreFrameWidth). Ядро вызывается проходами по набору 
+	// изображений, пока суммарное время не превысит minTime секунд.
+	adError KernelBenchmark(TEngine *pEngine, adKernelType kernelType, double minTime, adKernelBenchmarkPtr pBenchmark);
+}
+
+#endif//__adKernelBenchmark_h__
@@ -0,0 +1,119 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adPerformance.h"
+#include "adTracer.h"
+#include "adMemory.h"
+
+namespace ad
+{
+    const double MEMORY_TRACE_INTERVAL = 0.010;
+
+    const char * const MEMORY_TRACE_NAMES[AD_MEMORY_SIZE] = 
+    {
+        "memory.imageData",
+        "memory.pixelData",
+        "memory.comparer",
+        "memory.fileBuffer",
+        "memory.decode",
+        "memory.result",
+        "memory.imageInfo",
+        "memory.undo",
+        "memory.total",
+    };
+
+    //-------------------------------------------------------------------------
+
+    volatile LONGLONG TMemoryCounters::s_current[AD_MEMORY_SIZE] = {0};
+    volatile LONGLONG TMemoryCounters::s_peak[AD_MEMORY_SIZE] = {0};
+    volatile LONGLONG TMemoryCounters::s_traced = 0;
+
+    // Пик поднимается циклом сравнения с обменом: другой поток мог записать больший пик между чтением и записью.
+    void TMemoryCounters::Add(adMemoryType type, size_t size)
+    {
+        if(size == 0)
+            return;
+        const adMemoryType types[2] = {type, AD_MEMORY_TOTAL};
+        for(size_t i = 0; i < 2; ++i)
+        {
+            LONGLONG current = ::InterlockedExchangeAdd64(&s_current[types[i]], (LONGLONG)size) + (LONGLONG)size;
+            LONGLONG peak = s_peak[types[i]];
+            while(current > peak)
+            {
+                LONGLONG previous = ::InterlockedCompareExchange64(&s_peak[types[i]], current, peak);
+                if(previous == peak)
+                    break;
+                peak = previous;
+            }
+        }
+        if(TTracer::Enabled())
+            Trace();
+    }
+
+    void TMemoryCounters::Remove(adMemoryType type, size_t size)
+    {
+        if(size == 0)
+            return;
+        ::InterlockedExchangeAdd64(&s_current[type], -(LONGLONG)size);
+        ::InterlockedExchangeAdd64(&s_current[AD_MEMORY_TOTAL], -(LONGLONG)size);
+        if(TTracer::Enabled())
+            Trace();
+    }
+
+    TUInt64 TMemoryCounters::Current(adMemoryType type)
+    {
+        LONGLONG current = s_current[type];
+        return current > 0 ? (TUInt64)current : 0;
+    }
+
+    void TMemoryCounters::ResetPeak()
+    {
+        for(size_t type = 0; type < AD_MEMORY_SIZE; ++type)
+            ::InterlockedExchange64(&s_peak[type], s_current[type]);
+    }
+
+    adError TMemoryCounters::Export(adMemoryType type, adMemoryPtr pMemory)
+    {
+        if(type < 0 || type >= AD_MEMORY_SIZE)
+            return AD_ERROR_INVALID_MEMORY_TYPE;
+
+        LONGLONG current = s_current[type], peak = s_peak[type];
+        pMemory->current = current > 0 ? (TUInt64)current : 0;
+        pMemory->peak = peak > (LONGLONG)pMemory->current ? (TUInt64)peak : pMemory->current;
+        return AD_OK;
+    }
+
+    // Значения пишет тот поток, которому удалось сдвинуть время последней записи, остальные ничего не делают.
+    void TMemoryCounters::Trace()
+    {
+        double time = Time();
+        LONGLONG now = LONGLONG(time*1000000.0);
+        LONGLONG traced = s_traced;
+        if(now - traced < LONGLONG(MEMORY_TRACE_INTERVAL*1000000.0))
+            return;
+        if(::InterlockedCompareExchange64(&s_traced, now, traced) != traced)
+            return;
+        for(size_t type = 0; type < AD_MEMORY_SIZE; ++type)
+            TTracer::Counter(MEMORY_TRACE_NAMES[type], time, (double)Current((adMemoryType)type));
+    }
+}
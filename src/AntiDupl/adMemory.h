@@ -0,0 +1,64 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adMemory_h__
+#define __adMemory_h__
+
+#include "adConfig.h"
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+
+	// Учет памяти по подсистемам, общий для всех движков процесса. Учитывается только память 
+	// самих данных (без накладных расходов кучи), поэтому значения меньше рабочего множества процесса.
+	// Счетчики ведутся всегда: каждое изменение - одна атомарная операция. При включенной трассировке 
+	// значения не чаще раза в MEMORY_TRACE_INTERVAL попадают в trace.json как события-счетчики.
+	// AD_MEMORY_TOTAL используется ограничением advanced.memoryLimit (TCollectManager::Throttle) и 
+	// поэтому действует на все движки процесса; память прочитанных файлов своего движка TCollectManager 
+	// считает сам.
+    class TMemoryCounters
+    {
+    public:
+        static void Add(adMemoryType type, size_t size);
+        static void Remove(adMemoryType type, size_t size);
+
+        static TUInt64 Current(adMemoryType type);
+        // Пик отсчитывается заново от текущего значения, вызывается в начале поиска.
+        static void ResetPeak();
+
+        static adError Export(adMemoryType type, adMemoryPtr pMemory);
+
+        // Размер узла std::list со значением заданного размера.
+        static size_t ListNode(size_t size) {return size + 2*sizeof(void*);}
+
+    private:
+        static void Trace();
+
+        static volatile LONGLONG s_current[AD_MEMORY_SIZE];
+        static volatile LONGLONG s_peak[AD_MEMORY_SIZE];
+        static volatile LONGLONG s_traced;
+    };
+}
+
+#endif//__adMemory_h__
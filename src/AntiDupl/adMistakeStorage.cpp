@@ -27,6 +27,7 @@
 #include "adImageInfo.h"
 #include "adMistakeStorage.h"
 #include "adFileStream.h"
+#include "adTracer.h"
 
 namespace ad
 {
@@ -42,6 +43,7 @@ namespace ad
 
     adError TMistakeStorage::Save(const TChar *fileName)
     {
+        AD_TRACE("save mistake data base")
         adError error = AD_OK;
 		try
 		{
@@ -0,0 +1,117 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adImageData.h"
+#include "adResultStorage.h"
+#include "adNearest.h"
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+    TNearest::TNearest(size_t count)
+        :m_count(count)
+    {
+    }
+
+	// Пара заносится в списки обоих изображений.
+    void TNearest::Add(TImageDataPtr pFirst, TImageDataPtr pSecond, double difference, adTransformType transform)
+    {
+        TPair pair;
+        pair.first = pFirst;
+        pair.second = pSecond;
+        pair.difference = difference;
+        pair.transform = transform;
+        Push(pFirst, pair);
+        Push(pSecond, pair);
+    }
+
+	// Каждая пара находится только одним потоком сравнения (владельцем ранее добавленного изображения), 
+	// поэтому K ближайших общего результата всегда есть среди K ближайших отдельных потоков.
+    void TNearest::Merge(const TNearest & nearest)
+    {
+        for(TMap::const_iterator it = nearest.m_map.begin(); it != nearest.m_map.end(); ++it)
+        {
+            for(TPairs::const_iterator pair = it->second.begin(); pair != it->second.end(); ++pair)
+                Push(it->first, *pair);
+        }
+    }
+
+	// Пара, попавшая в списки обоих изображений, выдается один раз.
+    void TNearest::Export(TResultStorage *pResult) const
+    {
+        std::set<std::pair<TImageDataPtr, TImageDataPtr> > exported;
+        for(TMap::const_iterator it = m_map.begin(); it != m_map.end(); ++it)
+        {
+            for(TPairs::const_iterator pair = it->second.begin(); pair != it->second.end(); ++pair)
+            {
+                std::pair<TImageDataPtr, TImageDataPtr> key(std::min(pair->first, pair->second), std::max(pair->first, pair->second));
+                if(exported.insert(key).second)
+                    pResult->AddDuplImagePair(pair->first, pair->second, pair->difference, pair->transform);
+            }
+        }
+    }
+
+    void TNearest::Clear()
+    {
+        m_map.clear();
+    }
+
+	// Одно и то же изображение-партнер (например, найденное при разных трансформациях) 
+	// занимает в списке не больше одного места.
+    void TNearest::Push(TImageDataPtr pImageData, const TPair & pair)
+    {
+        TPairs & pairs = m_map[pImageData];
+        TImageDataPtr pOther = pair.Other(pImageData);
+        for(size_t i = 0; i < pairs.size(); ++i)
+        {
+            if(pairs[i].Other(pImageData) == pOther)
+            {
+                if(pair.difference < pairs[i].difference)
+                {
+                    pairs[i] = pair;
+                    std::make_heap(pairs.begin(), pairs.end(), Less);
+                }
+                return;
+            }
+        }
+
+        if(pairs.size() < m_count)
+        {
+            pairs.push_back(pair);
+            std::push_heap(pairs.begin(), pairs.end(), Less);
+        }
+        else if(pair.difference < pairs.front().difference)
+        {
+            std::pop_heap(pairs.begin(), pairs.end(), Less);
+            pairs.back() = pair;
+            std::push_heap(pairs.begin(), pairs.end(), Less);
+        }
+    }
+
+	// Куча упорядочена так, что в вершине находится пара с наибольшим отличием.
+	bool TNearest::Less(const TPair & a, const TPair & b)
+	{
+		return a.difference < b.difference;
+	}
+    //-------------------------------------------------------------------------
+}
@@ -0,0 +1,68 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adNearest_h__
+#define __adNearest_h__
+
+#include "adConfig.h"
+
+namespace ad
+{
+    struct TImageData;
+    class TResultStorage;
+    typedef TImageData* TImageDataPtr;
+    //-------------------------------------------------------------------------
+	// Для каждого изображения хранит не более K ближайших к нему найденных пар.
+	// Списки изображений - ограниченные кучи с наихудшей парой в вершине.
+	// Один экземпляр используется одним потоком, общий результат собирается через Merge.
+    class TNearest
+    {
+        struct TPair
+        {
+            TImageDataPtr first;
+            TImageDataPtr second;
+            double difference;
+            adTransformType transform;
+
+            TImageDataPtr Other(TImageDataPtr pImageData) const {return first == pImageData ? second : first;}
+        };
+        typedef std::vector<TPair> TPairs;
+        typedef std::map<TImageDataPtr, TPairs> TMap;
+    public:
+        TNearest(size_t count);
+
+        void Add(TImageDataPtr pFirst, TImageDataPtr pSecond, double difference, adTransformType transform);
+        void Merge(const TNearest & nearest);
+        void Export(TResultStorage *pResult) const;
+        void Clear();
+
+    private:
+        void Push(TImageDataPtr pImageData, const TPair & pair);
+        static bool Less(const TPair & a, const TPair & b);
+
+        size_t m_count;
+        TMap m_map;
+    };
+    //-------------------------------------------------------------------------
+}
+#endif//__adNearest_h__
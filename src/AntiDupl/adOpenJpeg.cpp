@@ -208,17 +208,25 @@ namespace ad
             Yuv444ToBgra(bgra, width, height, stride, y, u, v, precision - 8, alpha);
     }
 
-    TOpenJpeg* TOpenJpeg::Load(HGLOBAL hGlobal)
+    TOpenJpeg* TOpenJpeg::Load(HGLOBAL hGlobal, size_t reducedSize)
     {
         if(hGlobal)
         {
-            TView *pView = Load((unsigned char*)::GlobalLock(hGlobal), ::GlobalSize(hGlobal));
+            TPoint originalSize;
+            unsigned char *data = (unsigned char*)::GlobalLock(hGlobal);
+            size_t size = ::GlobalSize(hGlobal);
+            TView *pView = Load(data, size, reducedSize, originalSize);
+            if(pView == NULL && reducedSize)
+                pView = Load(data, size, 0, originalSize); // уменьшенное изображение не удалось преобразовать - декодируем целиком.
             ::GlobalUnlock(hGlobal);
             if(pView)
             {
                 TOpenJpeg* pOpenJpeg = new TOpenJpeg();
                 pOpenJpeg->m_pView = pView;
                 pOpenJpeg->m_format = TImage::Jp2;
+                pOpenJpeg->m_originalSize = originalSize;
+                if(pView->Size() != originalSize)
+                    pOpenJpeg->m_decodeMode = DECODE_MODE_REDUCED;
                 return pOpenJpeg;
             }
         }
@@ -313,10 +321,56 @@ namespace ad
         return stream;
     }
 
-    TView* TOpenJpeg::Load(unsigned char * data, size_t size)
+    // Каждый отброшенный уровень разрешения уменьшает изображение в 2 раза по каждой стороне.
+    // Уровень выбирается так, чтобы размеры уменьшенного изображения оставались кратными
+    // прореживанию цветовых компонент, иначе их не удастся преобразовать в BGRA.
+    static TUInt32 ReduceFactor(opj_codec_t * codec, const opj_image_t * image, size_t reducedSize)
+    {
+        if(reducedSize == 0 || image->numcomps == 0)
+            return 0;
+
+        TUInt32 levelMax = 0;
+        opj_codestream_info_v2_t * info = opj_get_cstr_info(codec);
+        if(info)
+        {
+            if(info->m_default_tile_info.tccp_info)
+            {
+                levelMax = info->m_default_tile_info.tccp_info[0].numresolutions;
+                for(TUInt32 i = 1; i < info->nbcomps; ++i)
+                    levelMax = std::min(levelMax, info->m_default_tile_info.tccp_info[i].numresolutions);
+                levelMax = levelMax > 0 ? levelMax - 1 : 0;
+            }
+            opj_destroy_cstr_info(&info);
+        }
+
+        TUInt32 dx = 1, dy = 1;
+        for(TUInt32 i = 0; i < image->numcomps; ++i)
+        {
+            dx = std::max<TUInt32>(dx, image->comps[i].dx);
+            dy = std::max<TUInt32>(dy, image->comps[i].dy);
+        }
+
+        size_t width = image->x1 - image->x0;
+        size_t height = image->y1 - image->y0;
+        size_t side = std::min(width, height);
+        TUInt32 factor = 0, best = 0;
+        while(factor < levelMax && (side >> (factor + 1)) >= reducedSize)
+        {
+            factor++;
+            size_t reducedWidth = (width + ((size_t)1 << factor) - 1) >> factor;
+            size_t reducedHeight = (height + ((size_t)1 << factor) - 1) >> factor;
+            if(reducedWidth%dx == 0 && reducedHeight%dy == 0)
+                best = factor;
+        }
+        return best;
+    }
+
+    TView* TOpenJpeg::Load(unsigned char * data, size_t size, size_t reducedSize, TPoint & originalSize)
     {
         AD_FUNCTION_PERFORMANCE_TEST
         TView *pView = NULL;
+        // В отличие от других декодеров кодек создается на каждое изображение: в OpenJPEG нет функции сброса, 
+        // а после opj_read_header кодек привязан к заголовку и потоку своего файла.
         opj_codec_t * codec = opj_create_decompress(OpenJpegCodecFormat(data, size));
         if(codec)
         {
@@ -329,10 +383,14 @@ namespace ad
                 opj_image_t  * image; 
                 if (opj_read_header(stream, codec, &image))
                 {
+                    originalSize = TPoint(image->x1 - image->x0, image->y1 - image->y0);
+                    TUInt32 factor = ReduceFactor(codec, image, reducedSize);
+                    if(factor > 0 && !opj_set_decoded_resolution_factor(codec, factor))
+                        factor = 0;
                     if(opj_decode(codec, stream, image))
                     {
-                        size_t width = image->x1 - image->x0;
-                        size_t height = image->y1 - image->y0;
+                        size_t width = factor ? image->comps[0].w : image->x1 - image->x0;
+                        size_t height = factor ? image->comps[0].h : image->y1 - image->y0;
                         if(image->color_space != OPJ_CLRSPC_UNKNOWN && width > 0 && width <= SHRT_MAX &&
                             height > 0 && height <= SHRT_MAX && image->numcomps > 0)
                         {
@@ -31,11 +31,13 @@ namespace ad
     class TOpenJpeg : public TImage
     {
     public:
-        static TOpenJpeg* Load(HGLOBAL hGlobal);
+        // reducedSize > 0: декодируются только уровни разрешения, достаточные для того, 
+        // чтобы меньшая сторона изображения была не меньше reducedSize.
+        static TOpenJpeg* Load(HGLOBAL hGlobal, size_t reducedSize = 0);
         static bool Supported(HGLOBAL hGlobal);
 
     private:
-        static TView* Load(unsigned char *data, size_t size);
+        static TView* Load(unsigned char *data, size_t size, size_t reducedSize, TPoint & originalSize);
     };
 }
 
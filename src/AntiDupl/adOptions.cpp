@@ -24,6 +24,8 @@
 #include "adIniFile.h"
 #include "adFileUtils.h"
 #include "adOptions.h"
+#include "adPerformance.h"
+#include "adTracer.h"
 
 namespace ad
 {
@@ -95,6 +97,7 @@ namespace ad
         m_options.push_back(TOption(&search.HEIF, TEXT("SearchOptions"), TEXT("HEIF"), TRUE, FALSE, TRUE));
         m_options.push_back(TOption(&search.AVIF, TEXT("SearchOptions"), TEXT("AVIF"), TRUE, FALSE, TRUE));
         m_options.push_back(TOption(&search.JXL, TEXT("SearchOptions"), TEXT("JXL"), TRUE, FALSE, TRUE));
+        m_options.push_back(TOption((int*)&search.rescanMode, TEXT("SearchOptions"), TEXT("RescanMode"), AD_RESCAN_FULL, 0, AD_RESCAN_SIZE));
 
         m_options.push_back(TOption(&compare.checkOnEquality, TEXT("CompareOptions"), TEXT("CheckOnEquality"), TRUE, FALSE, TRUE));
         m_options.push_back(TOption(&compare.transformedImage, TEXT("CompareOptions"), TEXT("TransformedImage"), FALSE, FALSE, TRUE));
@@ -107,6 +110,8 @@ namespace ad
         m_options.push_back(TOption(&compare.compareInsideOneFolder, TEXT("CompareOptions"), TEXT("CompareInsideOneFolder"), TRUE, FALSE, TRUE));
 		m_options.push_back(TOption(&compare.compareInsideOneSearchPath, TEXT("CompareOptions"), TEXT("CompareInsideOneSearchPath"), TRUE, FALSE, TRUE));
 		m_options.push_back(TOption((int*)&compare.algorithmComparing, TEXT("CompareOptions"), TEXT("AlgorithmOfComparing"), AD_COMPARING_SQUARED_SUM, 0, AD_COMPARING_SIZE));
+		m_options.push_back(TOption(&compare.nearestCount, TEXT("CompareOptions"), TEXT("NearestCount"), 0, 0, 100));
+		m_options.push_back(TOption(&compare.clusterThreshold, TEXT("CompareOptions"), TEXT("ClusterThreshold"), 0, 0, 50));
 
         m_options.push_back(TOption(&defect.checkOnDefect, TEXT("DefectOptions"), TEXT("CheckOnDefect"), TRUE, FALSE, TRUE));
         m_options.push_back(TOption(&defect.checkOnBlockiness, TEXT("DefectOptions"), TEXT("CheckOnBlockiness"), FALSE, FALSE, TRUE));
@@ -125,6 +130,10 @@ namespace ad
         m_options.push_back(TOption(&advanced.resultCountMax, TEXT("AdvancedOptions"), TEXT("ResultCountMax"), 100000, 1, INT_MAX));
         m_options.push_back(TOption(&advanced.ignoreFrameWidth, TEXT("AdvancedOptions"), TEXT("IgnoreFrameWidth"), 0, 0, 12));
         m_options.push_back(TOption(&advanced.useLibJpegTurbo, TEXT("AdvancedOptions"), TEXT("UseLibJpegTurbo"), TRUE, FALSE, TRUE));
+        m_options.push_back(TOption(&advanced.useThumbnails, TEXT("AdvancedOptions"), TEXT("UseThumbnails"), FALSE, FALSE, TRUE));
+        m_options.push_back(TOption(&advanced.performanceCounters, TEXT("AdvancedOptions"), TEXT("PerformanceCounters"), FALSE, FALSE, TRUE));
+        m_options.push_back(TOption(&advanced.trace, TEXT("AdvancedOptions"), TEXT("Trace"), FALSE, FALSE, TRUE));
+        m_options.push_back(TOption(&advanced.memoryLimit, TEXT("AdvancedOptions"), TEXT("MemoryLimit"), 0, 0, 1048576));
 
         SetDefault();
     }
@@ -133,6 +142,9 @@ namespace ad
     {
         for(TOptionsList::iterator it = m_options.begin();  it != m_options.end(); ++it)
             it->SetDefault();
+
+        TPerformanceCounters::Enable(advanced.performanceCounters == TRUE);
+        TTracer::Enable(advanced.trace == TRUE);
     }
 
     void TOptions::Validate()
@@ -153,6 +165,9 @@ namespace ad
 		// некрасиво сделано, можно вообще убрать эту проверку
 		if (compare.algorithmComparing == AD_COMPARING_SQUARED_SUM && compare.thresholdDifference > 15)
 			compare.thresholdDifference = 5;
+
+        TPerformanceCounters::Enable(advanced.performanceCounters == TRUE);
+        TTracer::Enable(advanced.trace == TRUE);
     }
 
     adError TOptions::Import(adOptionsType optionsType, void * pOptions)
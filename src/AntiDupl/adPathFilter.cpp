@@ -0,0 +1,340 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adFileUtils.h"
+#include "adPath.h"
+#include "adPathFilter.h"
+
+namespace ad
+{
+	const size_t EXTENSION_SET_SIZE_MIN = 16;
+	const size_t EXTENSION_SET_SIZE_MAX = 0x10000;
+	const size_t PATH_TRIE_NODE_NONE = (size_t)-1;
+
+	static inline size_t HashUpper(const TChar *begin, const TChar *end)
+	{
+		size_t hash = 2166136261u;
+		for(; begin < end; ++begin)
+			hash = (hash ^ (size_t)_totupper(*begin))*16777619u;
+		return hash;
+	}
+
+	static inline bool EqualUpper(const TString & upper, const TChar *begin, const TChar *end)
+	{
+		if(upper.size() != size_t(end - begin))
+			return false;
+		for(size_t i = 0; begin < end; ++begin, ++i)
+			if((TChar)_totupper(*begin) != upper[i])
+				return false;
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	TExtensionSet::TExtensionSet()
+		: m_mask(0)
+	{
+	}
+
+	void TExtensionSet::Set(const TStrings & extensions)
+	{
+		TStrings unique;
+		for(size_t i = 0; i < extensions.size(); ++i)
+		{
+			TString extension = extensions[i];
+			extension.ToUpper();
+			if(!extension.empty() && std::find(unique.begin(), unique.end(), extension) == unique.end())
+				unique.push_back(extension);
+		}
+
+		m_table.clear();
+		m_mask = 0;
+		if(unique.empty())
+			return;
+
+		size_t size = EXTENSION_SET_SIZE_MIN;
+		while(size < unique.size()*2)
+			size *= 2;
+		for(;; size *= 2)
+		{
+			// Ищем размер таблицы без коллизий, при неудаче остаются коллизии с линейным пробированием.
+			m_table.assign(size, TString());
+			m_mask = size - 1;
+			bool collision = false;
+			for(size_t i = 0; i < unique.size(); ++i)
+			{
+				size_t slot = HashUpper(unique[i].c_str(), unique[i].c_str() + unique[i].size()) & m_mask;
+				while(!m_table[slot].empty())
+				{
+					collision = true;
+					slot = (slot + 1) & m_mask;
+				}
+				m_table[slot] = unique[i];
+			}
+			if(!collision || size >= EXTENSION_SET_SIZE_MAX)
+				break;
+		}
+	}
+
+	bool TExtensionSet::Has(const TChar *begin, const TChar *end) const
+	{
+		if(m_table.empty() || begin == end)
+			return false;
+		for(size_t slot = HashUpper(begin, end) & m_mask; !m_table[slot].empty(); slot = (slot + 1) & m_mask)
+		{
+			if(EqualUpper(m_table[slot], begin, end))
+				return true;
+		}
+		return false;
+	}
+	//-------------------------------------------------------------------------
+	TPathTrie::TPathTrie()
+		: m_nodes(1)
+	{
+		m_nodes[0].hash = 0;
+		m_nodes[0].terminal = false;
+		m_nodes[0].enableSubFolder = false;
+	}
+
+	void TPathTrie::Set(const TPathContainer & paths)
+	{
+		m_nodes.resize(1);
+		m_nodes[0].children.clear();
+		for(size_t i = 0; i < paths.Size(); ++i)
+			Add(paths[i].Original().c_str(), paths[i].EnableSubFolder());
+	}
+
+	bool TPathTrie::HasPath(const TChar *path) const
+	{
+		if(Empty())
+			return false;
+		size_t node = 0;
+		for(const TChar *begin = Skip(path); *begin != 0;)
+		{
+			if(*begin == DELIMETER)
+			{
+				++begin;
+				continue;
+			}
+			const TChar *end = Next(begin);
+			node = Find(node, begin, end, HashUpper(begin, end));
+			if(node == PATH_TRIE_NODE_NONE)
+				return false;
+			begin = end;
+		}
+		return node != 0 && m_nodes[node].terminal;
+	}
+
+	bool TPathTrie::HasSubPath(const TChar *path) const
+	{
+		if(Empty())
+			return false;
+		size_t node = 0;
+		for(const TChar *begin = Skip(path); *begin != 0;)
+		{
+			if(*begin == DELIMETER)
+			{
+				++begin;
+				continue;
+			}
+			if(node != 0 && m_nodes[node].terminal && m_nodes[node].enableSubFolder)
+				return true;
+			const TChar *end = Next(begin);
+			node = Find(node, begin, end, HashUpper(begin, end));
+			if(node == PATH_TRIE_NODE_NONE)
+				return false;
+			begin = end;
+		}
+		return false;
+	}
+
+	bool TPathTrie::HasParent(const TChar *path) const
+	{
+		if(Empty())
+			return false;
+		size_t node = 0;
+		for(const TChar *begin = Skip(path); *begin != 0;)
+		{
+			if(*begin == DELIMETER)
+			{
+				++begin;
+				continue;
+			}
+			if(node != 0 && m_nodes[node].terminal)
+				return true;
+			const TChar *end = Next(begin);
+			node = Find(node, begin, end, HashUpper(begin, end));
+			if(node == PATH_TRIE_NODE_NONE)
+				return false;
+			begin = end;
+		}
+		return false;
+	}
+
+	void TPathTrie::Add(const TChar *path, bool enableSubFolder)
+	{
+		size_t node = 0;
+		for(const TChar *begin = Skip(path); *begin != 0;)
+		{
+			if(*begin == DELIMETER)
+			{
+				++begin;
+				continue;
+			}
+			const TChar *end = Next(begin);
+			size_t hash = HashUpper(begin, end);
+			size_t child = Find(node, begin, end, hash);
+			if(child == PATH_TRIE_NODE_NONE)
+			{
+				child = m_nodes.size();
+				m_nodes.push_back(TNode());
+				TNode & added = m_nodes.back();
+				added.name = TString(begin, end);
+				added.name.ToUpper();
+				added.hash = hash;
+				added.terminal = false;
+				added.enableSubFolder = false;
+				m_nodes[node].children.push_back(child);
+			}
+			node = child;
+			begin = end;
+		}
+		if(node != 0)
+		{
+			m_nodes[node].terminal = true;
+			m_nodes[node].enableSubFolder = m_nodes[node].enableSubFolder || enableSubFolder;
+		}
+	}
+
+	size_t TPathTrie::Find(size_t node, const TChar *begin, const TChar *end, size_t hash) const
+	{
+		const std::vector<size_t> & children = m_nodes[node].children;
+		for(size_t i = 0; i < children.size(); ++i)
+		{
+			const TNode & child = m_nodes[children[i]];
+			if(child.hash == hash && EqualUpper(child.name, begin, end))
+				return children[i];
+		}
+		return PATH_TRIE_NODE_NONE;
+	}
+
+	const TChar * TPathTrie::Skip(const TChar *path)
+	{
+#ifdef UNICODE
+		for(size_t i = 0; i < EXTENDED_PATH_PREFIX_SIZE; ++i)
+		{
+			if(path[i] != EXTENDED_PATH_PREFIX[i])
+				return path;
+		}
+		return path + EXTENDED_PATH_PREFIX_SIZE;
+#else//UNICODE
+		return path;
+#endif//UNICODE
+	}
+
+	const TChar * TPathTrie::Next(const TChar *begin)
+	{
+		while(*begin != 0 && *begin != DELIMETER)
+			++begin;
+		return begin;
+	}
+	//-------------------------------------------------------------------------
+	TPathFilter::TPathFilter()
+		: m_extensionCount(0)
+		, m_filenameFilterEnabled(false)
+	{
+	}
+
+	void TPathFilter::Init(const TStrings & extensions, const TString & ignoreFilenameFilter, const TPathContainer & ignorePaths)
+	{
+		m_extensions.Set(extensions);
+		m_extensionCount = extensions.size();
+
+		m_filenameFilterEnabled = false;
+		if(!ignoreFilenameFilter.empty())
+		{
+			try
+			{
+				m_filenameFilter.assign(ignoreFilenameFilter, std::regex_constants::ECMAScript | std::regex_constants::optimize);
+				m_filenameFilterEnabled = true;
+			}
+			catch(...)
+			{
+				// Invalid regex, ignore and accept files
+			}
+		}
+
+		m_ignorePaths.Set(ignorePaths);
+	}
+
+	bool TPathFilter::IsWanted(const TString & path) const
+	{
+		if(!HasExtension(path))
+			return false;
+
+		// Check filename filter - only applies to files
+		if(m_filenameFilterEnabled)
+		{
+			const TChar *begin = path.c_str();
+			const TChar *end = begin + path.size();
+			const TChar *name = end;
+			while(name > begin && name[-1] != DELIMETER)
+				--name;
+			if(name == begin)
+				name = end;
+			try
+			{
+				if(std::regex_match(name, end, m_filenameFilter))
+					return false; // File matches filter, reject it
+			}
+			catch(...)
+			{
+				// Regex failed on this name, accept file
+			}
+		}
+		return true;
+	}
+
+	bool TPathFilter::HasExtension(const TString & path) const
+	{
+		const TChar *begin = path.c_str();
+		const TChar *end = begin + path.size();
+		const TChar *extension = end;
+		while(extension > begin && extension[-1] != TEXT('.'))
+			--extension;
+		return extension != begin && m_extensions.Has(extension, end);
+	}
+
+	bool TPathFilter::IsIgnored(const TString & path) const
+	{
+		return m_ignorePaths.HasPath(path.c_str());
+	}
+
+	bool TPathFilter::IsIgnoredSubPath(const TString & path) const
+	{
+		return m_ignorePaths.HasSubPath(path.c_str());
+	}
+
+	bool TPathFilter::IsIgnoredParent(const TString & path) const
+	{
+		return m_ignorePaths.HasParent(path.c_str());
+	}
+}
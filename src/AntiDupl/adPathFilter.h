@@ -0,0 +1,109 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adPathFilter_h__
+#define __adPathFilter_h__
+
+#include "adConfig.h"
+#include "adStrings.h"
+
+#include <regex>
+
+namespace ad
+{
+	class TPathContainer;
+
+	// Множество расширений файлов с идеальным хешированием: размер таблицы подбирается
+	// при построении так, чтобы у расширений не было коллизий. Сравнение без учета регистра.
+	class TExtensionSet
+	{
+	public:
+		TExtensionSet();
+
+		void Set(const TStrings & extensions);
+		bool Has(const TChar *begin, const TChar *end) const;
+
+	private:
+		TStrings m_table;
+		size_t m_mask;
+	};
+
+	// Префиксное дерево по элементам путей. Заменяет двоичный поиск в TPathContainer
+	// для путей, которые еще не разобраны в TPath.
+	class TPathTrie
+	{
+	public:
+		TPathTrie();
+
+		void Set(const TPathContainer & paths);
+		bool Empty() const {return m_nodes.size() == 1;}
+
+		bool HasPath(const TChar *path) const; // Аналог TPathContainer::IsHasPath.
+		bool HasSubPath(const TChar *path) const; // Путь лежит внутри пути с включенными подкаталогами.
+		bool HasParent(const TChar *path) const; // Один из родительских каталогов пути есть в дереве.
+
+	private:
+		struct TNode
+		{
+			TString name;
+			size_t hash;
+			bool terminal;
+			bool enableSubFolder;
+			std::vector<size_t> children;
+		};
+
+		void Add(const TChar *path, bool enableSubFolder);
+		size_t Find(size_t node, const TChar *begin, const TChar *end, size_t hash) const;
+		static const TChar * Skip(const TChar *path);
+		static const TChar * Next(const TChar *begin);
+
+		std::vector<TNode> m_nodes;
+	};
+
+	// Фильтр путей поиска, компилируемый один раз перед обходом каталогов:
+	// расширения, регулярное выражение для имен файлов и игнорируемые пути.
+	// После Init все методы только читают состояние и могут вызываться из разных потоков.
+	class TPathFilter
+	{
+	public:
+		TPathFilter();
+
+		void Init(const TStrings & extensions, const TString & ignoreFilenameFilter, const TPathContainer & ignorePaths);
+
+		bool Empty() const {return m_extensionCount == 0;}
+		bool IsWanted(const TString & path) const;
+		bool HasExtension(const TString & path) const; // Только проверка расширения, без фильтра имен.
+		bool IsIgnored(const TString & path) const;
+		bool IsIgnoredSubPath(const TString & path) const;
+		bool IsIgnoredParent(const TString & path) const;
+
+	private:
+		TExtensionSet m_extensions;
+		size_t m_extensionCount;
+		std::wregex m_filenameFilter;
+		bool m_filenameFilterEnabled;
+		TPathTrie m_ignorePaths;
+	};
+}
+
+#endif//__adPathFilter_h__
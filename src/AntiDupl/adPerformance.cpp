@@ -200,4 +200,119 @@ namespace ad
     }
 
     TPerformanceMeasurerStorage TPerformanceMeasurerStorage::s_storage = TPerformanceMeasurerStorage();
+
+    //-------------------------------------------------------------------------
+
+    volatile bool TPerformanceCounters::s_enabled = false;
+    volatile LONG TPerformanceCounters::s_generation = 0;
+    TCriticalSection TPerformanceCounters::s_criticalSection;
+    TPerformanceCounters::TBlocks TPerformanceCounters::s_blocks;
+    TPerformanceCounters::TBlock TPerformanceCounters::s_released;
+    thread_local TPerformanceCounters::TThreadBlock TPerformanceCounters::s_thread;
+
+	// При включении накопленные ранее значения сбрасываются. Блоки других потоков здесь не 
+	// трогаются: они становятся устаревшими и обнуляются своими потоками.
+    void TPerformanceCounters::Enable(bool enable)
+    {
+        TCriticalSection::TLocker locker(&s_criticalSection);
+        if(enable && !s_enabled)
+        {
+            Clear(s_released);
+            ::InterlockedIncrement(&s_generation);
+        }
+        s_enabled = enable;
+    }
+
+    void TPerformanceCounters::Add(adPerformanceType type, double time)
+    {
+        TBlock *pBlock = s_thread.pBlock;
+        if(pBlock == NULL)
+        {
+            pBlock = new TBlock();
+            Clear(*pBlock);
+            TCriticalSection::TLocker locker(&s_criticalSection);
+            s_blocks.push_back(pBlock);
+            s_thread.pBlock = pBlock;
+        }
+        else if(pBlock->generation != s_generation)
+            Clear(*pBlock);
+
+        TCounter & counter = pBlock->counters[type];
+        counter.count++;
+        counter.total += time;
+        counter.min = std::min(counter.min, time);
+        counter.max = std::max(counter.max, time);
+
+        size_t bucket = 0;
+        for(TUInt64 microseconds = TUInt64(time*1000000.0); microseconds > 0 && bucket < AD_PERFORMANCE_HISTOGRAM_SIZE - 1; microseconds >>= 1)
+            bucket++;
+        counter.histogram[bucket]++;
+    }
+
+    // Вызывается при завершении потока, в том числе созданного не через TThread.
+    void TPerformanceCounters::Release()
+    {
+        TBlock *pBlock = s_thread.pBlock;
+        if(pBlock == NULL)
+            return;
+
+        TCriticalSection::TLocker locker(&s_criticalSection);
+        if(pBlock->generation == s_generation)
+        {
+            for(size_t type = 0; type < AD_PERFORMANCE_SIZE; ++type)
+                Combine(s_released.counters[type], pBlock->counters[type]);
+        }
+        s_blocks.remove(pBlock);
+        delete pBlock;
+        s_thread.pBlock = NULL;
+    }
+
+    adError TPerformanceCounters::Export(adPerformanceType type, adPerformancePtr pPerformance)
+    {
+        if(type < 0 || type >= AD_PERFORMANCE_SIZE)
+            return AD_ERROR_INVALID_PERFORMANCE_TYPE;
+
+        TCounter total;
+        {
+            TCriticalSection::TLocker locker(&s_criticalSection);
+            total = s_released.counters[type];
+            for(TBlocks::const_iterator it = s_blocks.begin(); it != s_blocks.end(); ++it)
+            {
+                if((*it)->generation == s_generation)
+                    Combine(total, (*it)->counters[type]);
+            }
+        }
+
+        pPerformance->count = total.count;
+        pPerformance->total = total.total*1000.0;
+        pPerformance->min = total.count ? total.min*1000.0 : 0;
+        pPerformance->max = total.max*1000.0;
+        for(size_t i = 0; i < AD_PERFORMANCE_HISTOGRAM_SIZE; ++i)
+            pPerformance->histogram[i] = total.histogram[i];
+        return AD_OK;
+    }
+
+    void TPerformanceCounters::Clear(TBlock & block)
+    {
+        for(size_t type = 0; type < AD_PERFORMANCE_SIZE; ++type)
+        {
+            TCounter & counter = block.counters[type];
+            counter.count = 0;
+            counter.total = 0;
+            counter.min = std::numeric_limits<double>::max();
+            counter.max = 0;
+            memset(counter.histogram, 0, sizeof(counter.histogram));
+        }
+        block.generation = s_generation; // после обнуления, чтобы Export не принял старые значения за новые
+    }
+
+    void TPerformanceCounters::Combine(TCounter & counter, const TCounter & other)
+    {
+        counter.count += other.count;
+        counter.total += other.total;
+        counter.min = std::min(counter.min, other.min);
+        counter.max = std::max(counter.max, other.max);
+        for(size_t i = 0; i < AD_PERFORMANCE_HISTOGRAM_SIZE; ++i)
+            counter.histogram[i] += other.histogram[i];
+    }
 }
\ No newline at end of file
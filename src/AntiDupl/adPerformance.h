@@ -109,8 +109,86 @@ namespace ad
 
         static TPerformanceMeasurerStorage s_storage;
     };
+
+    //-------------------------------------------------------------------------
+
+	// Счетчики производительности, которые всегда компилируются и включаются во время работы 
+	// (advanced.performanceCounters). Счетчики общие для всего процесса: их включает опция любого 
+	// движка, и adPerformanceGet каждого движка возвращает сумму по всем потокам процесса.
+	// Каждый поток пишет только в свой блок, поэтому замер обходится без блокировок. При завершении 
+	// любого потока его блок переносится в общий итог и освобождается. Сброс при включении меняет 
+	// поколение, и поток обнуляет свой блок сам при следующем замере, а блоки прошлого поколения 
+	// при чтении пропускаются. Чтение во время поиска не останавливает потоки, и значения могут 
+	// отставать на единичные замеры.
+    class TPerformanceCounters
+    {
+        struct TCounter
+        {
+            TUInt64 count;
+            double total;
+            double min;
+            double max;
+            TUInt64 histogram[AD_PERFORMANCE_HISTOGRAM_SIZE];
+        };
+
+        struct TBlock
+        {
+            volatile LONG generation;
+            TCounter counters[AD_PERFORMANCE_SIZE];
+        };
+        typedef std::list<TBlock*> TBlocks;
+
+        struct TThreadBlock
+        {
+            TBlock *pBlock;
+            TThreadBlock() : pBlock(NULL) {}
+            ~TThreadBlock() {Release();}
+        };
+
+    public:
+        static void Enable(bool enable);
+        static bool Enabled() {return s_enabled;}
+
+        static void Add(adPerformanceType type, double time);
+
+        static adError Export(adPerformanceType type, adPerformancePtr pPerformance);
+
+    private:
+        static void Release();
+        static void Clear(TBlock & block);
+        static void Combine(TCounter & counter, const TCounter & other);
+
+        static volatile bool s_enabled;
+        static volatile LONG s_generation;
+        static TCriticalSection s_criticalSection;
+        static TBlocks s_blocks;
+        static TBlock s_released;
+        static thread_local TThreadBlock s_thread;
+    };
+
+    //-------------------------------------------------------------------------
+
+    class TScopedPerformanceCounter
+    {
+        adPerformanceType m_type;
+        double m_start;
+    public:
+        TScopedPerformanceCounter(adPerformanceType type)
+            :m_type(type), 
+            m_start(TPerformanceCounters::Enabled() ? Time() : -1.0)
+        {
+        }
+
+        ~TScopedPerformanceCounter()
+        {
+            if(m_start >= 0)
+                TPerformanceCounters::Add(m_type, Time() - m_start);
+        }
+    };
 }
 
+#define AD_PERFORMANCE_COUNTER(type) ad::TScopedPerformanceCounter ___spc(type);
+
 #ifdef AD_PERFORMANCE_TEST_ENABLE
 #define AD_PERFORMANCE_TEST(decription) ad::TScopedPerformanceMeasurer ___spm(*(ad::TPerformanceMeasurerStorage::s_storage.Get(decription)));
 #define AD_FUNCTION_PERFORMANCE_TEST AD_PERFORMANCE_TEST(__FUNCTION__)
@@ -23,6 +23,7 @@
 */
 #include "adIO.h"
 #include "adPixelData.h"
+#include "adMemory.h"
 
 namespace ad
 {
@@ -33,9 +34,11 @@ namespace ad
         fast(static_cast<TUInt8*>(SimdAllocate(full, SimdAlignment()))),
         main(fast + FAST_DATA_SIZE),
         filled(false),
+        decodeMode(DECODE_MODE_FULL),
 		average(0),
 		varianceSquare(0)
     {
+        TMemoryCounters::Add(AD_MEMORY_PIXEL_DATA, full);
     }
 
     TPixelData::TPixelData(const TPixelData& pixelData)
@@ -45,9 +48,11 @@ namespace ad
         fast(static_cast<TUInt8*>(SimdAllocate(full, SimdAlignment()))),
         main(fast + FAST_DATA_SIZE),
         filled(false),
+        decodeMode(pixelData.decodeMode),
 		average(pixelData.average),
 		varianceSquare(pixelData.varianceSquare)
     {
+        TMemoryCounters::Add(AD_MEMORY_PIXEL_DATA, full);
         if(pixelData.filled)
         {
             memcpy(fast, pixelData.fast, full);
@@ -58,6 +63,7 @@ namespace ad
     TPixelData::~TPixelData()
     {
         SimdFree((void*)fast);
+        TMemoryCounters::Remove(AD_MEMORY_PIXEL_DATA, full);
     }
 
 	// Делаем очень уменьшенное изображение (4x4) для быстрого сравнения.
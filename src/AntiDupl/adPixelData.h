@@ -37,6 +37,7 @@ namespace ad
         TUInt8* const fast; //уменьшенное изображение (4x4) для быстрого сравнения
         TUInt8* const main;
         bool filled; //true, если создано уменьшенное изображение в main
+        TDecodeMode decodeMode; //из какого представления изображения построен main
 		float average; //average of image - среднее
 		float varianceSquare; //variance of image - Дисперсия случайной величины
 
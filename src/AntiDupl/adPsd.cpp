@@ -24,6 +24,7 @@
 #include "adPerformance.h"
 #include "adIO.h"
 #include "adPsd.h"
+#include "adImageDecoder.h"
 
 namespace ad
 {
@@ -381,12 +382,99 @@ namespace ad
             }
             return true;
         }
+
+        const unsigned short THUMBNAIL_RESOURCE_ID = 1036;
+        const size_t THUMBNAIL_HEADER_SIZE = 28;
+        const size_t FILE_HEADER_SIZE = 26;
+
+        // Ищем в секции Image Resources эскиз (ресурс 1036 в формате JFIF).
+        bool FindThumbnail(const unsigned char * data, size_t size, const unsigned char * & jpeg, size_t & jpegSize, size_t & width, size_t & height)
+        {
+            if(size < FILE_HEADER_SIZE + 8)
+                return false;
+            const unsigned char * end = data + size;
+            const unsigned char * p = data + FILE_HEADER_SIZE;
+            size_t length = ReadLong(p);
+            if((size_t)(end - p) < length + 4)
+                return false;
+            p += length;
+            length = ReadLong(p);
+            if((size_t)(end - p) < length)
+                return false;
+            const unsigned char * resourcesEnd = p + length;
+            while(resourcesEnd - p >= 12 && memcmp(p, "8BIM", 4) == 0)
+            {
+                p += 4;
+                unsigned short id = ReadShort(p);
+                size_t nameLength = (*p + 2) & ~1;
+                if((size_t)(resourcesEnd - p) < nameLength + 4)
+                    return false;
+                p += nameLength;
+                length = ReadLong(p);
+                if((size_t)(resourcesEnd - p) < length)
+                    return false;
+                if(id == THUMBNAIL_RESOURCE_ID && length > THUMBNAIL_HEADER_SIZE)
+                {
+                    const unsigned char * q = p;
+                    unsigned long format = ReadLong(q);
+                    width = ReadLong(q);
+                    height = ReadLong(q);
+                    if(format == 1)
+                    {
+                        jpeg = p + THUMBNAIL_HEADER_SIZE;
+                        jpegSize = length - THUMBNAIL_HEADER_SIZE;
+                        return true;
+                    }
+                }
+                p += (length + 1) & ~1;
+            }
+            return false;
+        }
+    }
+
+    TPsd* TPsd::LoadThumbnail(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions)
+    {
+        TPsd* pPsd = NULL;
+        const unsigned char * data = (unsigned char*)::GlobalLock(hGlobal);
+        const unsigned char * jpeg = NULL;
+        size_t jpegSize = 0, width = 0, height = 0;
+        if(Psd::FindThumbnail(data, ::GlobalSize(hGlobal), jpeg, jpegSize, width, height) && std::min(width, height) >= thumbnailSize)
+        {
+            HGLOBAL hJpeg = ::GlobalAlloc(GMEM_FIXED, jpegSize);
+            if(hJpeg)
+            {
+                memcpy((void*)hJpeg, jpeg, jpegSize);
+                // Декодер JPEG выбирается реестром с учетом опции useLibJpegTurbo.
+                TImage * pJpeg = TImageDecoderRegistry::Instance().Load(hJpeg, pOptions);
+                if(pJpeg)
+                {
+                    const unsigned char * header = data + 14;
+                    pPsd = new TPsd();
+                    pPsd->TakeView(pJpeg);
+                    pPsd->m_format = TImage::Psd;
+                    pPsd->m_decodeMode = DECODE_MODE_THUMBNAIL;
+                    size_t originalHeight = Psd::ReadLong(header);
+                    size_t originalWidth = Psd::ReadLong(header);
+                    pPsd->m_originalSize = TPoint(originalWidth, originalHeight);
+                    delete pJpeg;
+                }
+                ::GlobalFree(hJpeg);
+            }
+        }
+        ::GlobalUnlock(hGlobal);
+        return pPsd;
     }
 
-    TPsd* TPsd::Load(HGLOBAL hGlobal)
+    TPsd* TPsd::Load(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions)
     {
         AD_FUNCTION_PERFORMANCE_TEST
         TPsd* pPsd = NULL;
+        if(hGlobal && thumbnailSize && pOptions)
+        {
+            pPsd = LoadThumbnail(hGlobal, thumbnailSize, pOptions);
+            if(pPsd)
+                return pPsd;
+        }
         if(hGlobal)
         {
             IStream* pStream = NULL;
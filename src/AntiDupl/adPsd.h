@@ -31,8 +31,12 @@ namespace ad
     class TPsd : public TImage
     {
     public:
-        static TPsd* Load(HGLOBAL hGlobal);
+        // thumbnailSize > 0: загрузить встроенный эскиз (не больше 160 точек), если его меньшая сторона не меньше thumbnailSize.
+        static TPsd* Load(HGLOBAL hGlobal, size_t thumbnailSize = 0, const TOptions * pOptions = NULL);
         static bool Supported(HGLOBAL hGlobal);
+
+    private:
+        static TPsd* LoadThumbnail(HGLOBAL hGlobal, size_t thumbnailSize, const TOptions * pOptions);
     };
 }
 
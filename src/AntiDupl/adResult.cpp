@@ -23,6 +23,7 @@
 */
 
 #include "adResult.h"
+#include "adMemory.h"
 
 namespace ad
 {
@@ -41,6 +42,7 @@ namespace ad
         hint(AD_HINT_NONE),
 		deleteByHint(false)
     {
+        TMemoryCounters::Add(AD_MEMORY_RESULT, sizeof(TResult));
     }
 
     TResult::TResult(const TResult& result)
@@ -58,6 +60,12 @@ namespace ad
         hint(result.hint),
 		deleteByHint(result.deleteByHint)
     {
+        TMemoryCounters::Add(AD_MEMORY_RESULT, sizeof(TResult));
+    }
+
+    TResult::~TResult()
+    {
+        TMemoryCounters::Remove(AD_MEMORY_RESULT, sizeof(TResult));
     }
 
     bool TResult::ImageInfoLesser(TImageInfoPtr pFirst, TImageInfoPtr pSecond, TSortType sortType, bool increasing)
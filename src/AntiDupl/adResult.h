@@ -50,6 +50,7 @@ namespace ad
 
         TResult();
         TResult(const TResult& result);
+        ~TResult();
 
         static bool ImageInfoLesser(TImageInfoPtr pFirst, TImageInfoPtr pSecond, TSortType sortType, bool increasing);
         void Swap();
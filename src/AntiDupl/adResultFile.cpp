@@ -0,0 +1,342 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adFileUtils.h"
+#include "adImageInfo.h"
+#include "adResult.h"
+#include "adResultFile.h"
+
+namespace ad
+{
+	const size_t RESULT_FILE_BUFFER_SIZE = 0x100000;
+
+	bool TResultFile::IsChunked(const TChar * fileName, const char * format)
+	{
+		TInputFileStream inputFile(fileName, format);
+		return inputFile.Version() >= RESULT_FILE_CHUNKED_VERSION;
+	}
+
+	//-------------------------------------------------------------------------
+
+	TResultFileWriter::TResultFileWriter(const TChar * fileName, const char * format)
+		: m_stream(fileName, format)
+		, m_offset(strlen(format) + sizeof(TUInt32))
+		, m_heapSize(0)
+	{
+		m_buffer.reserve(RESULT_FILE_BUFFER_SIZE);
+		Align();
+	}
+
+	// Выравниваем начало следующего блока на 8 байт, чтобы записи читались из отображения напрямую.
+	void TResultFileWriter::Align()
+	{
+		const TUInt8 zero[8] = {0};
+		if(m_offset % sizeof(zero))
+			Write(zero, sizeof(zero) - m_offset % sizeof(zero));
+	}
+
+	void TResultFileWriter::BeginChunk(TUInt32 id, size_t recordSize)
+	{
+		TResultFile::TChunk chunk;
+		chunk.id = id;
+		chunk.recordSize = (TUInt32)recordSize;
+		chunk.offset = m_offset;
+		chunk.count = 0;
+		m_chunks.push_back(chunk);
+	}
+
+	void TResultFileWriter::EndChunk()
+	{
+		TResultFile::TChunk & chunk = m_chunks.back();
+		chunk.count = (m_offset - chunk.offset)/chunk.recordSize;
+		Align();
+	}
+
+	void TResultFileWriter::Write(const void * data, size_t size)
+	{
+		if(m_buffer.size() + size > RESULT_FILE_BUFFER_SIZE)
+			Flush();
+		if(size > RESULT_FILE_BUFFER_SIZE)
+			m_stream.Save(data, size);
+		else
+			m_buffer.insert(m_buffer.end(), (const TUInt8*)data, (const TUInt8*)data + size);
+		m_offset += size;
+	}
+
+	void TResultFileWriter::Write(const TString & string)
+	{
+		Write(string.c_str(), string.size()*sizeof(TChar));
+	}
+
+	void TResultFileWriter::Flush()
+	{
+		if(m_buffer.size())
+		{
+			m_stream.Save(m_buffer.data(), m_buffer.size());
+			m_buffer.clear();
+		}
+	}
+
+	void TResultFileWriter::BeginImages()
+	{
+		m_images.clear();
+		m_heapSize = 0;
+		BeginChunk(TResultFile::CHUNK_IMAGES, sizeof(TResultFile::TImageRecord));
+	}
+
+	// Записываем изображение, строки откладываем до блока кучи.
+	void TResultFileWriter::Save(const TImageInfo & imageInfo)
+	{
+		TResultFile::TImageRecord record;
+		memset(&record, 0, sizeof(record));
+		record.path.offset = m_heapSize;
+		record.path.size = imageInfo.path.Original().size();
+		m_heapSize += record.path.size;
+		const TImageExif & exif = imageInfo.imageExif;
+		if(exif.isEmpty)
+			record.flags |= TResultFile::FLAG_EXIF_EMPTY;
+		else
+		{
+			record.exif.offset = m_heapSize;
+			record.exif.size = exif.imageDescription.size() + exif.equipMake.size() + exif.equipModel.size() + 
+				exif.softwareUsed.size() + exif.dateTime.size() + exif.artist.size() + exif.userComment.size() + 
+				TResultFile::EXIF_STRING_COUNT;
+			m_heapSize += record.exif.size;
+		}
+		record.size = imageInfo.size;
+		record.time = imageInfo.time;
+		record.group = imageInfo.group;
+		record.blockiness = imageInfo.blockiness;
+		record.blurring = imageInfo.blurring;
+		record.hash = imageInfo.hash;
+		record.type = imageInfo.type;
+		record.width = imageInfo.width;
+		record.height = imageInfo.height;
+		Write(&record, sizeof(record));
+		m_images.push_back(&imageInfo);
+	}
+
+	// Записываем кучу строк в том же порядке, в котором выданы смещения.
+	void TResultFileWriter::EndImages()
+	{
+		EndChunk();
+		BeginChunk(TResultFile::CHUNK_STRINGS, sizeof(TChar));
+		const TChar zero = 0;
+		for(size_t i = 0; i < m_images.size(); ++i)
+		{
+			const TImageInfo & imageInfo = *m_images[i];
+			Write(imageInfo.path.Original());
+			const TImageExif & exif = imageInfo.imageExif;
+			if(!exif.isEmpty)
+			{
+				const TString * strings[TResultFile::EXIF_STRING_COUNT] = {&exif.imageDescription, &exif.equipMake, 
+					&exif.equipModel, &exif.softwareUsed, &exif.dateTime, &exif.artist, &exif.userComment};
+				for(size_t j = 0; j < TResultFile::EXIF_STRING_COUNT; ++j)
+				{
+					Write(*strings[j]);
+					Write(&zero, sizeof(zero));
+				}
+			}
+		}
+		EndChunk();
+		m_images.clear();
+	}
+
+	void TResultFileWriter::BeginResults()
+	{
+		BeginChunk(TResultFile::CHUNK_RESULTS, sizeof(TResultFile::TResultRecord));
+	}
+
+	void TResultFileWriter::Save(const TResult & result)
+	{
+		TResultFile::TResultRecord record;
+		record.first = result.first->index;
+		record.second = result.type == AD_RESULT_DUPL_IMAGE_PAIR ? result.second->index : AD_UNDEFINED;
+		record.group = result.group;
+		record.groupSize = result.groupSize;
+		record.difference = result.difference;
+		record.type = result.type;
+		record.defect = result.defect;
+		record.transform = result.transform;
+		record.hint = result.hint;
+		Write(&record, sizeof(record));
+	}
+
+	void TResultFileWriter::EndResults()
+	{
+		EndChunk();
+	}
+
+	void TResultFileWriter::Save(const TImageGroupSummaryVector & groups)
+	{
+		BeginChunk(TResultFile::CHUNK_GROUPS, sizeof(TImageGroupSummary));
+		if(groups.size())
+			Write(groups.data(), groups.size()*sizeof(TImageGroupSummary));
+		EndChunk();
+	}
+
+	// Записываем индекс блоков и хвост.
+	void TResultFileWriter::Finish()
+	{
+		TResultFile::TFooter footer;
+		footer.indexOffset = m_offset;
+		footer.chunkCount = (TUInt32)m_chunks.size();
+		footer.magic = TResultFile::FOOTER_MAGIC;
+		Write(m_chunks.data(), m_chunks.size()*sizeof(TResultFile::TChunk));
+		Write(&footer, sizeof(footer));
+		Flush();
+	}
+
+	//-------------------------------------------------------------------------
+
+	TResultFileReader::TResultFileReader(const TChar * fileName, const char * format)
+		: m_hFile(INVALID_HANDLE_VALUE)
+		, m_hMapping(NULL)
+		, m_data(NULL)
+		, m_size(0)
+		, m_chunks(NULL)
+		, m_chunkCount(0)
+	{
+		if(!IsFileExists(fileName))
+			throw TException(AD_ERROR_FILE_IS_NOT_EXIST);
+
+		m_hFile = ::CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+		if(m_hFile == INVALID_HANDLE_VALUE)
+			throw TException(AD_ERROR_CANT_OPEN_FILE);
+
+		try
+		{
+			LARGE_INTEGER size;
+			if(::GetFileSizeEx(m_hFile, &size) == FALSE)
+				throw TException(AD_ERROR_CANT_READ_FILE);
+			m_size = size.QuadPart;
+
+			size_t headerSize = strlen(format) + sizeof(TUInt32);
+			if(m_size < headerSize + sizeof(TResultFile::TFooter) || (TUInt64)(size_t)m_size != m_size)
+				throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+
+			m_hMapping = ::CreateFileMapping(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if(m_hMapping == NULL)
+				throw TException(AD_ERROR_CANT_READ_FILE);
+			m_data = (const TUInt8*)::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+			if(m_data == NULL)
+				throw TException(AD_ERROR_CANT_READ_FILE);
+
+			TUInt32 version = *(const TUInt32*)(m_data + strlen(format));
+			if(memcmp(m_data, format, strlen(format)) != 0 || version < RESULT_FILE_CHUNKED_VERSION || version > FILE_VERSION)
+				throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+
+			const TResultFile::TFooter * pFooter = (const TResultFile::TFooter*)(m_data + m_size - sizeof(TResultFile::TFooter));
+			TUInt64 indexSize = (TUInt64)pFooter->chunkCount*sizeof(TResultFile::TChunk);
+			if(pFooter->magic != TResultFile::FOOTER_MAGIC || pFooter->indexOffset < headerSize || pFooter->indexOffset % 8 || 
+				pFooter->indexOffset + indexSize != m_size - sizeof(TResultFile::TFooter))
+				throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+			m_chunks = (const TResultFile::TChunk*)(m_data + pFooter->indexOffset);
+			m_chunkCount = pFooter->chunkCount;
+
+			m_images = (const TResultFile::TImageRecord*)Chunk(TResultFile::CHUNK_IMAGES, sizeof(TResultFile::TImageRecord), m_imageCount);
+			m_strings = (const TChar*)Chunk(TResultFile::CHUNK_STRINGS, sizeof(TChar), m_stringCount);
+			m_results = (const TResultFile::TResultRecord*)Chunk(TResultFile::CHUNK_RESULTS, sizeof(TResultFile::TResultRecord), m_resultCount);
+			m_groups = (const TImageGroupSummary*)Chunk(TResultFile::CHUNK_GROUPS, sizeof(TImageGroupSummary), m_groupCount);
+		}
+		catch (TException e)
+		{
+			if(m_data)
+				::UnmapViewOfFile(m_data);
+			if(m_hMapping)
+				::CloseHandle(m_hMapping);
+			::CloseHandle(m_hFile);
+			throw TException(e.Error);
+		}
+	}
+
+	TResultFileReader::~TResultFileReader()
+	{
+		::UnmapViewOfFile(m_data);
+		::CloseHandle(m_hMapping);
+		::CloseHandle(m_hFile);
+	}
+
+	// Возвращает начало блока с заданным идентификатором, проверяя его границы.
+	const void * TResultFileReader::Chunk(TUInt32 id, size_t recordSize, size_t & count) const
+	{
+		for(size_t i = 0; i < m_chunkCount; ++i)
+		{
+			const TResultFile::TChunk & chunk = m_chunks[i];
+			if(chunk.id != id)
+				continue;
+			if(chunk.recordSize != recordSize || chunk.offset % 8 || chunk.count > m_size/recordSize || 
+				chunk.offset > m_size || chunk.offset + chunk.count*recordSize > m_size)
+				throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+			count = (size_t)chunk.count;
+			return m_data + chunk.offset;
+		}
+		throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+	}
+
+	TString TResultFileReader::String(const TResultFile::TStringRef & ref) const
+	{
+		if(ref.offset > m_stringCount || ref.size > m_stringCount - ref.offset)
+			throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+		return TString(m_strings + ref.offset, (size_t)ref.size);
+	}
+
+	void TResultFileReader::Load(size_t index, TImageInfo & imageInfo) const
+	{
+		const TResultFile::TImageRecord & record = m_images[index];
+		imageInfo = TImageInfo();
+		TString path = String(record.path);
+		if(!TPath::Valid(path.size()))
+			throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+		imageInfo.path = path;
+		imageInfo.size = record.size;
+		imageInfo.time = record.time;
+		imageInfo.hash = record.hash;
+		if(imageInfo.hash != imageInfo.path.GetCrc32())
+			throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+		imageInfo.type = (TImageType)record.type;
+		imageInfo.width = record.width;
+		imageInfo.height = record.height;
+		imageInfo.blockiness = record.blockiness;
+		imageInfo.blurring = record.blurring;
+		imageInfo.group = (size_t)record.group;
+
+		TImageExif & exif = imageInfo.imageExif;
+		exif.isEmpty = (record.flags & TResultFile::FLAG_EXIF_EMPTY) != 0;
+		if(!exif.isEmpty)
+		{
+			TString strings = String(record.exif);
+			TString * targets[TResultFile::EXIF_STRING_COUNT] = {&exif.imageDescription, &exif.equipMake, 
+				&exif.equipModel, &exif.softwareUsed, &exif.dateTime, &exif.artist, &exif.userComment};
+			size_t begin = 0;
+			for(size_t j = 0; j < TResultFile::EXIF_STRING_COUNT; ++j)
+			{
+				size_t end = strings.find(TChar(0), begin);
+				if(end == TString::npos)
+					throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+				*targets[j] = TString(strings.c_str() + begin, end - begin);
+				begin = end + 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,188 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adResultFile_h__
+#define __adResultFile_h__
+
+#include "adFileStream.h"
+#include "adImageGroup.h"
+
+namespace ad
+{
+	struct TImageInfo;
+	struct TResult;
+
+	// Блочный формат файла результатов (.adr, начиная с версии 6):
+	//   заголовок "adr" + версия;
+	//   блоки фиксированных записей: изображения, куча строк, результаты, группы;
+	//   индекс блоков и хвост, указывающий на индекс.
+	// Файл читается через отображение в память без разбора по полям.
+	const TUInt32 RESULT_FILE_CHUNKED_VERSION = 6;
+
+	struct TResultFile
+	{
+		enum TChunkId
+		{
+			CHUNK_IMAGES = 1,
+			CHUNK_STRINGS = 2,
+			CHUNK_RESULTS = 3,
+			CHUNK_GROUPS = 4,
+		};
+
+		// Ссылка на строку в куче (смещение и длина в символах).
+		struct TStringRef
+		{
+			TUInt64 offset;
+			TUInt64 size;
+		};
+
+		struct TImageRecord
+		{
+			TStringRef path;
+			// Строки Exif, разделенные нулевым символом.
+			TStringRef exif;
+			TUInt64 size;
+			TUInt64 time;
+			TUInt64 group;
+			double blockiness;
+			double blurring;
+			TUInt32 hash;
+			TUInt32 type;
+			TUInt32 width;
+			TUInt32 height;
+			TUInt32 flags;
+			TUInt32 reserved;
+		};
+
+		struct TResultRecord
+		{
+			TUInt64 first;
+			TUInt64 second;
+			TUInt64 group;
+			TUInt64 groupSize;
+			double difference;
+			TUInt32 type;
+			TUInt32 defect;
+			TUInt32 transform;
+			TUInt32 hint;
+		};
+
+		struct TChunk
+		{
+			TUInt32 id;
+			TUInt32 recordSize;
+			TUInt64 offset;
+			TUInt64 count;
+		};
+
+		struct TFooter
+		{
+			TUInt64 indexOffset;
+			TUInt32 chunkCount;
+			TUInt32 magic;
+		};
+
+		static const TUInt32 FOOTER_MAGIC = 0x78726461; // "adrx"
+		static const TUInt32 FLAG_EXIF_EMPTY = 1;
+		static const TUInt32 EXIF_STRING_COUNT = 7;
+
+		static bool IsChunked(const TChar * fileName, const char * format);
+	};
+
+	//-------------------------------------------------------------------------
+
+	// Последовательная запись блоков через буфер.
+	class TResultFileWriter
+	{
+	public:
+		TResultFileWriter(const TChar * fileName, const char * format);
+
+		void BeginImages();
+		void Save(const TImageInfo & imageInfo);
+		void EndImages();
+
+		void BeginResults();
+		void Save(const TResult & result);
+		void EndResults();
+
+		void Save(const TImageGroupSummaryVector & groups);
+
+		void Finish();
+
+	private:
+		void BeginChunk(TUInt32 id, size_t recordSize);
+		void EndChunk();
+		void Write(const void * data, size_t size);
+		void Flush();
+		void Align();
+		void Write(const TString & string);
+
+		TOutputFileStream m_stream;
+		std::vector<TUInt8> m_buffer;
+		std::vector<TResultFile::TChunk> m_chunks;
+		std::vector<const TImageInfo*> m_images;
+		TUInt64 m_offset;
+		TUInt64 m_heapSize;
+	};
+
+	//-------------------------------------------------------------------------
+
+	// Чтение блочного файла результатов, отображенного в память.
+	class TResultFileReader
+	{
+	public:
+		TResultFileReader(const TChar * fileName, const char * format);
+		~TResultFileReader();
+
+		size_t ImageCount() const {return m_imageCount;}
+		void Load(size_t index, TImageInfo & imageInfo) const;
+
+		size_t ResultCount() const {return m_resultCount;}
+		const TResultFile::TResultRecord & Result(size_t index) const {return m_results[index];}
+
+		size_t GroupCount() const {return m_groupCount;}
+		const TImageGroupSummary * Groups() const {return m_groups;}
+
+	private:
+		const void * Chunk(TUInt32 id, size_t recordSize, size_t & count) const;
+		TString String(const TResultFile::TStringRef & ref) const;
+
+		HANDLE m_hFile;
+		HANDLE m_hMapping;
+		const TUInt8 * m_data;
+		TUInt64 m_size;
+		const TResultFile::TChunk * m_chunks;
+		size_t m_chunkCount;
+
+		const TResultFile::TImageRecord * m_images;
+		size_t m_imageCount;
+		const TChar * m_strings;
+		size_t m_stringCount;
+		const TResultFile::TResultRecord * m_results;
+		size_t m_resultCount;
+		const TImageGroupSummary * m_groups;
+		size_t m_groupCount;
+	};
+}
+
+#endif//__adResultFile_h__ 
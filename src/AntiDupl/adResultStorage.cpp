@@ -42,6 +42,9 @@
 #include "adUndoRedoEngine.h"
 #include "adResultStorage.h"
 #include "adFileStream.h"
+#include "adResultFile.h"
+#include "adPerformance.h"
+#include "adTracer.h"
 
 namespace ad
 {
@@ -52,7 +55,8 @@ namespace ad
         :m_pOptions(pEngine->Options()),
         m_pStatus(pEngine->Status()),
         m_pMistakeStorage(pEngine->MistakeStorage()),
-        m_nextId(0)
+        m_nextId(0),
+        m_published(false)
     {
         m_pCriticalSection = new TCriticalSection();
         m_pImageInfoStorage = new TImageInfoStorage(pEngine);
@@ -74,6 +78,8 @@ namespace ad
         double difference, 
         TTransformType transform)
     {
+        AD_PERFORMANCE_COUNTER(AD_PERFORMANCE_RESULT)
+        AD_TRACE("result")
         TCriticalSection::TLocker locker(m_pCriticalSection);
 
         if(m_pUndoRedoEngine->Current()->results.size() >= (size_t)m_pOptions->advanced.resultCountMax)
@@ -264,6 +270,29 @@ namespace ad
         return m_pUndoRedoEngine->Current()->GetSelection(pStartFrom, pSelection, pSelectionSize);
     }
 
+    void TResultStorage::Publish(bool published)
+    {
+        TCriticalSection::TLocker locker(m_pCriticalSection);
+        m_published = published;
+    }
+
+    // Результаты только дописываются в конец под m_pCriticalSection, поэтому уже прочитанные позиции не меняются.
+    adError TResultStorage::ExportPublished(adSizePtr pStartFrom, adResultPtrA pResult, adSizePtr pResultSize) const
+    {
+        TCriticalSection::TLocker locker(m_pCriticalSection);
+        if(!m_published)
+            return AD_ERROR_ACCESS_DENIED;
+        return m_pUndoRedoEngine->Current()->Export(pStartFrom, pResult, pResultSize);
+    }
+
+    adError TResultStorage::ExportPublished(adSizePtr pStartFrom, adResultPtrW pResult, adSizePtr pResultSize) const
+    {
+        TCriticalSection::TLocker locker(m_pCriticalSection);
+        if(!m_published)
+            return AD_ERROR_ACCESS_DENIED;
+        return m_pUndoRedoEngine->Current()->Export(pStartFrom, pResult, pResultSize);
+    }
+
     adError TResultStorage::Export(adSizePtr pStartFrom, adResultPtrA pResult, adSizePtr pResultSize) const
     {
         return m_pUndoRedoEngine->Current()->Export(pStartFrom, pResult, pResultSize);
@@ -326,60 +355,10 @@ namespace ad
 		Clear();
 		try
 		{
-			TInputFileStream inputFile(fileName, RESULT_CONTROL_BYTES);
-
-			m_pImageInfoStorage->Load(inputFile, check);
-
-			size_t size = inputFile.LoadSizeChecked(SIZE_CHECK_LIMIT);
-			TResultPtrVector &results = m_pUndoRedoEngine->Current()->results;
-			results.reserve(size);
-			TResult result;
-			for(size_t i = 0; i < size; i++)
-			{
-				m_pStatus->SetProgress(i, size);
-				inputFile.Load(result);
-				if(result.type == AD_RESULT_DEFECT_IMAGE)
-				{
-					result.first = m_pImageInfoStorage->Get((size_t)result.first);
-					result.second = m_pImageInfoStorage->GetStub();
-					if(!check || result.first->Actual())
-					{
-						if(m_pOptions->advanced.mistakeDataBase == FALSE ||
-							!m_pMistakeStorage->IsHas(result.first))
-						{
-							m_pStatus->AddDefectImage();
-							results.push_back(new TResult(result));
-							results.back()->id = m_nextId++;
-							results.back()->first->links++;
-							if(results.back()->first->group == AD_UNDEFINED)
-								results.back()->first->group = results.back()->group;
-						}
-					}
-				}
-				if(result.type == AD_RESULT_DUPL_IMAGE_PAIR)
-				{
-					result.first = m_pImageInfoStorage->Get((size_t)result.first);
-					result.second = m_pImageInfoStorage->Get((size_t)result.second);
-					if(!check || (result.first->Actual() && result.second->Actual()))
-					{
-						if(m_pOptions->advanced.mistakeDataBase == FALSE ||
-							!m_pMistakeStorage->IsHas(result.first, result.second))
-						{
-							m_pStatus->AddDuplImagePair();
-							results.push_back(new TResult(result));
-							results.back()->id = m_nextId++;
-							results.back()->first->links++;
-							results.back()->second->links++;
-							if(results.back()->first->group == AD_UNDEFINED)
-								results.back()->first->group = results.back()->group;
-							if(results.back()->second->group == AD_UNDEFINED)
-								results.back()->second->group = results.back()->group;
-						}
-					}
-				}
-			}
-			m_pUndoRedoEngine->Current()->UpdateGroups();
-			m_pUndoRedoEngine->Current()->UpdateHints(m_pOptions, true, m_pStatus);
+			if(TResultFile::IsChunked(fileName, RESULT_CONTROL_BYTES))
+				LoadChunked(fileName, check);
+			else
+				LoadStream(fileName, check);
 		}
 		catch (TException e)
 		{
@@ -391,27 +370,149 @@ namespace ad
         return error;
     }
 
+	// Загрузка файла результатов старого формата (версии до 6), записанного последовательно.
+	void TResultStorage::LoadStream(const TChar* fileName, bool check)
+	{
+		TInputFileStream inputFile(fileName, RESULT_CONTROL_BYTES);
+
+		m_pImageInfoStorage->Load(inputFile, check);
+
+		size_t size = inputFile.LoadSizeChecked(SIZE_CHECK_LIMIT);
+		TResultPtrVector &results = m_pUndoRedoEngine->Current()->results;
+		results.reserve(size);
+		TResult result;
+		for(size_t i = 0; i < size; i++)
+		{
+			m_pStatus->SetProgress(i, size);
+			inputFile.Load(result);
+			if(result.type == AD_RESULT_DEFECT_IMAGE)
+			{
+				result.first = m_pImageInfoStorage->Get((size_t)result.first);
+				result.second = m_pImageInfoStorage->GetStub();
+			}
+			if(result.type == AD_RESULT_DUPL_IMAGE_PAIR)
+			{
+				result.first = m_pImageInfoStorage->Get((size_t)result.first);
+				result.second = m_pImageInfoStorage->Get((size_t)result.second);
+			}
+			AddLoaded(result, check);
+		}
+		m_pUndoRedoEngine->Current()->UpdateGroups();
+		m_pUndoRedoEngine->Current()->UpdateHints(m_pOptions, true, m_pStatus);
+	}
+
+	// Загрузка блочного файла результатов из отображения в память. 
+	// Группы восстанавливаются по сохраненной сводке, если при загрузке не было отброшено ни одного результата.
+	// В этом случае подсказки берутся из файла и заново не вычисляются.
+	void TResultStorage::LoadChunked(const TChar* fileName, bool check)
+	{
+		TResultFileReader reader(fileName, RESULT_CONTROL_BYTES);
+
+		m_pImageInfoStorage->Load(reader, check);
+
+		size_t size = reader.ResultCount();
+		TUndoRedoStage *pCurrent = m_pUndoRedoEngine->Current();
+		pCurrent->results.reserve(size);
+		TResult result;
+		for(size_t i = 0; i < size; i++)
+		{
+			m_pStatus->SetProgress(i, size);
+			const TResultFile::TResultRecord & record = reader.Result(i);
+			result.type = (TResultType)record.type;
+			result.first = m_pImageInfoStorage->Get((size_t)record.first);
+			if(result.type == AD_RESULT_DUPL_IMAGE_PAIR)
+				result.second = m_pImageInfoStorage->Get((size_t)record.second);
+			else
+				result.second = m_pImageInfoStorage->GetStub();
+			if(result.first == NULL || result.second == NULL)
+				throw TException(AD_ERROR_INVALID_FILE_FORMAT);
+			result.defect = (TDefectType)record.defect;
+			result.difference = record.difference;
+			result.transform = (TTransformType)record.transform;
+			result.group = (TSize)record.group;
+			result.groupSize = (TSize)record.groupSize;
+			result.hint = (THintType)record.hint;
+			AddLoaded(result, check);
+		}
+		if(pCurrent->results.size() != size || 
+			!pCurrent->groups.Set(pCurrent->results, reader.Groups(), reader.GroupCount()))
+		{
+			pCurrent->UpdateGroups();
+			pCurrent->UpdateHints(m_pOptions, true, m_pStatus);
+		}
+	}
+
+	// Добавляем загруженный результат, если его изображения актуальны и он не отмечен как ошибочный.
+	bool TResultStorage::AddLoaded(const TResult & result, bool check)
+	{
+		TResultPtrVector &results = m_pUndoRedoEngine->Current()->results;
+		if(result.type == AD_RESULT_DEFECT_IMAGE)
+		{
+			if(!check || result.first->Actual())
+			{
+				if(m_pOptions->advanced.mistakeDataBase == FALSE ||
+					!m_pMistakeStorage->IsHas(result.first))
+				{
+					m_pStatus->AddDefectImage();
+					results.push_back(new TResult(result));
+					results.back()->id = m_nextId++;
+					results.back()->first->links++;
+					if(results.back()->first->group == AD_UNDEFINED)
+						results.back()->first->group = results.back()->group;
+					return true;
+				}
+			}
+		}
+		if(result.type == AD_RESULT_DUPL_IMAGE_PAIR)
+		{
+			if(!check || (result.first->Actual() && result.second->Actual()))
+			{
+				if(m_pOptions->advanced.mistakeDataBase == FALSE ||
+					!m_pMistakeStorage->IsHas(result.first, result.second))
+				{
+					m_pStatus->AddDuplImagePair();
+					results.push_back(new TResult(result));
+					results.back()->id = m_nextId++;
+					results.back()->first->links++;
+					results.back()->second->links++;
+					if(results.back()->first->group == AD_UNDEFINED)
+						results.back()->first->group = results.back()->group;
+					if(results.back()->second->group == AD_UNDEFINED)
+						results.back()->second->group = results.back()->group;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
     adError TResultStorage::Save(const TChar* fileName) const
     {
+        AD_TRACE("save result")
 		try
 		{
 			m_pStatus->Reset();
-			TOutputFileStream outputFile(fileName, RESULT_CONTROL_BYTES);
+			TResultFileWriter writer(fileName, RESULT_CONTROL_BYTES);
 
-			m_pImageInfoStorage->Save(outputFile);
+			m_pImageInfoStorage->Save(writer);
 
-			TResultPtrVector &results = m_pUndoRedoEngine->Current()->results;
-			outputFile.SaveSize(results.size());
+			TUndoRedoStage *pCurrent = m_pUndoRedoEngine->Current();
+			TResultPtrVector &results = pCurrent->results;
 
 			m_pStatus->SetProgress(0, 0);
-			size_t i = 0;
-			for(TResultPtrVector::iterator it = results.begin(); it != results.end(); it++, i++)
+			writer.BeginResults();
+			for(size_t i = 0; i < results.size(); i++)
 			{
-				outputFile.Save(**it);
+				writer.Save(*results[i]);
 				m_pStatus->SetProgress(i, results.size());
-				if(m_pStatus->Stopped())
-					break;
 			}
+			writer.EndResults();
+
+			TImageGroupSummaryVector groups;
+			pCurrent->groups.GetSummary(groups);
+			writer.Save(groups);
+
+			writer.Finish();
 			m_pStatus->Reset();
 		}
 		catch (TException e)
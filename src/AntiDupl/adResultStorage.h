@@ -57,6 +57,11 @@ namespace ad
 
         void Clear();
 
+        // Пока результаты опубликованы (во время adWatch), ExportPublished читает их без блокировки движка.
+        void Publish(bool published);
+        adError ExportPublished(adSizePtr pStartFrom, adResultPtrA pResult, adSizePtr pResultSize) const;
+        adError ExportPublished(adSizePtr pStartFrom, adResultPtrW pResult, adSizePtr pResultSize) const;
+
         void Sort(TSortType sortType, bool increasing);
 
         void SetGroup();
@@ -96,6 +101,10 @@ namespace ad
         adError Save(const TChar* fileName) const;
 
     private:
+        void LoadStream(const TChar* fileName, bool check);
+        void LoadChunked(const TChar* fileName, bool check);
+        bool AddLoaded(const TResult & result, bool check);
+
         TImageInfoStorage *m_pImageInfoStorage;
         TCriticalSection *m_pCriticalSection;
         TOptions *m_pOptions;
@@ -104,6 +113,7 @@ namespace ad
         TDuplResultFilter *m_pDuplResultFilter;
         TUndoRedoEngine *m_pUndoRedoEngine;
         size_t m_nextId;
+        bool m_published;
     };
 }
 #endif//__adResultStorage_h__ 
\ No newline at end of file
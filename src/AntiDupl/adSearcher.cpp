@@ -29,27 +29,39 @@
 #include "adImageDataStorage.h"
 #include "adEngine.h"
 #include "adPerformance.h"
+#include "adTracer.h"
 #include "adSearcher.h"
-#include <regex>
 
 namespace ad
 {
+    // Обход каталогов ограничен в основном задержками файловой системы, поэтому потоков больше, чем ядер.
+    const size_t SEARCH_THREAD_COUNT = 8;
+
     TSearcher::TSearcher(TEngine *pEngine, TImageDataPtrs *pImageDataPtrs)
         : m_pImageDataPtrs(pImageDataPtrs)
         , m_pStatus(pEngine->Status())
         , m_pOptions(pEngine->Options())
         , m_pImageDataStorage(pEngine->ImageDataStorage())
+        , m_pDirectoryCache(pEngine->ImageDataStorage()->DirectoryCache())
         , m_searchedImageSize(0)
+        , m_semaphore(NULL)
+        , m_threadCount(0)
+        , m_pending(0)
+        , m_foundNumber(0)
+        , m_foundSize(0)
     {
     }
 
     void TSearcher::SearchImages()
     {
         AD_FUNCTION_PERFORMANCE_TEST;
+        AD_TRACE("search")
         m_searchedImageSize = 0;
         InitExtensions();
-        if(!m_extensions.empty())
+        m_filter.Init(m_extensions, m_pOptions->ignoreFilenameFilter, m_pOptions->ignorePaths);
+        if(!m_filter.Empty())
         {
+            m_pDirectoryCache->SetExtensions(m_extensions);
             for(size_t i = 0; i < m_pOptions->searchPaths.Size(); i++)
             {
                 TString path = CreatePath(m_pOptions->searchPaths[i].Original());
@@ -59,59 +71,241 @@ namespace ad
                 {
 					SearchImages(path, m_pOptions->searchPaths[i].EnableSubFolder());
                 }
-                else if(IsWanted(path))
+                else if(m_filter.IsWanted(path))
                 {
                     m_pImageDataPtrs->push_back(m_pImageDataStorage->Get(TImageInfo(m_pOptions->searchPaths[i].Original())));
                 }
             }
+            if(m_pOptions->search.rescanMode != AD_RESCAN_FULL && !m_pStatus->Stopped())
+                m_pDirectoryCache->Prune();
             m_pStatus->Search(NULL, m_pImageDataPtrs->size(), m_searchedImageSize);
         }
     }
 
     void TSearcher::SearchImages(const TString& directory, bool enableSubFolder)
     {
-        TString path;
-        HANDLE hFind;
-        WIN32_FIND_DATA findData;
+        TDirectory *pRoot = new TDirectory();
+        pRoot->path = directory;
+        m_foundNumber = (LONG)m_pImageDataPtrs->size();
+        m_foundSize = (LONGLONG)m_searchedImageSize;
+
+        if(enableSubFolder)
+        {
+            m_semaphore = ::CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+            m_threadCount = SEARCH_THREAD_COUNT;
+            m_queue.push_back(pRoot);
+            m_pending = 1;
+            ::ReleaseSemaphore(m_semaphore, 1, NULL);
 
-        if(m_pOptions->ignorePaths.IsHasPath(directory) != AD_IS_NOT_EXIST)
+            std::vector<TThread*> threads(m_threadCount);
+            std::vector<HANDLE> handles(m_threadCount);
+            for(size_t i = 0; i < m_threadCount; ++i)
+            {
+                threads[i] = new TThread(this, &TSearcher::Work);
+                handles[i] = threads[i]->Handle();
+                threads[i]->Resume();
+            }
+            ::WaitForMultipleObjects((DWORD)m_threadCount, handles.data(), TRUE, INFINITE);
+            for(size_t i = 0; i < m_threadCount; ++i)
+                delete threads[i];
+            ::CloseHandle(m_semaphore);
+            m_queue.clear();
+        }
+        else
+            Enumerate(pRoot, false);
+
+        Append(pRoot);
+    }
+
+    void TSearcher::Work()
+    {
+        for(;;)
+        {
+            ::WaitForSingleObject(m_semaphore, INFINITE);
+            TDirectory *pDirectory = NULL;
+            {
+                TCriticalSection::TLocker locker(&m_criticalSection);
+                if(m_queue.empty())
+                    break;
+                pDirectory = m_queue.back();
+                m_queue.pop_back();
+            }
+            if(!m_pStatus->Stopped())
+                Enumerate(pDirectory, true);
+            if(::InterlockedDecrement(&m_pending) == 0)
+                ::ReleaseSemaphore(m_semaphore, (LONG)m_threadCount, NULL);
+        }
+    }
+
+    void TSearcher::Enumerate(TDirectory *pDirectory, bool enableSubFolder)
+    {
+        if(m_filter.IsIgnored(pDirectory->path))
             return;
 
-        TString searchPath = CreatePath(directory, TEXT("*"));
+        TDirectoryCache::TEntries listing;
+        bool cached = List(pDirectory->path, listing);
+        std::vector<TDirectory*> children;
+        LONG foundNumber = 0;
+        LONGLONG foundSize = 0;
+
+        for(size_t i = 0; i < listing.size(); ++i)
+        {
+            const TDirectoryCache::TEntry & item = listing[i];
+            if(m_pOptions->search.system == FALSE && 
+                (item.attributes&FILE_ATTRIBUTE_SYSTEM) != 0)
+                continue;
+            if(m_pOptions->search.hidden == FALSE && 
+                (item.attributes&FILE_ATTRIBUTE_HIDDEN) != 0)
+                continue;
 
-        hFind = FindFirstFile(searchPath.c_str(), &findData);
+            TDirectory::TEntry entry;
+            entry.path = CreatePath(pDirectory->path, item.name);
+            entry.size = 0;
+            entry.time = 0;
+            entry.directory = NULL;
+            if((item.attributes&FILE_ATTRIBUTE_DIRECTORY) != 0 && enableSubFolder)
+            {
+                entry.directory = new TDirectory();
+                entry.directory->path = entry.path;
+                children.push_back(entry.directory);
+            }
+            else if(m_filter.IsWanted(entry.path) && !m_filter.IsIgnored(entry.path))
+            {
+                entry.size = item.size;
+                entry.time = item.time;
+                if(cached && m_pOptions->search.rescanMode == AD_RESCAN_CACHED)
+                {
+                    // Изменение содержимого файла не меняет время каталога, поэтому файл проверяем отдельно.
+                    WIN32_FILE_ATTRIBUTE_DATA fileAttributeData;
+                    if(::GetFileAttributesEx(entry.path.c_str(), GetFileExInfoStandard, &fileAttributeData) == FALSE)
+                        continue;
+                    entry.size = adUInt64(fileAttributeData.nFileSizeLow) + adUInt64(fileAttributeData.nFileSizeHigh) * adUInt64(0x100000000);
+                    entry.time = *(TUInt64*)&fileAttributeData.ftLastWriteTime;
+                }
+                foundNumber++;
+                foundSize += entry.size;
+            }
+            else
+                continue;
+            pDirectory->entries.push_back(entry);
+        }
+
+        if(!children.empty())
+        {
+            // Кладем в стек в обратном порядке, чтобы первым обрабатывался первый подкаталог.
+            TCriticalSection::TLocker locker(&m_criticalSection);
+            m_queue.insert(m_queue.end(), children.rbegin(), children.rend());
+            ::InterlockedExchangeAdd(&m_pending, (LONG)children.size());
+            ::ReleaseSemaphore(m_semaphore, (LONG)children.size(), NULL);
+        }
+
+        LONG number = ::InterlockedExchangeAdd(&m_foundNumber, foundNumber) + foundNumber;
+        LONGLONG size = ::InterlockedExchangeAdd64(&m_foundSize, foundSize) + foundSize;
+        m_pStatus->Search(pDirectory->path.c_str(), (size_t)number, (adUInt64)size);
+    }
+
+    bool TSearcher::List(const TString& directory, TDirectoryCache::TEntries & listing)
+    {
+        TUInt64 time = 0;
+        if(m_pOptions->search.rescanMode != AD_RESCAN_FULL)
+        {
+            WIN32_FILE_ATTRIBUTE_DATA directoryAttributeData;
+            if(::GetFileAttributesEx(directory.c_str(), GetFileExInfoStandard, &directoryAttributeData) != FALSE)
+            {
+                time = *(TUInt64*)&directoryAttributeData.ftLastWriteTime;
+                if(m_pDirectoryCache->Get(directory, time, listing))
+                    return true;
+            }
+        }
+
+        TString searchPath = CreatePath(directory, TEXT("*"));
+        WIN32_FIND_DATA findData;
+        HANDLE hFind = ::FindFirstFileEx(searchPath.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
         if(hFind != INVALID_HANDLE_VALUE) 
         {
             do 
             {
-                TString name = findData.cFileName;
-                if(name == TEXT(".") || name == TEXT(".."))
+                TDirectoryCache::TEntry entry;
+                entry.name = findData.cFileName;
+                if(entry.name == TEXT(".") || entry.name == TEXT(".."))
                     continue;
-                if(m_pOptions->search.system == FALSE && 
-                    (findData.dwFileAttributes&FILE_ATTRIBUTE_SYSTEM) != 0)
-                    continue;
-                if(m_pOptions->search.hidden == FALSE && 
-                    (findData.dwFileAttributes&FILE_ATTRIBUTE_HIDDEN) != 0)
+                entry.attributes = findData.dwFileAttributes;
+                if((entry.attributes&FILE_ATTRIBUTE_DIRECTORY) == 0 && !m_filter.HasExtension(entry.name))
                     continue;
+                entry.size = adUInt64(findData.nFileSizeLow) + adUInt64(findData.nFileSizeHigh) * adUInt64(0x100000000);
+                entry.time = *(TUInt64*)&findData.ftLastWriteTime;
+                listing.push_back(entry);
+            } while(::FindNextFile(hFind, &findData) != 0 && !m_pStatus->Stopped()); 
+            ::FindClose(hFind);
 
-                TString path = CreatePath(directory, name);
-                if((findData.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY) != 0 && enableSubFolder)
-                {
-                    SearchImages(path, true);
-                }
-                else if(IsWanted(path.c_str()) && m_pOptions->ignorePaths.IsHasPath(path) == AD_IS_NOT_EXIST)
-                {
-                    adUInt64 imageSize = adUInt64(findData.nFileSizeLow) + adUInt64(findData.nFileSizeHigh) * adUInt64(0x100000000);
-                    m_pImageDataPtrs->push_back(m_pImageDataStorage->Get(TImageInfo(path, imageSize, *(TUInt64*)&findData.ftLastWriteTime)));
-                    m_searchedImageSize += imageSize;
-                }
-            } while(FindNextFile(hFind, &findData) != 0 && !m_pStatus->Stopped()); 
-            FindClose(hFind);
+            // Время каталога прочитано до перечисления: если каталог изменится во время обхода,
+            // при следующем поиске он будет перечислен заново.
+            if(time != 0 && !m_pStatus->Stopped())
+                m_pDirectoryCache->Set(directory, time, listing);
         }
-        m_pStatus->Search(directory.c_str(), m_pImageDataPtrs->size(), m_searchedImageSize);
+        return false;
     }
 
-    bool TSearcher::IsForbidden(const TString& path)
+    void TSearcher::Append(TDirectory *pDirectory)
+    {
+        for(size_t i = 0; i < pDirectory->entries.size(); ++i)
+        {
+            const TDirectory::TEntry & entry = pDirectory->entries[i];
+            if(entry.directory != NULL)
+                Append(entry.directory);
+            else
+            {
+                m_pImageDataPtrs->push_back(m_pImageDataStorage->Get(TImageInfo(entry.path, entry.size, entry.time)));
+                m_searchedImageSize += entry.size;
+            }
+        }
+        delete pDirectory;
+    }
+
+    bool TSearcher::IsWanted(const TString& path, TUInt32 attributes) const
+    {
+        if((attributes&FILE_ATTRIBUTE_DIRECTORY) != 0)
+            return false;
+        if(m_pOptions->search.system == FALSE && 
+            (attributes&FILE_ATTRIBUTE_SYSTEM) != 0)
+            return false;
+        if(m_pOptions->search.hidden == FALSE && 
+            (attributes&FILE_ATTRIBUTE_HIDDEN) != 0)
+            return false;
+        return m_filter.IsWanted(path) && !m_filter.IsIgnored(path) && !m_filter.IsIgnoredParent(path) && 
+            !IsInForbiddenDirectory(path);
+    }
+
+    // Обход не заходит в скрытые и системные каталоги, поэтому и для файла, найденного наблюдением, 
+    // проверяются все каталоги от пути поиска до самого файла.
+    bool TSearcher::IsInForbiddenDirectory(const TString& path) const
+    {
+        if(m_pOptions->search.system == TRUE && m_pOptions->search.hidden == TRUE)
+            return false;
+        TString upper(path);
+        upper.ToUpper();
+        for(size_t i = 0; i < m_pOptions->searchPaths.Size(); ++i)
+        {
+            TString root = CreatePath(m_pOptions->searchPaths[i].Original());
+            TString rootUpper(root);
+            rootUpper.ToUpper();
+            size_t length = rootUpper.size();
+            bool separated = length > 0 && rootUpper[length - 1] == DELIMETER;
+            if(upper.size() <= length || upper.compare(0, length, rootUpper) != 0 || (!separated && upper[length] != DELIMETER))
+                continue;
+            if(IsForbidden(root))
+                return true;
+            for(size_t end = path.find(DELIMETER, separated ? length : length + 1); end != TString::npos; end = path.find(DELIMETER, end + 1))
+            {
+                if(IsForbidden(TString(path.substr(0, end))))
+                    return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    bool TSearcher::IsForbidden(const TString& path) const
     {
         DWORD attributes;
         attributes = GetFileAttributes(path.c_str());
@@ -123,43 +317,12 @@ namespace ad
         if(m_pOptions->search.hidden == FALSE && 
             (attributes&FILE_ATTRIBUTE_HIDDEN) != 0)
             return true;
-        if(m_pOptions->ignorePaths.IsHasSubPath(path) != AD_IS_NOT_EXIST)
-            return true;
-        if(m_pOptions->ignorePaths.IsHasPath(path) != AD_IS_NOT_EXIST)
+        if(m_filter.IsIgnoredSubPath(path) || m_filter.IsIgnored(path))
             return true;
         return false;
     }
 
 
-    bool TSearcher::IsWanted(const TString& path)
-    {
-        TString extension = GetFileExtension(path);
-        extension.ToUpper();
-        for(size_t i = 0; i < m_extensions.size(); ++i)
-        {
-            if(extension == m_extensions[i])
-            {
-                // Check filename filter - only applies to files
-                if(!m_pOptions->ignoreFilenameFilter.empty())
-                {
-                    TString filename = GetFileName(path);
-                    try
-                    {
-                        std::wregex regex(m_pOptions->ignoreFilenameFilter);
-                        if(std::regex_match(filename, regex))
-                            return false; // File matches filter, reject it
-                    }
-                    catch(...)
-                    {
-                        // Invalid regex, ignore and accept file
-                    }
-                }
-                return true;
-            }
-        }
-        return false;
-    }
-
     void TSearcher::InitExtensions()
     {
         m_extensions.clear();
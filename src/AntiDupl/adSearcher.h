@@ -25,6 +25,9 @@
 #define __adSearcher_h__
 
 #include "adConfig.h"
+#include "adThreads.h"
+#include "adPathFilter.h"
+#include "adDirectoryCache.h"
 
 namespace ad
 {
@@ -45,10 +48,33 @@ namespace ad
 
         void SearchImages();
 
+        // Проверка отдельного файла, найденного вне обхода каталогов (режим наблюдения).
+        bool IsWanted(const TString& path, TUInt32 attributes) const;
+
     private:
+        // Узел дерева каталогов. Записи хранятся в порядке перечисления, вложенный каталог
+        // занимает место своей записи, что позволяет после параллельного обхода восстановить
+        // порядок последовательного обхода в глубину.
+        struct TDirectory
+        {
+            struct TEntry
+            {
+                TString path;
+                adUInt64 size;
+                TUInt64 time;
+                TDirectory *directory;
+            };
+            TString path;
+            std::vector<TEntry> entries;
+        };
+
         void SearchImages(const TString& directory, bool enableSubFolder);
-        bool IsWanted(const TString& path);
-        bool IsForbidden(const TString& path);
+        void Work();
+        void Enumerate(TDirectory *pDirectory, bool enableSubFolder);
+        bool List(const TString& directory, TDirectoryCache::TEntries & listing);
+        void Append(TDirectory *pDirectory);
+        bool IsForbidden(const TString& path) const;
+        bool IsInForbiddenDirectory(const TString& path) const;
 
         void InitExtensions();
         void AddExtensions(TImageType imageType, adBool enable);
@@ -57,8 +83,18 @@ namespace ad
         TStatus *m_pStatus;
         TOptions *m_pOptions;
         TImageDataStorage *m_pImageDataStorage;
+        TDirectoryCache *m_pDirectoryCache;
         TStrings m_extensions;
+        TPathFilter m_filter;
         adUInt64 m_searchedImageSize;
+
+        TCriticalSection m_criticalSection;
+        std::vector<TDirectory*> m_queue;
+        HANDLE m_semaphore;
+        size_t m_threadCount;
+        volatile LONG m_pending;
+        volatile LONG m_foundNumber;
+        volatile LONGLONG m_foundSize;
     };
     //-------------------------------------------------------------------------
 }
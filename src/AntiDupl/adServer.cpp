@@ -0,0 +1,420 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <algorithm>
+
+#include "adEngine.h"
+#include "adStatus.h"
+#include "adThreads.h"
+#include "adImageData.h"
+#include "adImageIndex.h"
+#include "adPerformance.h"
+#include "adServer.h"
+
+namespace ad
+{
+	const DWORD SERVER_BUFFER_SIZE = 0x10000;
+	const DWORD SERVER_WAIT_INTERVAL = 100;
+	const DWORD SERVER_CONNECT_TIMEOUT = 5000;
+	const TUInt32 SERVER_BATCH_SIZE_MAX = 0x10000;
+	const char SERVER_REQUEST_CONTROL[] = "adsq";
+	const char SERVER_RESPONSE_CONTROL[] = "adsr";
+	const TChar SERVER_PIPE_PREFIX[] = TEXT("\\\\.\\pipe\\");
+
+	static TString PipePath(const TString & pipeName)
+	{
+		if(pipeName.find(TEXT("\\\\")) == 0)
+			return pipeName;
+		return TString(SERVER_PIPE_PREFIX) + pipeName;
+	}
+
+	template<class T> void Append(std::vector<TUInt8> & buffer, const T & value)
+	{
+		const TUInt8 *p = (const TUInt8*)&value;
+		buffer.insert(buffer.end(), p, p + sizeof(T));
+	}
+
+	static void Append(std::vector<TUInt8> & buffer, const TString & string)
+	{
+		Append(buffer, (TUInt32)string.size());
+		const TUInt8 *p = (const TUInt8*)string.c_str();
+		buffer.insert(buffer.end(), p, p + string.size()*sizeof(TChar));
+	}
+
+	template<class T> bool Extract(const std::vector<TUInt8> & buffer, size_t & offset, T & value)
+	{
+		if(offset + sizeof(T) > buffer.size())
+			return false;
+		memcpy(&value, buffer.data() + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	static bool Extract(const std::vector<TUInt8> & buffer, size_t & offset, TString & string)
+	{
+		TUInt32 length;
+		if(!Extract(buffer, offset, length) || offset + size_t(length)*sizeof(TChar) > buffer.size())
+			return false;
+		const TChar *p = (const TChar*)(buffer.data() + offset);
+		string = TString(p, p + length);
+		offset += length*sizeof(TChar);
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	TServer::TServer(TEngine *pEngine)
+		:m_pStatus(pEngine->Status()),
+		m_pImageIndex(pEngine->ImageIndex())
+	{
+	}
+
+	TServer::~TServer()
+	{
+		Collect(true);
+	}
+
+	// Для каждого клиента создается новый экземпляр канала, поэтому клиенты обслуживаются параллельно.
+	adError TServer::Run(const TString & pipeName)
+	{
+		TString path = PipePath(pipeName);
+		OVERLAPPED overlapped;
+		ZeroMemory(&overlapped, sizeof(overlapped));
+		overlapped.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		adError error = AD_OK;
+		while(!m_pStatus->Stopped())
+		{
+			HANDLE hPipe = ::CreateNamedPipe(path.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, 
+				PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 
+				PIPE_UNLIMITED_INSTANCES, SERVER_BUFFER_SIZE, SERVER_BUFFER_SIZE, 0, NULL);
+			if(hPipe == INVALID_HANDLE_VALUE)
+			{
+				error = AD_ERROR_CANT_CREATE_FILE;
+				break;
+			}
+
+			bool connected = ::ConnectNamedPipe(hPipe, &overlapped) != FALSE;
+			if(!connected)
+			{
+				DWORD size;
+				if(::GetLastError() == ERROR_PIPE_CONNECTED)
+					connected = true;
+				else if(::GetLastError() == ERROR_IO_PENDING)
+					connected = Wait(hPipe, overlapped, size);
+			}
+
+			if(connected)
+			{
+				TConnection *pConnection = new TConnection();
+				pConnection->pServer = this;
+				pConnection->hPipe = hPipe;
+				pConnection->pThread = new TThread(pConnection, &TConnection::Work);
+				pConnection->pThread->Resume();
+				m_connections.push_back(pConnection);
+			}
+			else
+				::CloseHandle(hPipe);
+
+			Collect(false);
+		}
+
+		Collect(true);
+		::CloseHandle(overlapped.hEvent);
+		return error;
+	}
+
+	void TServer::Serve(HANDLE hPipe)
+	{
+		OVERLAPPED overlapped;
+		ZeroMemory(&overlapped, sizeof(overlapped));
+		overlapped.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		std::vector<TUInt8> request, response;
+		while(!m_pStatus->Stopped())
+		{
+			// Сообщение больше буфера читается частями, пока ReadFile сообщает ERROR_MORE_DATA.
+			request.clear();
+			bool complete = false;
+			for(;;)
+			{
+				size_t offset = request.size();
+				request.resize(offset + SERVER_BUFFER_SIZE);
+				DWORD size = 0;
+				BOOL result = ::ReadFile(hPipe, request.data() + offset, SERVER_BUFFER_SIZE, NULL, &overlapped);
+				DWORD lastError = result ? ERROR_SUCCESS : ::GetLastError();
+				if(!result && lastError != ERROR_IO_PENDING && lastError != ERROR_MORE_DATA)
+					break;
+				if(!Wait(hPipe, overlapped, size))
+				{
+					if(::GetLastError() != ERROR_MORE_DATA)
+						break;
+					request.resize(offset + size);
+					continue;
+				}
+				request.resize(offset + size);
+				complete = true;
+				break;
+			}
+			if(!complete)
+				break;
+
+			Process(request, response);
+
+			DWORD size = 0;
+			BOOL result = ::WriteFile(hPipe, response.data(), (DWORD)response.size(), NULL, &overlapped);
+			if(!result && ::GetLastError() != ERROR_IO_PENDING)
+				break;
+			if(!Wait(hPipe, overlapped, size))
+				break;
+		}
+
+		::DisconnectNamedPipe(hPipe);
+		::CloseHandle(hPipe);
+		::CloseHandle(overlapped.hEvent);
+	}
+
+	// Пути пакета обрабатываются по очереди: пакет экономит обмен сообщениями, а параллельность 
+	// обеспечивают одновременно работающие клиенты.
+	void TServer::Process(const std::vector<TUInt8> & request, std::vector<TUInt8> & response)
+	{
+		AD_FUNCTION_PERFORMANCE_TEST
+		TServerRequest header;
+		size_t offset = 0;
+		adError error = AD_OK;
+		if(!Extract(request, offset, header) || memcmp(header.control, SERVER_REQUEST_CONTROL, sizeof(header.control)) != 0 ||
+			header.type >= SERVER_REQUEST_SIZE || header.count > SERVER_BATCH_SIZE_MAX)
+			error = AD_ERROR_INVALID_FILE_FORMAT;
+
+		TStrings paths;
+		for(TUInt32 i = 0; error == AD_OK && i < header.count; ++i)
+		{
+			TString path;
+			if(Extract(request, offset, path))
+				paths.push_back(path);
+			else
+				error = AD_ERROR_INVALID_FILE_FORMAT;
+		}
+		if(error != AD_OK)
+			paths.clear();
+
+		response.clear();
+		TServerResponse responseHeader;
+		memcpy(responseHeader.control, SERVER_RESPONSE_CONTROL, sizeof(responseHeader.control));
+		responseHeader.error = error;
+		responseHeader.count = (TUInt32)paths.size();
+		Append(response, responseHeader);
+
+		TImageIndex::TMatches matches;
+		for(size_t i = 0; i < paths.size(); ++i)
+		{
+			matches.clear();
+			TImageDataPtr pQuery = NULL;
+			TServerResult result;
+			result.error = m_pImageIndex->Create(paths[i], pQuery);
+			if(result.error == AD_OK)
+			{
+				if(header.type != SERVER_REQUEST_INSERT)
+					result.error = m_pImageIndex->Query(pQuery, header.k, header.threshold, matches);
+				if(result.error == AD_OK && header.type != SERVER_REQUEST_QUERY)
+					result.error = m_pImageIndex->Insert(pQuery);
+				delete pQuery;
+			}
+			result.matchCount = (TUInt32)matches.size();
+			Append(response, result);
+			for(size_t j = 0; j < matches.size(); ++j)
+			{
+				TServerMatch match;
+				match.difference = (float)matches[j].difference;
+				match.transform = matches[j].transform;
+				Append(response, match);
+				Append(response, matches[j].path);
+			}
+		}
+	}
+
+	// Ожидание завершения операции с проверкой остановки, при остановке операция отменяется.
+	bool TServer::Wait(HANDLE hPipe, OVERLAPPED & overlapped, DWORD & size)
+	{
+		while(::WaitForSingleObject(overlapped.hEvent, SERVER_WAIT_INTERVAL) == WAIT_TIMEOUT)
+		{
+			if(m_pStatus->Stopped())
+			{
+				::CancelIo(hPipe);
+				::GetOverlappedResult(hPipe, &overlapped, &size, TRUE);
+				::SetLastError(ERROR_OPERATION_ABORTED);
+				return false;
+			}
+		}
+		return ::GetOverlappedResult(hPipe, &overlapped, &size, FALSE) != FALSE;
+	}
+
+	void TServer::Collect(bool all)
+	{
+		for(TConnections::iterator it = m_connections.begin(); it != m_connections.end(); )
+		{
+			TConnection *pConnection = *it;
+			if(::WaitForSingleObject(pConnection->pThread->Handle(), all ? INFINITE : 0) == WAIT_OBJECT_0)
+			{
+				delete pConnection->pThread;
+				delete pConnection;
+				it = m_connections.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+	//-------------------------------------------------------------------------
+	class TServerClient
+	{
+	public:
+		TServerClient(const TString & pipeName, const TStrings & paths, size_t requestCount, size_t batchSize, size_t first)
+			:m_pipeName(pipeName), m_paths(paths), m_requestCount(requestCount), m_batchSize(batchSize), m_first(first), m_errorCount(0)
+		{
+		}
+
+		void Work()
+		{
+			// Без соединения запросы не отправляются: они считаются ошибками и в задержки не попадают.
+			HANDLE hPipe = Open();
+			if(hPipe == INVALID_HANDLE_VALUE)
+			{
+				m_errorCount += m_requestCount;
+				return;
+			}
+			std::vector<TUInt8> request, response;
+			for(size_t i = 0; i < m_requestCount; ++i)
+			{
+				request.clear();
+				TServerRequest header;
+				memcpy(header.control, SERVER_REQUEST_CONTROL, sizeof(header.control));
+				header.type = SERVER_REQUEST_QUERY;
+				header.k = 1;
+				header.threshold = 100.0f;
+				header.count = (TUInt32)m_batchSize;
+				Append(request, header);
+				for(size_t j = 0; j < m_batchSize; ++j)
+					Append(request, m_paths[(m_first + i*m_batchSize + j)%m_paths.size()]);
+
+				double start = Time();
+				bool result = Transact(hPipe, request, response);
+				m_latencies.push_back(Time() - start);
+
+				TServerResponse responseHeader;
+				size_t offset = 0;
+				if(!result || !Extract(response, offset, responseHeader) || responseHeader.error != AD_OK)
+					m_errorCount++;
+			}
+			::CloseHandle(hPipe);
+		}
+
+		const std::vector<double> & Latencies() const {return m_latencies;}
+		size_t ErrorCount() const {return m_errorCount;}
+
+	private:
+		HANDLE Open()
+		{
+			TString path = PipePath(m_pipeName);
+			for(;;)
+			{
+				HANDLE hPipe = ::CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+				if(hPipe != INVALID_HANDLE_VALUE)
+				{
+					DWORD mode = PIPE_READMODE_MESSAGE;
+					::SetNamedPipeHandleState(hPipe, &mode, NULL, NULL);
+					return hPipe;
+				}
+				if(::GetLastError() != ERROR_PIPE_BUSY || !::WaitNamedPipe(path.c_str(), SERVER_CONNECT_TIMEOUT))
+					return INVALID_HANDLE_VALUE;
+			}
+		}
+
+		bool Transact(HANDLE hPipe, const std::vector<TUInt8> & request, std::vector<TUInt8> & response)
+		{
+			DWORD size = 0;
+			if(!::WriteFile(hPipe, request.data(), (DWORD)request.size(), &size, NULL))
+				return false;
+			response.clear();
+			for(;;)
+			{
+				size_t offset = response.size();
+				response.resize(offset + SERVER_BUFFER_SIZE);
+				BOOL result = ::ReadFile(hPipe, response.data() + offset, SERVER_BUFFER_SIZE, &size, NULL);
+				response.resize(offset + size);
+				if(result)
+					return true;
+				if(::GetLastError() != ERROR_MORE_DATA)
+					return false;
+			}
+		}
+
+		TString m_pipeName;
+		const TStrings & m_paths;
+		size_t m_requestCount, m_batchSize, m_first, m_errorCount;
+		std::vector<double> m_latencies;
+	};
+
+	adError ServerBenchmark(const TString & pipeName, const TStrings & paths, size_t clientCount, 
+		size_t requestCount, size_t batchSize, adServerBenchmarkPtr pBenchmark)
+	{
+		if(pBenchmark == NULL)
+			return AD_ERROR_INVALID_POINTER;
+		if(paths.empty() || clientCount == 0 || requestCount == 0 || batchSize == 0 || batchSize > SERVER_BATCH_SIZE_MAX)
+			return AD_ERROR_INVALID_PARAMETER_COMBINATION;
+
+		std::vector<TServerClient*> clients;
+		std::vector<TThread*> threads;
+		std::vector<HANDLE> handles;
+		for(size_t i = 0; i < clientCount; ++i)
+		{
+			size_t count = requestCount/clientCount + (i < requestCount%clientCount ? 1 : 0);
+			clients.push_back(new TServerClient(pipeName, paths, count, batchSize, i*batchSize));
+			threads.push_back(new TThread(clients.back(), &TServerClient::Work));
+			handles.push_back(threads.back()->Handle());
+		}
+
+		double start = Time();
+		for(size_t i = 0; i < threads.size(); ++i)
+			threads[i]->Resume();
+		for(size_t i = 0; i < handles.size(); i += MAXIMUM_WAIT_OBJECTS)
+			::WaitForMultipleObjects((DWORD)std::min<size_t>(handles.size() - i, MAXIMUM_WAIT_OBJECTS), handles.data() + i, TRUE, INFINITE);
+		double total = Time() - start;
+
+		std::vector<double> latencies;
+		size_t errorCount = 0;
+		for(size_t i = 0; i < clients.size(); ++i)
+		{
+			latencies.insert(latencies.end(), clients[i]->Latencies().begin(), clients[i]->Latencies().end());
+			errorCount += clients[i]->ErrorCount();
+			delete threads[i];
+			delete clients[i];
+		}
+		std::sort(latencies.begin(), latencies.end());
+
+		pBenchmark->requestCount = requestCount;
+		pBenchmark->errorCount = errorCount;
+		pBenchmark->throughput = total > 0 ? latencies.size()*batchSize/total : 0;
+		pBenchmark->latencyP50 = latencies.empty() ? 0 : latencies[(latencies.size() - 1)*50/100]*1000.0;
+		pBenchmark->latencyP99 = latencies.empty() ? 0 : latencies[(latencies.size() - 1)*99/100]*1000.0;
+		pBenchmark->latencyMax = latencies.empty() ? 0 : latencies.back()*1000.0;
+		return AD_OK;
+	}
+}
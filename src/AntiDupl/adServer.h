@@ -0,0 +1,118 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adServer_h__
+#define __adServer_h__
+
+#include <list>
+
+#include "adConfig.h"
+#include "adStrings.h"
+
+namespace ad
+{
+	class TEngine;
+	class TStatus;
+	class TThread;
+	class TImageIndex;
+
+	// Протокол сервера. Запрос и ответ - одно сообщение именованного канала в режиме PIPE_TYPE_MESSAGE.
+	// Запрос: TServerRequest, затем count путей, каждый - TUInt32 длина в символах и строка UTF-16 без нуля.
+	// Ответ: TServerResponse, затем для каждого пути TServerResult и matchCount совпадений, 
+	// каждое - TServerMatch и путь в том же виде, что и в запросе.
+#pragma pack(push, 1)
+	struct TServerRequest
+	{
+		char control[4];
+		TUInt32 type; // TServerRequestType
+		TUInt32 k; // максимальное число совпадений на один путь
+		float threshold;
+		TUInt32 count;
+	};
+
+	struct TServerResponse
+	{
+		char control[4];
+		TInt32 error;
+		TUInt32 count;
+	};
+
+	struct TServerResult
+	{
+		TInt32 error;
+		TUInt32 matchCount;
+	};
+
+	struct TServerMatch
+	{
+		float difference;
+		TUInt32 transform;
+	};
+#pragma pack(pop)
+
+	enum TServerRequestType
+	{
+		SERVER_REQUEST_QUERY = 0,
+		SERVER_REQUEST_INSERT = 1,
+		SERVER_REQUEST_QUERY_INSERT = 2, // найти совпадения, затем добавить в индекс
+		SERVER_REQUEST_SIZE
+	};
+	//-------------------------------------------------------------------------
+	// Сервер запросов к индексу изображений через именованный канал. Каждый клиент 
+	// обслуживается своим потоком, работа продолжается до остановки движка.
+	class TServer
+	{
+	public:
+		TServer(TEngine *pEngine);
+		~TServer();
+
+		adError Run(const TString & pipeName);
+
+	private:
+		struct TConnection
+		{
+			TServer *pServer;
+			HANDLE hPipe;
+			TThread *pThread;
+
+			void Work() {pServer->Serve(hPipe);}
+		};
+		typedef std::list<TConnection*> TConnections;
+
+		void Serve(HANDLE hPipe);
+		void Process(const std::vector<TUInt8> & request, std::vector<TUInt8> & response);
+		bool Wait(HANDLE hPipe, OVERLAPPED & overlapped, DWORD & size);
+		void Collect(bool all);
+
+		TStatus *m_pStatus;
+		TImageIndex *m_pImageIndex;
+		TConnections m_connections;
+	};
+	//-------------------------------------------------------------------------
+	// Нагрузочный тест сервера: clientCount клиентов отправляют всего requestCount 
+	// запросов на поиск по batchSize путей из paths и замеряют время ответа.
+	adError ServerBenchmark(const TString & pipeName, const TStrings & paths, size_t clientCount, 
+		size_t requestCount, size_t batchSize, adServerBenchmarkPtr pBenchmark);
+}
+
+#endif//__adServer_h__
@@ -91,6 +91,8 @@ namespace ad
         m_path.clear();
         m_current = 0;
         m_total = 0;
+        m_statistic.collectQueueSize = 0;
+        m_statistic.compareQueueSize = 0;
 
         m_compareThreadStatuses.clear();
         m_collectThreadStatuses.clear();
@@ -275,6 +277,61 @@ namespace ad
         m_statistic.duplImagePairNumber += count;
     }
 
+	// Время передается в секундах, в статистике хранится в миллисекундах.
+    void TStatus::Read(adUInt64 size, double time)
+    {
+        TCriticalSection::TLocker locker(&m_criticalSection);
+
+        m_statistic.readSize += size;
+        m_statistic.readTime += time*1000.0;
+    }
+
+    void TStatus::Decode(TImageType imageType, double time)
+    {
+        if(imageType < AD_IMAGE_NONE || imageType >= AD_IMAGE_SIZE)
+            imageType = AD_IMAGE_NONE;
+
+        TCriticalSection::TLocker locker(&m_criticalSection);
+
+        m_statistic.decodedImageNumber[imageType]++;
+        m_statistic.decodeTime[imageType] += time*1000.0;
+    }
+
+    void TStatus::Reduce(double time)
+    {
+        TCriticalSection::TLocker locker(&m_criticalSection);
+
+        m_statistic.reduceTime += time*1000.0;
+    }
+
+    void TStatus::Compare(adUInt64 visited, adUInt64 pruned, adUInt64 main)
+    {
+        TCriticalSection::TLocker locker(&m_criticalSection);
+
+        m_statistic.visitedCandidateNumber += visited;
+        m_statistic.prunedCandidateNumber += pruned;
+        m_statistic.mainComparisonNumber += main;
+    }
+
+    void TStatus::SetQueueSize(TThreadType threadType, size_t size)
+    {
+        TCriticalSection::TLocker locker(&m_criticalSection);
+
+        switch(threadType)
+        {
+        case AD_THREAD_TYPE_COLLECT:
+            m_statistic.collectQueueSize = size;
+            if(size > m_statistic.collectQueueSizeMax)
+                m_statistic.collectQueueSizeMax = size;
+            break;
+        case AD_THREAD_TYPE_COMPARE:
+            m_statistic.compareQueueSize = size;
+            if(size > m_statistic.compareQueueSizeMax)
+                m_statistic.compareQueueSizeMax = size;
+            break;
+        }
+    }
+
     void TStatus::SetProgress(size_t current, size_t total)
     {
         TCriticalSection::TLocker locker(&m_criticalSection);
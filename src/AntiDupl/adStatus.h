@@ -79,6 +79,12 @@ namespace ad
         void AddDefectImage(ptrdiff_t count = 1);
         void AddDuplImagePair(ptrdiff_t count = 1);
 
+        void Read(adUInt64 size, double time);
+        void Decode(TImageType imageType, double time);
+        void Reduce(double time);
+        void Compare(adUInt64 visited, adUInt64 pruned, adUInt64 main);
+        void SetQueueSize(TThreadType threadType, size_t size);
+
         void DeleteImage(ptrdiff_t count, TInt64 size);
         void RenameImage(ptrdiff_t count);
 
@@ -32,6 +32,9 @@
 #include "adResult.h"
 #include "adResultStorage.h"
 #include "adPerformance.h"
+#include "adMemory.h"
+#include "adNearest.h"
+#include "adCluster.h"
 
 namespace ad
 {
@@ -156,9 +159,10 @@ namespace ad
     }
 
     //-------------------------------------------------------------------------
-    TCollectTask::TCollectTask(size_t threadId, TEngine *pEngine, TCompareManager *pCompareManager)
+    TCollectTask::TCollectTask(size_t threadId, TEngine *pEngine, TCompareManager *pCompareManager, TCollectManager *pCollectManager)
         :TThreadTask(AD_THREAD_TYPE_COLLECT, threadId, pEngine),
-        m_pCompareManager(pCompareManager)
+        m_pCompareManager(pCompareManager),
+        m_pCollectManager(pCollectManager)
     {
         m_pDataCollector = new TDataCollector(pEngine);
     }
@@ -170,7 +174,9 @@ namespace ad
 
     void TCollectTask::DoOwn(TImageData *pImageData)
     {
+        size_t size = pImageData->hGlobal ? ::GlobalSize(pImageData->hGlobal) : 0;
         m_pDataCollector->Fill(pImageData);
+        m_pCollectManager->Processed(size);
         m_pCompareManager->Add(pImageData);
         m_pStatus->Process(AD_THREAD_TYPE_COLLECT, Queue()->Id(), pImageData->path.Original().c_str());
     }
@@ -194,6 +200,7 @@ namespace ad
         {
             i->task->Queue()->Finish();
             WaitForSingleObject(i->thread->Handle(), INFINITE);
+            Finished(i->task);
             delete i->thread;
             delete i->task;
         }
@@ -223,7 +230,9 @@ namespace ad
     }
     //-------------------------------------------------------------------------
     TCompareManager::TCompareManager(TEngine *pEngine)
-        :TThreadManager(pEngine)
+        :TThreadManager(pEngine),
+        m_pNearest(NULL),
+        m_pClusters(NULL)
     {
         m_pCS = new TCriticalSection();
     }
@@ -231,6 +240,10 @@ namespace ad
     TCompareManager::~TCompareManager()
     {
         delete m_pCS;
+        if(m_pNearest)
+            delete m_pNearest;
+        if(m_pClusters)
+            delete m_pClusters;
     }
 
     void TCompareManager::Start(size_t imageCount)
@@ -252,22 +265,61 @@ namespace ad
             thread.thread->Resume();
         }
 
+        if(m_pNearest)
+            delete m_pNearest;
+        m_pNearest = m_pOptions->compare.nearestCount > 0 ? new TNearest(m_pOptions->compare.nearestCount) : NULL;
+        if(m_pClusters)
+            delete m_pClusters;
+        m_pClusters = m_pOptions->compare.clusterThreshold > 0 ? new TClusters(m_pOptions->compare.clusterThreshold) : NULL;
+
         m_addCounter = 0;
     }
 
     void TCompareManager::Add(TImageData *pImageData)
     {
-        if(CanCompare(pImageData))
+        if(m_pThreads != NULL && CanCompare(pImageData))
         {
             TCriticalSection::TLocker locker(m_pCS);
             size_t threadId = m_addCounter%m_pThreads->size();
+            size_t queueSize = 0;
             for(TThreads::iterator i = m_pThreads->begin(); i != m_pThreads->end(); i++)
+            {
                 i->task->Queue()->Push(pImageData, threadId);
+                queueSize = std::max(queueSize, i->task->Queue()->Size());
+            }
             m_pEngine->Status()->Assign(AD_THREAD_TYPE_COMPARE, threadId);
+            m_pEngine->Status()->SetQueueSize(AD_THREAD_TYPE_COMPARE, queueSize);
             m_addCounter++;
         }
     }
 
+	// Ближайшие пары и кластеры попадают в результаты только после окончания сравнения всеми потоками.
+    void TCompareManager::Finish()
+    {
+        TThreadManager::Finish();
+        if(m_pClusters)
+        {
+            m_pClusters->Export(m_pEngine->Result());
+            delete m_pClusters;
+            m_pClusters = NULL;
+        }
+        if(m_pNearest)
+        {
+            m_pNearest->Export(m_pEngine->Result());
+            delete m_pNearest;
+            m_pNearest = NULL;
+        }
+    }
+
+    void TCompareManager::Finished(TThreadTask *pTask)
+    {
+        TImageComparer *pImageComparer = ((TCompareTask*)pTask)->ImageComparer();
+        if(m_pNearest && pImageComparer->Nearest())
+            m_pNearest->Merge(*pImageComparer->Nearest());
+        if(m_pClusters && pImageComparer->Clusters())
+            m_pClusters->Merge(*pImageComparer->Clusters());
+    }
+
     size_t TCompareManager::DefaultThreadCount(size_t imageCount)
     {
         size_t threadCountMax = GetProcessorCount();
@@ -288,7 +340,8 @@ namespace ad
     //-------------------------------------------------------------------------
     TCollectManager::TCollectManager(TEngine *pEngine, TCompareManager* pCompareManager)
         :TThreadManager(pEngine),
-        m_pCompareManager(pCompareManager)
+        m_pCompareManager(pCompareManager),
+        m_inFlight(0)
     {
     }
 
@@ -306,22 +359,33 @@ namespace ad
         for(size_t i = 0; i < threadCount; i++)
         {
             TThread& thread = m_pThreads->at(i);
-            thread.task = new TCollectTask(i, m_pEngine, m_pCompareManager);
+            thread.task = new TCollectTask(i, m_pEngine, m_pCompareManager, this);
             thread.thread = new ad::TThread(thread.task);
             thread.thread->Resume();
         }
 
         m_addCounter = 0;
+        m_inFlight = 0;
     }
 
     void TCollectManager::Add(TImageData *pImageData)
     {
         if(pImageData->DefectCheckingNeed(m_pOptions) || pImageData->PixelDataFillingNeed(m_pOptions) || pImageData->crc32c == 0)
         {
+            Throttle();
+            double start = Time();
             pImageData->hGlobal = LoadFileToMemory(pImageData->path.Original().c_str());
+            size_t size = pImageData->hGlobal ? ::GlobalSize(pImageData->hGlobal) : 0;
+            m_pEngine->Status()->Read(size, Time() - start);
+            ::InterlockedExchangeAdd64(&m_inFlight, (LONGLONG)size);
             size_t threadId = GetThreadId();
             m_pThreads->at(threadId).task->Queue()->Push(pImageData, threadId);
             m_pEngine->Status()->Assign(AD_THREAD_TYPE_COLLECT, threadId);
+
+            size_t queueSize = 0;
+            for(TThreads::iterator it = m_pThreads->begin(); it != m_pThreads->end(); it++)
+                queueSize += it->task->Queue()->Size();
+            m_pEngine->Status()->SetQueueSize(AD_THREAD_TYPE_COLLECT, queueSize);
         }
         else
         {
@@ -365,5 +429,36 @@ namespace ad
         }
         return threadId;
     }
+
+    void TCollectManager::Processed(size_t size)
+    {
+        ::InterlockedExchangeAdd64(&m_inFlight, -(LONGLONG)size);
+    }
+
+	// Мягкое ограничение памяти advanced.memoryLimit, две проверки:
+	// 1) упреждающее чтение: пока прочитанные этим движком, но еще не обработанные файлы занимают больше 
+	//    ограничения, новые файлы не читаются;
+	// 2) память процесса: пока AD_MEMORY_TOTAL (все подсистемы всех движков процесса, включая данные, 
+	//    которые хранятся до конца поиска) больше ограничения, очередной файл читается только после того, 
+	//    как потоки сбора разберут свои очереди, то есть сбор идет без упреждающего чтения.
+	// Ожидание прекращается, когда очереди пусты, поэтому поиск не останавливается, даже если память, 
+	// занятая до него, уже больше ограничения.
+    void TCollectManager::Throttle() const
+    {
+        if(m_pOptions->advanced.memoryLimit <= 0)
+            return;
+        LONGLONG limit = LONGLONG(m_pOptions->advanced.memoryLimit)*1024*1024;
+        while(!m_pEngine->Status()->Stopped() && 
+            (m_inFlight > limit || TMemoryCounters::Current(AD_MEMORY_TOTAL) > TUInt64(limit)))
+        {
+            size_t queueSize = 0;
+            for(TThreads::iterator it = m_pThreads->begin(); it != m_pThreads->end(); it++)
+                queueSize += it->task->Queue()->Size();
+            if(queueSize == 0)
+                break;
+            m_pEngine->Status()->Wait(AD_THREAD_TYPE_MAIN, 0); 
+            ::Sleep(DEAFAULT_THREAD_SLEEP_INTERVAL);
+        }
+    }
     //-------------------------------------------------------------------------
 }
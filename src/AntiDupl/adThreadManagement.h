@@ -35,6 +35,8 @@ namespace ad
     class TCompareManager;
     class TImageComparer;
     class TDataCollector;
+    class TNearest;
+    class TClusters;
     //-------------------------------------------------------------------------
     class TThreadQueue
     {
@@ -103,6 +105,8 @@ namespace ad
         TCompareTask(size_t threadId, TEngine *pEngine);
         ~TCompareTask();
 
+        TImageComparer* ImageComparer() {return m_pImageComparer;}
+
     protected:
         virtual void DoOwn(TImageData *pImageData);
         virtual void DoOther(TImageData *pImageData);
@@ -111,10 +115,12 @@ namespace ad
         TImageComparer* m_pImageComparer;
     };
     //-------------------------------------------------------------------------
+    class TCollectManager;
+
     class TCollectTask : public TThreadTask
     {
     public:
-        TCollectTask(size_t threadId, TEngine *pEngine, TCompareManager *pCompareManager);
+        TCollectTask(size_t threadId, TEngine *pEngine, TCompareManager *pCompareManager, TCollectManager *pCollectManager);
         ~TCollectTask();
 
     protected:
@@ -124,6 +130,7 @@ namespace ad
     private:
         TDataCollector* m_pDataCollector;
         TCompareManager *m_pCompareManager;
+        TCollectManager *m_pCollectManager;
     };
     //-------------------------------------------------------------------------
     class TThreadManager
@@ -147,6 +154,7 @@ namespace ad
 
     protected:
         static size_t GetProcessorCount();
+        virtual void Finished(TThreadTask *pTask) {} // вызывается для каждой задачи перед ее удалением
 
         TThreads *m_pThreads;
         TEngine *m_pEngine;
@@ -163,14 +171,18 @@ namespace ad
 
         void Start(size_t imageCount);
         virtual void Add(TImageData *pImageData);
+        void Finish();
 
     protected:
         size_t DefaultThreadCount(size_t imageCount);
+        virtual void Finished(TThreadTask *pTask);
 
     private:
         bool CanCompare(TImageData *pImageData) const;
 
         TCriticalSection *m_pCS;
+        TNearest *m_pNearest;
+        TClusters *m_pClusters;
    };
     //-------------------------------------------------------------------------
     class TCollectManager : public TThreadManager
@@ -182,13 +194,18 @@ namespace ad
         void Start();
         virtual void Add(TImageData *pImageData);
 
+        // Вызывается потоком сбора, когда прочитанный файл размера size обработан и освобожден.
+        void Processed(size_t size);
+
     protected:
         size_t DefaultThreadCount();
 
     private:
         TCompareManager *m_pCompareManager;
+        volatile LONGLONG m_inFlight; // память файлов этого движка, прочитанных, но еще не обработанных
         
         size_t GetThreadId() const;
+        void Throttle() const;
     };
     //-------------------------------------------------------------------------
 }
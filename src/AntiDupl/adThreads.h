@@ -124,6 +124,30 @@ namespace ad
 		void Enter() {EnterCriticalSection(&m_CS);};
 		void Leave() {LeaveCriticalSection(&m_CS);};
 	};
+	//-------------------------------------------------------------------------
+	// Блокировка с разделяемым доступом на чтение
+	class TReadWriteLock
+	{
+		SRWLOCK m_lock;
+	public:
+		class TReader
+		{
+			TReadWriteLock *m_pLock;
+		public:
+			TReader(TReadWriteLock *pLock) :m_pLock(pLock) {AcquireSRWLockShared(&m_pLock->m_lock);};
+			~TReader() {ReleaseSRWLockShared(&m_pLock->m_lock);};
+		};
+
+		class TWriter
+		{
+			TReadWriteLock *m_pLock;
+		public:
+			TWriter(TReadWriteLock *pLock) :m_pLock(pLock) {AcquireSRWLockExclusive(&m_pLock->m_lock);};
+			~TWriter() {ReleaseSRWLockExclusive(&m_pLock->m_lock);};
+		};
+
+		TReadWriteLock() {InitializeSRWLock(&m_lock);};
+	};
 }
 
 #endif//__adThreads_h__
\ No newline at end of file
@@ -0,0 +1,196 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <fstream>
+#include <iomanip>
+
+#include "adTracer.h"
+
+namespace ad
+{
+    const size_t TRACE_BUFFER_SIZE = 0x10000;
+
+    //-------------------------------------------------------------------------
+
+    volatile bool TTracer::s_enabled = false;
+    TCriticalSection TTracer::s_criticalSection;
+    TTracer::TBuffers TTracer::s_buffers;
+    TTracer::TBuffers TTracer::s_finished;
+    volatile size_t TTracer::s_generation = 1;
+    thread_local TTracer::TThreadBuffer TTracer::s_thread;
+
+    // При выключении накопленные события отбрасываются.
+    void TTracer::Enable(bool enable)
+    {
+        TCriticalSection::TLocker locker(&s_criticalSection);
+        if(!enable && s_enabled)
+            Clear();
+        s_enabled = enable;
+    }
+
+    void TTracer::Add(const char *name, double start, double finish)
+    {
+        Push(name, start, finish, false);
+    }
+
+    void TTracer::Counter(const char *name, double time, double value)
+    {
+        Push(name, time, value, true);
+    }
+
+    // Младшие 40 бит - номер события плюс 1, поэтому у незаполненной ячейки (0) отметки нет.
+    LONGLONG TTracer::Stamp(size_t generation, size_t index)
+    {
+        return (LONGLONG(generation) << 40) | (LONGLONG(index + 1) & 0xFFFFFFFFFFLL);
+    }
+
+    // После записи файла или выключения поток сам начинает свой буфер заново. Старые события 
+    // остаются в ячейках, но их отметки относятся к прошлому поколению, и Write их не берет.
+    void TTracer::Push(const char *name, double start, double finish, bool counter)
+    {
+        TBuffer *pBuffer = s_thread.pBuffer;
+        if(pBuffer == NULL)
+        {
+            pBuffer = new TBuffer();
+            pBuffer->threadId = TThread::CurrentId();
+            pBuffer->count = 0;
+            pBuffer->events.resize(TRACE_BUFFER_SIZE);
+            TCriticalSection::TLocker locker(&s_criticalSection);
+            pBuffer->generation = s_generation;
+            s_buffers.push_back(pBuffer);
+            s_thread.pBuffer = pBuffer;
+        }
+        else if(pBuffer->generation != s_generation)
+        {
+            pBuffer->count = 0;
+            pBuffer->generation = s_generation;
+        }
+
+        size_t index = pBuffer->count;
+        TEvent & event = pBuffer->events[index%TRACE_BUFFER_SIZE];
+        ::InterlockedExchange64(&event.stamp, 0);
+        pBuffer->count = index + 1;
+        event.name = name;
+        event.start = start;
+        event.finish = finish;
+        event.counter = counter;
+        ::InterlockedExchange64(&event.stamp, Stamp(pBuffer->generation, index));
+    }
+
+    // Вызывается при завершении любого потока. События текущего поколения сохраняются до записи файла.
+    void TTracer::Release()
+    {
+        TBuffer *pBuffer = s_thread.pBuffer;
+        if(pBuffer == NULL)
+            return;
+
+        TCriticalSection::TLocker locker(&s_criticalSection);
+        s_buffers.remove(pBuffer);
+        if(pBuffer->generation == s_generation && pBuffer->count)
+            s_finished.push_back(pBuffer);
+        else
+            delete pBuffer;
+        s_thread.pBuffer = NULL;
+    }
+
+    bool TTracer::Write(const TString & fileName)
+    {
+        TCriticalSection::TLocker locker(&s_criticalSection);
+
+        // Потоки могут продолжать писать, поэтому события копируются: ячейка берется, если до и после 
+        // копирования в ней отметка ожидаемого события, иначе поток ее заполняет или уже переписал.
+        std::vector<unsigned int> threadIds;
+        std::vector<std::vector<TEvent> > events;
+        double origin = std::numeric_limits<double>::max();
+        const TBuffers * lists[2] = {&s_buffers, &s_finished};
+        for(size_t l = 0; l < 2; ++l)
+        {
+            for(TBuffers::const_iterator it = lists[l]->begin(); it != lists[l]->end(); ++it)
+            {
+                TBuffer & buffer = **it;
+                if(buffer.generation != s_generation)
+                    continue;
+                threadIds.push_back(buffer.threadId);
+                events.push_back(std::vector<TEvent>());
+                size_t count = buffer.count;
+                for(size_t i = count > TRACE_BUFFER_SIZE ? count - TRACE_BUFFER_SIZE : 0; i < count; ++i)
+                {
+                    TEvent & slot = buffer.events[i%TRACE_BUFFER_SIZE];
+                    LONGLONG stamp = Stamp(s_generation, i);
+                    if(::InterlockedCompareExchange64(&slot.stamp, 0, 0) != stamp)
+                        continue;
+                    TEvent event;
+                    event.name = slot.name;
+                    event.start = slot.start;
+                    event.finish = slot.finish;
+                    event.counter = slot.counter;
+                    if(::InterlockedCompareExchange64(&slot.stamp, 0, 0) != stamp)
+                        continue;
+                    events.back().push_back(event);
+                    origin = std::min(origin, event.start);
+                }
+            }
+        }
+
+        std::ofstream ofs(fileName.c_str());
+        if(!ofs.is_open())
+        {
+            Clear();
+            return false;
+        }
+
+        ofs << "{\"traceEvents\":[" << std::endl;
+        ofs << std::fixed << std::setprecision(3);
+        bool first = true;
+        for(size_t b = 0; b < events.size(); ++b)
+        {
+            for(size_t i = 0; i < events[b].size(); ++i)
+            {
+                const TEvent & event = events[b][i];
+                if(!first)
+                    ofs << "," << std::endl;
+                first = false;
+                ofs << "{\"name\":\"" << event.name << "\",\"ph\":\"" << (event.counter ? "C" : "X") << "\",\"pid\":1,\"tid\":" << threadIds[b];
+                ofs << ",\"ts\":" << (event.start - origin)*1000000.0;
+                if(event.counter)
+                    ofs << ",\"args\":{\"bytes\":" << event.finish << "}}";
+                else
+                    ofs << ",\"dur\":" << (event.finish - event.start)*1000000.0 << "}";
+            }
+        }
+        ofs << std::endl << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+
+        bool result = ofs.good();
+        Clear();
+        return result;
+    }
+
+    // Освобождаются только буферы завершившихся потоков, буферы работающих потоков начинаются заново ими самими.
+    void TTracer::Clear()
+    {
+        for(TBuffers::iterator it = s_finished.begin(); it != s_finished.end(); ++it)
+            delete *it;
+        s_finished.clear();
+        s_generation++;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adTracer_h__
+#define __adTracer_h__
+
+#include "adPerformance.h"
+
+namespace ad
+{
+    //-------------------------------------------------------------------------
+
+    // Трассировка в формате Chrome trace-event (chrome://tracing, ui.perfetto.dev), 
+    // включается опцией advanced.trace. Трассировка общая для всего процесса: ее включает опция 
+    // любого движка, а файл, записанный по окончании поиска, содержит события всех потоков процесса.
+    // Каждый поток пишет события в свой кольцевой буфер без блокировок, при переполнении буфера 
+    // теряются самые старые события потока. Буфер работающего потока никогда не освобождается 
+    // другим потоком: запись файла и выключение только меняют поколение, и поток сам начинает 
+    // буфер заново при следующем событии. Буферы завершившихся потоков хранятся до записи файла.
+    // Событие публикуется отметкой (поколение и номер события в буфере), которая пишется последней, 
+    // а перед заполнением ячейки сбрасывается; Write берет только ячейки с ожидаемой отметкой.
+    class TTracer
+    {
+        struct TEvent
+        {
+            const char *name;
+            double start;
+            double finish; // для счетчика - его значение
+            bool counter;
+            volatile LONGLONG stamp;
+        };
+
+        struct TBuffer
+        {
+            unsigned int threadId;
+            volatile size_t count;
+            volatile size_t generation;
+            std::vector<TEvent> events;
+        };
+        typedef std::list<TBuffer*> TBuffers;
+
+        struct TThreadBuffer
+        {
+            TBuffer *pBuffer;
+            TThreadBuffer() : pBuffer(NULL) {}
+            ~TThreadBuffer() {Release();}
+        };
+
+    public:
+        static void Enable(bool enable);
+        static bool Enabled() {return s_enabled;}
+
+        static void Add(const char *name, double start, double finish);
+        // Значение счетчика в момент time, отображается отдельной дорожкой.
+        static void Counter(const char *name, double time, double value);
+
+        // Записывает накопленные события в файл и начинает новое поколение. Может вызываться, 
+        // пока другие потоки пишут события: они попадут в файл частично или в следующее поколение.
+        static bool Write(const TString & fileName);
+
+    private:
+        static void Push(const char *name, double start, double finish, bool counter);
+        static LONGLONG Stamp(size_t generation, size_t index);
+        static void Release();
+        static void Clear();
+
+        static volatile bool s_enabled;
+        static TCriticalSection s_criticalSection;
+        static TBuffers s_buffers; // буферы работающих потоков
+        static TBuffers s_finished; // буферы завершившихся потоков
+        static volatile size_t s_generation;
+        static thread_local TThreadBuffer s_thread;
+    };
+
+    //-------------------------------------------------------------------------
+
+    class TScopedTrace
+    {
+        const char *m_name;
+        double m_start;
+    public:
+        TScopedTrace(const char *name)
+            :m_name(name),
+            m_start(TTracer::Enabled() ? Time() : -1.0)
+        {
+        }
+
+        ~TScopedTrace()
+        {
+            if(m_start >= 0)
+                TTracer::Add(m_name, m_start, Time());
+        }
+    };
+}
+
+#define AD_TRACE(name) ad::TScopedTrace ___str(name);
+
+#endif//__adTracer_h__
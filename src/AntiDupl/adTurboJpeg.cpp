@@ -98,11 +98,17 @@ namespace ad
         {
             const unsigned char * data = (unsigned char*)::GlobalLock(hGlobal);
             size_t size = ::GlobalSize(hGlobal);
-            bool supported = (size >= 4 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF && data[3] == 0xE0);
+            bool supported = Supported(data, size);
             ::GlobalUnlock(hGlobal);
             return supported;
         }
         return false;
     }
+
+    // SOI маркер, за которым следует любой маркер: APP0 (JFIF), APP1 (Exif), DQT и т.д.
+    bool TTurboJpeg::Supported(const unsigned char * data, size_t size)
+    {
+        return size >= 4 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF && data[3] >= 0xC0 && data[3] != 0xFF;
+    }
 }
 #endif//AD_TURBO_JPEG_ENABLE
\ No newline at end of file
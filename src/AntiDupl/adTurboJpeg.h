@@ -34,6 +34,7 @@ namespace ad
     public:
         static TTurboJpeg * Load(HGLOBAL hGlobal);
         static bool Supported(HGLOBAL hGlobal);
+        static bool Supported(const unsigned char * data, size_t size);
     };
 }
 #endif//AD_TURBO_JPEG_ENABLE
@@ -42,8 +42,8 @@ namespace ad
         m_pImageInfoStorage(pImageInfoStorage),
         m_pRecycleBin(pEngine->RecycleBin())
     {
-        m_pUndoDeque = new TUndoRedoStagePtrDeque();
-        m_pRedoDeque = new TUndoRedoStagePtrDeque();
+        m_pUndoDeque = new TUndoRedoChangePtrDeque();
+        m_pRedoDeque = new TUndoRedoChangePtrDeque();
         m_pCurrent = new TUndoRedoStage();
 		m_pStatisticsOfDeleting = new TStatisticsOfDeleting(m_pOptions->statisticsPath);
     }
@@ -61,8 +61,7 @@ namespace ad
     {
         bool onceMaked = false;
 
-		// Сохраняем сотояние
-        TUndoRedoChange *pOldChange = m_pCurrent->change;
+		// Начинаем запись изменения
         m_pCurrent->change = new TUndoRedoChange();
 
         if(targetType == AD_TARGET_CURRENT)
@@ -96,38 +95,46 @@ namespace ad
 		// Если ничего сделано не было.
         if(!onceMaked)
         {
-            delete m_pCurrent->change;
-            m_pCurrent->change = pOldChange;
+            Discard();
             return false;
         }
 
-        m_pUndoDeque->push_back(m_pCurrent->Clone());
-
 		// Удаляем из списка ошибочные или удаленные
         if(localActionType == AD_LOCAL_ACTION_MISTAKE)
             m_pCurrent->RemoveMistaken(m_pStatus, m_pMistakeStorage);
         else
             m_pCurrent->RemoveDeleted(m_pStatus);
 
-        m_pCurrent->UpdateGroups();
+        m_pCurrent->UpdateGroups(m_pCurrent->change->removedResults, false);
+        m_pCurrent->InvalidateHints(m_pCurrent->change->renamedImages);
         m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
 
-        m_pCurrent->change = NULL;
+        Push();
 
-        if(pOldChange)
-            delete pOldChange;
+        return true;
+    }
 
+	// private Сохраняем записанное изменение в очереди отмены.
+    void TUndoRedoEngine::Push()
+    {
+        m_pCurrent->change->Account();
+        m_pUndoDeque->push_back(m_pCurrent->change);
+        m_pCurrent->change = NULL;
         ClearRedo();
         AdjustUndoDequeSize(m_pOptions->advanced.undoQueueSize);
+    }
 
-        return true;
+	// private Отбрасываем изменение, если ничего сделано не было.
+    void TUndoRedoEngine::Discard()
+    {
+        delete m_pCurrent->change;
+        m_pCurrent->change = NULL;
     }
     
 	// private Переименовывает/перемещает файл с заменой
     bool TUndoRedoEngine::Rename(TImageInfo *pImageInfo, const TString & newFileName)
     {
-		// Сохраняем состояние
-        TUndoRedoChange *pOldChange = m_pCurrent->change;
+		// Начинаем запись изменения
         m_pCurrent->change = new TUndoRedoChange();
 		// Если удается переименовать/переместить файл с заменой
         if(::MoveFileEx(pImageInfo->path.Original().c_str(), newFileName.c_str(), 
@@ -142,28 +149,18 @@ namespace ad
 			// Путь в информации о файле меняем
             pImageInfo->Rename(newFileName);
 
-			// Отмечаем новое состояние в очереди действий
-            m_pUndoDeque->push_back(m_pCurrent->Clone());
-
 			// Обновляем подсказки в текущей группе.
             m_pCurrent->groups.Get(pImageInfo->group)->invalidHint = true;
             m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
 
-            m_pCurrent->change = NULL;
-
-            if(pOldChange)
-                delete pOldChange;
-
-			// Очишаем точки возврата в будушее.
-            ClearRedo();
-            AdjustUndoDequeSize(m_pOptions->advanced.undoQueueSize);
+			// Отмечаем изменение в очереди действий и очишаем точки возврата в будушее.
+            Push();
 
             return true;
         }
         else
         {
-            delete m_pCurrent->change;
-            m_pCurrent->change = pOldChange;
+            Discard();
             return false;
         }    
     }
@@ -314,19 +311,18 @@ namespace ad
         if(m_pUndoDeque->empty())
             return false;
 
-		// Возврашаем прошлое состояние в хранилишах.
-        m_pRedoDeque->push_back(m_pCurrent);
-        m_pCurrent = m_pUndoDeque->back();
+		// Переносим последнее изменение в очередь повтора и возвращаем удаленные им результаты.
+        TUndoRedoChangePtr pChange = m_pUndoDeque->back();
         m_pUndoDeque->pop_back();
+        m_pRedoDeque->push_back(pChange);
 
-		//?? FIX Может надо Apply вызывать? иначе после undo группы пустые
-		m_pCurrent->UpdateGroups();
+        m_pCurrent->Restore(*pChange);
 
         m_pStatus->SetProgress(0, 0);
-        size_t current = 0, total = m_pCurrent->change->renamedImages.size() + m_pCurrent->change->deletedImages.size();
+        size_t current = 0, total = pChange->renamedImages.size() + pChange->deletedImages.size();
 
 		// Переименовываем обратно переименованные файлы.
-        TRenameList & renamedImages = m_pCurrent->change->renamedImages;
+        TRenameList & renamedImages = pChange->renamedImages;
         for(TRenameList::iterator it = renamedImages.begin(); it != renamedImages.end(); ++it, ++current)
         {
             if(::MoveFileEx(it->second.c_str(), it->first.c_str(), 
@@ -342,7 +338,7 @@ namespace ad
         }
 
 		// Восстанавливаем удаленные файлы.
-        TImageInfoPtrList & deletedImages = m_pCurrent->change->deletedImages;
+        TImageInfoPtrList & deletedImages = pChange->deletedImages;
         for(TImageInfoPtrList::iterator it = deletedImages.begin(); it != deletedImages.end(); ++it, ++current)
         {
             m_pRecycleBin->Restore(*it);
@@ -350,7 +346,7 @@ namespace ad
         }
 
 		// Добавляем в список результатов удаленные элементы.
-        TResultPtrList & removedResults = m_pCurrent->change->removedResults;
+        TResultPtrList & removedResults = pChange->removedResults;
         for(TResultPtrList::iterator it = removedResults.begin(); it != removedResults.end(); ++it)
         {
             TResult *pResult = *it;
@@ -360,7 +356,7 @@ namespace ad
                 m_pStatus->AddDuplImagePair(1);
         }
 
-        TResultPtrList & mistakenResults = m_pCurrent->change->mistakenResults;
+        TResultPtrList & mistakenResults = pChange->mistakenResults;
         for(TResultPtrList::iterator it = mistakenResults.begin(); it != mistakenResults.end(); ++it)
         {
             TResult *pResult = *it;
@@ -370,6 +366,9 @@ namespace ad
                 m_pMistakeStorage->Erase(pResult->first, pResult->second);
         }
 
+        m_pCurrent->InvalidateHints(renamedImages);
+        m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
+
         m_pStatus->Reset();
 
         return true;
@@ -380,39 +379,34 @@ namespace ad
         if(m_pRedoDeque->empty())
             return false;
 
+        TUndoRedoChangePtr pChange = m_pRedoDeque->back();
+
         m_pStatus->SetProgress(0, 0);
-        size_t current = 0, total = m_pCurrent->change->renamedImages.size() + m_pCurrent->change->deletedImages.size();
+        size_t current = 0, total = pChange->renamedImages.size() + pChange->deletedImages.size();
 
-        TImageInfoPtrList & deletedImages = m_pCurrent->change->deletedImages;
+        TImageInfoPtrList & deletedImages = pChange->deletedImages;
         for(TImageInfoPtrList::iterator it = deletedImages.begin(); it != deletedImages.end(); ++it, ++current)
         {
             m_pRecycleBin->Delete(*it);
             m_pStatus->SetProgress(current, total);
         }
 
-        TRenameList & renamedImages = m_pCurrent->change->renamedImages;
+        TRenameList & renamedImages = pChange->renamedImages;
         for(TRenameList::iterator it = renamedImages.begin(); it != renamedImages.end(); ++it, ++current)
         {
             if(::MoveFileEx(it->first.c_str(), it->second.c_str(), 
 				MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED) != TRUE)
+			{
+				m_pStatus->Reset();
                 return false;
+			}
             m_pMistakeStorage->Rename(it->info, it->second);
             it->info->Rename(it->second);
             m_pStatus->RenameImage(1);
             m_pStatus->SetProgress(current, total);
         }
 
-        TResultPtrList & removedResults = m_pCurrent->change->removedResults;
-        for(TResultPtrList::iterator it = removedResults.begin(); it != removedResults.end(); ++it)
-        {
-            TResult *pResult = *it;
-            if(pResult->type == AD_RESULT_DEFECT_IMAGE)
-                m_pStatus->AddDefectImage(-1);
-            else if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR)
-                m_pStatus->AddDuplImagePair(-1);
-        }
-
-        TResultPtrList & mistakenResults = m_pCurrent->change->mistakenResults;
+        TResultPtrList & mistakenResults = pChange->mistakenResults;
         for(TResultPtrList::iterator it = mistakenResults.begin(); it != mistakenResults.end(); ++it)
         {
             TResult *pResult = *it;
@@ -422,11 +416,25 @@ namespace ad
                 m_pMistakeStorage->Add(pResult->first, pResult->second);
         }
 
-        m_pStatus->Reset();
-
-        m_pUndoDeque->push_back(m_pCurrent);
-        m_pCurrent = m_pRedoDeque->back();
+		// Повторно удаляем из списка те же результаты, записывая их позиции заново.
         m_pRedoDeque->pop_back();
+        m_pCurrent->change = pChange;
+        if(!pChange->removedResults.empty())
+        {
+            if(!mistakenResults.empty())
+                m_pCurrent->RemoveMistaken(m_pStatus, m_pMistakeStorage);
+            else
+                m_pCurrent->RemoveDeleted(m_pStatus);
+            m_pCurrent->UpdateGroups(pChange->removedResults, false);
+        }
+        m_pCurrent->change = NULL;
+        pChange->Account();
+        m_pUndoDeque->push_back(pChange);
+
+        m_pCurrent->InvalidateHints(renamedImages);
+        m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
+
+        m_pStatus->Reset();
 
         return true;
     }
@@ -437,24 +445,26 @@ namespace ad
         AdjustUndoDequeSize(0);
     }
 
+	// Результаты изменений в очереди повтора уже возвращены в текущий список и принадлежат ему.
     void TUndoRedoEngine::ClearRedo()
     {
-        for(TUndoRedoStagePtrDeque::iterator it = m_pRedoDeque->begin(); it != m_pRedoDeque->end(); ++it)
+        for(TUndoRedoChangePtrDeque::iterator it = m_pRedoDeque->begin(); it != m_pRedoDeque->end(); ++it)
             delete *it;
         m_pRedoDeque->clear();
     }
 
+	// Результаты изменений в очереди отмены принадлежат изменению и освобождаются вместе с ним.
     void TUndoRedoEngine::AdjustUndoDequeSize(size_t size)
     {
         size_t current = 0, total = 0;
         for(size_t i = size; i < m_pUndoDeque->size(); i++)
-            total += m_pUndoDeque->at(m_pUndoDeque->size() - 1 - i)->change->deletedImages.size();
+            total += m_pUndoDeque->at(m_pUndoDeque->size() - 1 - i)->deletedImages.size();
         m_pStatus->SetProgress(0, 0);
         bool unlink = false;
         while(m_pUndoDeque->size() > size)
         {
-            TUndoRedoStagePtr pStage = m_pUndoDeque->front();
-            TResultPtrList &removedResults = pStage->change->removedResults;
+            TUndoRedoChangePtr pChange = m_pUndoDeque->front();
+            TResultPtrList &removedResults = pChange->removedResults;
             for(TResultPtrList::iterator it = removedResults.begin(); it != removedResults.end(); ++it)
             {
                 unlink = true;
@@ -465,13 +475,15 @@ namespace ad
 
 				m_pStatisticsOfDeleting->Write(pResult);
             }
-            TImageInfoPtrList& deletedImages = pStage->change->deletedImages;
+            TImageInfoPtrList& deletedImages = pChange->deletedImages;
             for(TImageInfoPtrList::iterator it = deletedImages.begin(); it != deletedImages.end(); ++it)
             {
                 m_pRecycleBin->Free(*it);
                 m_pStatus->SetProgress(current++, total);
             }
-            delete pStage;
+            for(TResultPtrList::iterator it = removedResults.begin(); it != removedResults.end(); ++it)
+                delete *it;
+            delete pChange;
             m_pUndoDeque->pop_front();
         }
         if(unlink)
@@ -600,15 +612,14 @@ namespace ad
 		if(!IsDirectoryExists(directory.c_str()))
             return false;
 
-		// Сохраняем сотояние
-        TUndoRedoChange *pOldChange = m_pCurrent->change;
-        m_pCurrent->change = new TUndoRedoChange();
-
         TResult *pResult = m_pCurrent->results[m_pCurrent->currentIndex];
 		TImageGroupPtr pImageGroup = m_pCurrent->groups.Get(pResult->group, false);
 		if(pImageGroup == NULL)
 			return false;
 
+		// Начинаем запись изменения
+        m_pCurrent->change = new TUndoRedoChange();
+
 		// Проходимся по списку изображений в группе.
 		for (size_t i = 0; i < pImageGroup->images.size(); i++)
 		{
@@ -634,23 +645,14 @@ namespace ad
 		// Если ничего сделано не было.
         if(!isMoving)
         {
-            delete m_pCurrent->change;
-            m_pCurrent->change = pOldChange;
+            Discard();
             return false;
         }
 
-        m_pUndoDeque->push_back(m_pCurrent->Clone());
-
-        m_pCurrent->UpdateGroups();
+        pImageGroup->invalidHint = true;
         m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
 
-        m_pCurrent->change = NULL;
-
-        if(pOldChange)
-            delete pOldChange;
-
-        ClearRedo();
-        AdjustUndoDequeSize(m_pOptions->advanced.undoQueueSize);
+        Push();
 
         return true;
     }
@@ -664,15 +666,14 @@ namespace ad
         if(fileName == TString())
             return false;
 
-		// Сохраняем сотояние
-        TUndoRedoChange *pOldChange = m_pCurrent->change;
-        m_pCurrent->change = new TUndoRedoChange();
-
         TResult *pResult = m_pCurrent->results[m_pCurrent->currentIndex];
 		TImageGroupPtr pImageGroup = m_pCurrent->groups.Get(pResult->group, false);
 		if(pImageGroup == NULL)
 			return false;
 
+		// Начинаем запись изменения
+        m_pCurrent->change = new TUndoRedoChange();
+
 		for (size_t i = 0; i < pImageGroup->images.size(); i++)
 		{
 			TPath* path = &pImageGroup->images[i]->path;
@@ -695,23 +696,14 @@ namespace ad
 		// Если ничего сделано не было.
         if(!isRenaming)
         {
-            delete m_pCurrent->change;
-            m_pCurrent->change = pOldChange;
+            Discard();
             return false;
         }
 
-        m_pUndoDeque->push_back(m_pCurrent->Clone());
-
-        m_pCurrent->UpdateGroups();
+        pImageGroup->invalidHint = true;
         m_pCurrent->UpdateHints(m_pOptions, false, m_pStatus);
 
-        m_pCurrent->change = NULL;
-
-        if(pOldChange)
-            delete pOldChange;
-
-        ClearRedo();
-        AdjustUndoDequeSize(m_pOptions->advanced.undoQueueSize);
+        Push();
 
         return true;
     }
@@ -43,7 +43,8 @@ namespace ad
 	class TStatisticsOfDeleting;
 
     typedef TUndoRedoStage* TUndoRedoStagePtr;
-    typedef std::deque<TUndoRedoStagePtr> TUndoRedoStagePtrDeque;
+    typedef TUndoRedoChange* TUndoRedoChangePtr;
+    typedef std::deque<TUndoRedoChangePtr> TUndoRedoChangePtrDeque;
     //-------------------------------------------------------------------------
     class TUndoRedoEngine
     {
@@ -71,6 +72,8 @@ namespace ad
     private:
         void ClearRedo();
         void AdjustUndoDequeSize(size_t size);
+        void Push();
+        void Discard();
 
         bool ApplyTo(adLocalActionType localActionType, TResult *pResult);
 
@@ -89,8 +92,9 @@ namespace ad
         TImageInfoStorage *m_pImageInfoStorage;
 		TStatisticsOfDeleting *m_pStatisticsOfDeleting;
 
-        TUndoRedoStagePtrDeque *m_pUndoDeque;
-        TUndoRedoStagePtrDeque *m_pRedoDeque;
+		// Очереди изменений: каждое хранит только результаты и файлы, затронутые действием.
+        TUndoRedoChangePtrDeque *m_pUndoDeque;
+        TUndoRedoChangePtrDeque *m_pRedoDeque;
 		// Текущее состояние результатов вектор структур TResult
         TUndoRedoStagePtr m_pCurrent;
     };
@@ -28,13 +28,47 @@
 #include "adOptions.h"
 #include "adStatus.h"
 #include "adMistakeStorage.h"
+#include "adFileChecker.h"
 #include "adUndoRedoTypes.h"
+#include "adMemory.h"
 
 namespace ad
 {
+    TUndoRedoChange::TUndoRedoChange()
+        :currentIndex(AD_UNDEFINED),
+        current(NULL),
+        promoted(NULL),
+        promotedSelected(false),
+        generation(0),
+        memory(0)
+    {
+    }
+
+    TUndoRedoChange::~TUndoRedoChange()
+    {
+        TMemoryCounters::Remove(AD_MEMORY_UNDO, memory);
+    }
+
+    void TUndoRedoChange::Account()
+    {
+        size_t size = sizeof(TUndoRedoChange) + 
+            TMemoryCounters::ListNode(sizeof(TResultPtr))*(removedResults.size() + mistakenResults.size()) + 
+            sizeof(size_t)*removedIndices.capacity() + 
+            TMemoryCounters::ListNode(sizeof(TImageInfoPtr))*deletedImages.size();
+        for(TRenameList::const_iterator it = renamedImages.begin(); it != renamedImages.end(); ++it)
+            size += TMemoryCounters::ListNode(sizeof(TRename)) + sizeof(TChar)*(it->first.capacity() + it->second.capacity());
+        TMemoryCounters::Remove(AD_MEMORY_UNDO, memory);
+        TMemoryCounters::Add(AD_MEMORY_UNDO, size);
+        memory = size;
+    }
+    //-------------------------------------------------------------------------
     TUndoRedoStage::TUndoRedoStage()
         :currentIndex(AD_UNDEFINED),
-        change(NULL)
+        change(NULL),
+        generation(0),
+        m_sortType(AD_SORT_BY_TYPE),
+        m_increasing(true),
+        m_sorted(false)
     {
     }
 
@@ -49,6 +83,8 @@ namespace ad
             delete *it;
         results.clear();
         currentIndex = AD_UNDEFINED;
+        generation++;
+        m_sorted = false;
         if(change)
         {
             delete change;
@@ -56,16 +92,68 @@ namespace ad
         }
     }
 
-    TUndoRedoStage* TUndoRedoStage::Clone()
+    // Возвращает в список результаты, удаленные действием, и восстанавливает текущий результат.
+    void TUndoRedoStage::Restore(const TUndoRedoChange & delta)
     {
-       TUndoRedoStage *pUndoRedoStage = new TUndoRedoStage();
-       pUndoRedoStage->results.resize(results.size());
-       for(size_t i = 0; i < results.size(); ++i)
-            pUndoRedoStage->results[i] = new TResult(*results[i]);
-       pUndoRedoStage->groups.Assign(groups);
-       pUndoRedoStage->currentIndex = currentIndex;
-       pUndoRedoStage->change = change;
-       return pUndoRedoStage;
+        if(delta.removedResults.empty())
+            return;
+
+        if(currentIndex != AD_UNDEFINED)
+            results[currentIndex]->current = false;
+        if(delta.promoted)
+        {
+            delta.promoted->current = false;
+            delta.promoted->selected = delta.promotedSelected;
+        }
+
+        if(delta.generation == generation)
+        {
+            // Порядок не менялся: вставляем результаты на прежние позиции за один проход.
+            TResultPtrVector buffer;
+            buffer.reserve(results.size() + delta.removedResults.size());
+            size_t i = 0, j = 0;
+            for(TResultPtrList::const_iterator it = delta.removedResults.begin(); it != delta.removedResults.end(); ++it, ++j)
+            {
+                while(buffer.size() < delta.removedIndices[j] && i < results.size())
+                    buffer.push_back(results[i++]);
+                buffer.push_back(*it);
+            }
+            buffer.insert(buffer.end(), results.begin() + i, results.end());
+            results.swap(buffer);
+            currentIndex = delta.currentIndex;
+        }
+        else
+        {
+            // Список был пересортирован после действия: вставляем результаты согласно текущей сортировке.
+            for(TResultPtrList::const_iterator it = delta.removedResults.begin(); it != delta.removedResults.end(); ++it)
+            {
+                TResultPtr pResult = *it;
+                if(m_sorted)
+                {
+                    if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR && 
+                        !TResult::ImageInfoLesser(pResult->first, pResult->second, m_sortType, m_increasing))
+                    {
+                        pResult->Swap();
+                    }
+                    results.insert(std::upper_bound(results.begin(), results.end(), pResult, 
+                        TResultPtrLesser(m_sortType, m_increasing)), pResult);
+                }
+                else
+                    results.push_back(pResult);
+            }
+            currentIndex = AD_UNDEFINED;
+            if(delta.current)
+            {
+                TResultPtrVector::iterator it = std::find(results.begin(), results.end(), delta.current);
+                if(it != results.end())
+                    currentIndex = it - results.begin();
+            }
+        }
+
+        if(currentIndex != AD_UNDEFINED)
+            results[currentIndex]->current = true;
+
+        UpdateGroups(delta.removedResults, true);
     }
 
     void TUndoRedoStage::Sort(TSortType sortType, bool increasing)
@@ -81,6 +169,10 @@ namespace ad
         }
         std::sort(results.begin(), results.end(), TResultPtrLesser(sortType, increasing));
         UpdateCurrentIndex();
+        m_sortType = sortType;
+        m_increasing = increasing;
+        m_sorted = true;
+        generation++;
     }
 
     adError TUndoRedoStage::SetCurrent(adSize newCurrentIndex)
@@ -193,25 +285,39 @@ namespace ad
         class TValidator
         {
             TMistakeStorage *m_pMistakeStorage;
+            const TFileChecker *m_pFileChecker;
         public:
-            TValidator(TMistakeStorage *pMistakeStorage) :m_pMistakeStorage(pMistakeStorage) {}
+            TValidator(TMistakeStorage *pMistakeStorage, const TFileChecker *pFileChecker) 
+                :m_pMistakeStorage(pMistakeStorage), m_pFileChecker(pFileChecker) {}
             bool operator()(TImageInfo* a) const //DEFECT
             {
                 return 
                     !a->removed && 
-                    IsFileExists(a->path.Original().c_str()) &&
+                    m_pFileChecker->Exists(a) &&
                     !m_pMistakeStorage->IsHas(a);
             }
             bool operator()(TImageInfo* a, TImageInfo* b) const //DUPL_IMAGE_PAIR
             {
                 return 
                     (!a->removed) && (!b->removed) &&
-                    IsFileExists(a->path.Original().c_str()) && IsFileExists(b->path.Original().c_str()) &&
+                    m_pFileChecker->Exists(a) && m_pFileChecker->Exists(b) &&
                     !m_pMistakeStorage->IsHas(a, b);
             }
         };
 
-        RemoveInvalid(TValidator(pMistakeStorage), pStatus, true);
+		// Существование файлов проверяем заранее, пакетно по каталогам.
+        TFileChecker fileChecker(pStatus);
+        for(size_t i = 0; i < results.size(); i++)
+        {
+            TResultPtr pResult = results[i];
+            if(!pResult->first->removed)
+                fileChecker.Add(pResult->first);
+            if(pResult->type == AD_RESULT_DUPL_IMAGE_PAIR && !pResult->second->removed)
+                fileChecker.Add(pResult->second);
+        }
+        fileChecker.Check();
+
+        RemoveInvalid(TValidator(pMistakeStorage, &fileChecker), pStatus, true);
     }
 
     void TUndoRedoStage::RemoveDeleted(TStatus *pStatus)
@@ -276,11 +382,37 @@ namespace ad
 		groups.Update(results);
     }
 
+    void TUndoRedoStage::UpdateGroups(const TResultPtrList & changed, bool insert)
+    {
+		groups.Update(changed, insert);
+    }
+
+	// Отмечаем для пересчета подсказок группы переименованных изображений.
+    void TUndoRedoStage::InvalidateHints(const TRenameList & renamed)
+    {
+        for(TRenameList::const_iterator it = renamed.begin(); it != renamed.end(); ++it)
+        {
+            TImageGroupPtr pImageGroup = groups.Get(it->info->group, false);
+            if(pImageGroup)
+                pImageGroup->invalidHint = true;
+        }
+    }
+
     void TUndoRedoStage::UpdateHints(TOptions *pOptions, bool force, TStatus *pStatus)
     {
 		groups.UpdateHints(pOptions, force, pStatus);
     }
 
+	// Запоминаем состояние результата, который становится текущим вместо удаленного.
+    void TUndoRedoStage::Promote(TResultPtr pResult)
+    {
+        if(change)
+        {
+            change->promoted = pResult;
+            change->promotedSelected = pResult->selected;
+        }
+    }
+
     void TUndoRedoStage::UpdateCurrentIndex()
     {
         currentIndex = AD_UNDEFINED;
@@ -300,6 +432,15 @@ namespace ad
         pStatus->SetProgress(0, 0);
         if(!pStatus->Stopped())
         {
+            if(change)
+            {
+                change->removedResults.clear();
+                change->removedIndices.clear();
+                change->currentIndex = currentIndex;
+                change->current = currentIndex != AD_UNDEFINED ? results[currentIndex] : NULL;
+                change->promoted = NULL;
+                change->generation = generation;
+            }
             bool searchValidCurrent = false;
             ptrdiff_t removedDefects = 0;
             ptrdiff_t removedDuplPair = 0;
@@ -321,6 +462,7 @@ namespace ad
                         if(searchValidCurrent)
                         {
                             currentIndex = validList.size() - 1;
+                            Promote(validList.back());
                             validList.back()->current = true;
                             validList.back()->selected = true;
                             searchValidCurrent = false;
@@ -329,7 +471,10 @@ namespace ad
                     else
                     {
                         if(change)
+                        {
                             change->removedResults.push_back(pResult);
+                            change->removedIndices.push_back(i);
+                        }
                         groups.Get(pResult->group)->invalidHint = true;
                         removedDefects++;
                     }
@@ -341,6 +486,7 @@ namespace ad
                         if(searchValidCurrent)
                         {
                             currentIndex = validList.size() - 1;
+                            Promote(validList.back());
                             validList.back()->current = true;
                             validList.back()->selected = true;
                             searchValidCurrent = false;
@@ -349,7 +495,10 @@ namespace ad
                     else
                     {
                         if(change)
+                        {
                             change->removedResults.push_back(pResult);
+                            change->removedIndices.push_back(i);
+                        }
                         groups.Get(pResult->group)->invalidHint = true;
                         removedDuplPair++;
                     }
@@ -364,6 +513,7 @@ namespace ad
                     if(validList.size())
                     {
                         currentIndex = validList.size() - 1;
+                        Promote(validList.back());
                         validList.back()->current = true;
                         validList.back()->selected = true;
                     }
@@ -375,6 +525,8 @@ namespace ad
                 pStatus->AddDuplImagePair(-removedDuplPair);
 
                 results.assign(validList.begin(), validList.end());
+                if(!change && (removedDefects || removedDuplPair))
+                    generation++;
             }
         }
         pStatus->Reset();
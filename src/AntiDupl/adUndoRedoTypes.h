@@ -51,12 +51,32 @@ namespace ad
     };
     typedef std::list<TRename> TRenameList;
     //-------------------------------------------------------------------------
+    // Изменение, внесенное одним действием. Хранит только затронутые результаты, а не копию всего списка.
     struct TUndoRedoChange
     {
         TResultPtrList removedResults;
+        // Позиции удаленных результатов в списке до выполнения действия (по возрастанию).
+        std::vector<size_t> removedIndices;
         TResultPtrList mistakenResults;
         TImageInfoPtrList deletedImages;
         TRenameList renamedImages;
+
+        // Текущий результат до выполнения действия.
+        size_t currentIndex;
+        TResultPtr current;
+        // Результат, ставший текущим вместо удаленного, и его прежнее выделение.
+        TResultPtr promoted;
+        bool promotedSelected;
+        // Поколение порядка результатов, в котором записаны позиции.
+        size_t generation;
+        // Память записи, учтенная в AD_MEMORY_UNDO. Удаленные результаты учитываются в AD_MEMORY_RESULT.
+        size_t memory;
+
+        TUndoRedoChange();
+        ~TUndoRedoChange();
+
+        // Учитывает память записи, вызывается по окончании действия.
+        void Account();
     };
     //-------------------------------------------------------------------------
     struct TUndoRedoStage
@@ -65,12 +85,14 @@ namespace ad
         TImageGroupStorage groups;
         size_t currentIndex;
         TUndoRedoChange *change;
+        // Увеличивается при каждом изменении порядка результатов вне очереди действий.
+        size_t generation;
 
         TUndoRedoStage();
         ~TUndoRedoStage();
 
         void Clear();
-        TUndoRedoStage* Clone();
+        void Restore(const TUndoRedoChange & delta);
 
         void Sort(TSortType sortType, bool increasing);
 
@@ -90,10 +112,17 @@ namespace ad
         
         void SetGroups(TStatus *pStatus);
         void UpdateGroups();
+        void UpdateGroups(const TResultPtrList & changed, bool insert);
+        void InvalidateHints(const TRenameList & renamed);
         void UpdateHints(TOptions *pOptions, bool force, TStatus *pStatus);
 
     private:
         void UpdateCurrentIndex();
+        void Promote(TResultPtr pResult);
+
+        TSortType m_sortType;
+        bool m_increasing;
+        bool m_sorted;
 
         template <class TValidator> void RemoveInvalid(const TValidator &validator, TStatus *pStatus, bool canCancel = false);
     };
@@ -0,0 +1,312 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "adFileUtils.h"
+#include "adPath.h"
+#include "adStatus.h"
+#include "adWatcher.h"
+
+namespace ad
+{
+	// Время тишины после последнего события, после которого файл считается записанным.
+	const DWORD WATCH_SETTLE_INTERVAL = 200;
+	const DWORD WATCH_POLL_INTERVAL = 1000;
+	const size_t WATCH_BUFFER_SIZE = 0x10000;
+
+	static inline TString Key(const TString & path)
+	{
+		TString key(path);
+		key.ToUpper();
+		return key;
+	}
+
+	TWatcher::TWatcher(TStatus *pStatus)
+		: m_pStatus(pStatus)
+	{
+	}
+
+	TWatcher::~TWatcher()
+	{
+		for(size_t i = 0; i < m_directories.size(); ++i)
+		{
+			Close(m_directories[i]);
+			if(m_directories[i]->overlapped.hEvent != NULL)
+				::CloseHandle(m_directories[i]->overlapped.hEvent);
+			delete m_directories[i];
+		}
+	}
+
+	void TWatcher::Start(const TPathContainer & searchPaths)
+	{
+		for(size_t i = 0; i < searchPaths.Size(); ++i)
+		{
+			TString path = CreatePath(searchPaths[i].Original());
+			if(!IsDirectoryExists(path.c_str()))
+				continue;
+
+			TDirectory *pDirectory = new TDirectory();
+			pDirectory->path = path;
+			pDirectory->enableSubFolder = searchPaths[i].EnableSubFolder();
+			pDirectory->polled = 0;
+			pDirectory->listening = false;
+			memset(&pDirectory->overlapped, 0, sizeof(OVERLAPPED));
+			pDirectory->overlapped.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+			pDirectory->hDirectory = ::CreateFile(path.c_str(), FILE_LIST_DIRECTORY, 
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 
+				FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+			m_directories.push_back(pDirectory);
+
+			if(pDirectory->hDirectory == INVALID_HANDLE_VALUE || !Listen(pDirectory))
+			{
+				Close(pDirectory);
+				Poll(pDirectory, true);
+			}
+		}
+	}
+
+	void TWatcher::Pop(TStrings & paths, DWORD timeout)
+	{
+		DWORD start = ::GetTickCount();
+		for(;;)
+		{
+			std::vector<HANDLE> handles;
+			bool polling = false;
+			for(size_t i = 0; i < m_directories.size(); ++i)
+			{
+				if(m_directories[i]->hDirectory == INVALID_HANDLE_VALUE)
+					polling = true;
+				else if(handles.size() < MAXIMUM_WAIT_OBJECTS)
+					handles.push_back(m_directories[i]->overlapped.hEvent);
+			}
+
+			DWORD elapsed = ::GetTickCount() - start;
+			DWORD wait = timeout > elapsed ? timeout - elapsed : 0;
+			if(!m_events.empty() || polling || handles.size() < m_directories.size())
+				wait = std::min(wait, WATCH_SETTLE_INTERVAL);
+			if(handles.empty())
+				::Sleep(wait);
+			else
+				::WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, wait);
+
+			DWORD tick = ::GetTickCount();
+			for(size_t i = 0; i < m_directories.size(); ++i)
+			{
+				TDirectory *pDirectory = m_directories[i];
+				if(pDirectory->hDirectory != INVALID_HANDLE_VALUE)
+				{
+					if(pDirectory->listening && HasOverlappedIoCompleted(&pDirectory->overlapped))
+						Read(pDirectory);
+				}
+				else if(tick - pDirectory->polled >= WATCH_POLL_INTERVAL)
+					Poll(pDirectory, false);
+			}
+
+			Release(paths);
+			if(!paths.empty() || m_pStatus->Stopped() || ::GetTickCount() - start >= timeout)
+				return;
+		}
+	}
+
+	bool TWatcher::Listen(TDirectory *pDirectory)
+	{
+		pDirectory->buffer.resize(WATCH_BUFFER_SIZE/sizeof(DWORD));
+		::ResetEvent(pDirectory->overlapped.hEvent);
+		pDirectory->listening = ::ReadDirectoryChangesW(pDirectory->hDirectory, pDirectory->buffer.data(), (DWORD)WATCH_BUFFER_SIZE, 
+			pDirectory->enableSubFolder ? TRUE : FALSE, 
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE, 
+			NULL, &pDirectory->overlapped, NULL) != FALSE;
+		return pDirectory->listening;
+	}
+
+	void TWatcher::Read(TDirectory *pDirectory)
+	{
+		DWORD size = 0;
+		pDirectory->listening = false;
+		if(::GetOverlappedResult(pDirectory->hDirectory, &pDirectory->overlapped, &size, FALSE) == FALSE)
+		{
+			// Наблюдение стало невозможно, переходим на опрос каталога.
+			Close(pDirectory);
+			Poll(pDirectory, true);
+			return;
+		}
+
+		if(size == 0)
+		{
+			// Буфер событий переполнен: отдаем все файлы каталога, уже обработанные отсеет движок.
+			TSnapshot snapshot;
+			Scan(pDirectory->path, pDirectory->enableSubFolder, snapshot);
+			for(TSnapshot::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+				Touch(it->first, false);
+		}
+		else
+		{
+			const TUInt8 *p = (const TUInt8*)pDirectory->buffer.data();
+			for(;;)
+			{
+				const FILE_NOTIFY_INFORMATION *pInfo = (const FILE_NOTIFY_INFORMATION*)p;
+				TString path = CreatePath(pDirectory->path, TString(pInfo->FileName, pInfo->FileNameLength/sizeof(WCHAR)));
+				switch(pInfo->Action)
+				{
+				case FILE_ACTION_ADDED:
+				case FILE_ACTION_RENAMED_NEW_NAME:
+					Touch(path, true);
+					break;
+				case FILE_ACTION_MODIFIED:
+					Touch(path, false);
+					break;
+				case FILE_ACTION_REMOVED:
+				case FILE_ACTION_RENAMED_OLD_NAME:
+					m_events.erase(Key(path));
+					break;
+				}
+				if(pInfo->NextEntryOffset == 0)
+					break;
+				p += pInfo->NextEntryOffset;
+			}
+		}
+
+		if(!Listen(pDirectory))
+		{
+			Close(pDirectory);
+			Poll(pDirectory, true);
+		}
+	}
+
+	void TWatcher::Poll(TDirectory *pDirectory, bool initial)
+	{
+		TSnapshot snapshot;
+		Scan(pDirectory->path, pDirectory->enableSubFolder, snapshot);
+		if(!initial)
+		{
+			for(TSnapshot::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+			{
+				TSnapshot::const_iterator old = pDirectory->snapshot.find(it->first);
+				if(old == pDirectory->snapshot.end() || old->second.size != it->second.size || old->second.time != it->second.time)
+					Touch(it->first, old == pDirectory->snapshot.end());
+			}
+		}
+		pDirectory->snapshot.swap(snapshot);
+		pDirectory->polled = ::GetTickCount();
+	}
+
+	void TWatcher::Scan(const TString & path, bool enableSubFolder, TSnapshot & snapshot) const
+	{
+		WIN32_FIND_DATA findData;
+		TString mask = CreatePath(path, TEXT("*"));
+		HANDLE hFind = ::FindFirstFileEx(mask.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+		if(hFind == INVALID_HANDLE_VALUE)
+			return;
+		do
+		{
+			TString name = findData.cFileName;
+			if(name == TEXT(".") || name == TEXT(".."))
+				continue;
+			TString child = CreatePath(path, name);
+			if((findData.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY) != 0)
+			{
+				if(enableSubFolder)
+					Scan(child, true, snapshot);
+			}
+			else
+			{
+				TFile & file = snapshot[child];
+				file.size = TUInt64(findData.nFileSizeLow) + TUInt64(findData.nFileSizeHigh)*0x100000000;
+				file.time = *(TUInt64*)&findData.ftLastWriteTime;
+			}
+		}
+		while(::FindNextFile(hFind, &findData) != FALSE && !m_pStatus->Stopped());
+		::FindClose(hFind);
+	}
+
+	void TWatcher::Touch(const TString & path, bool added)
+	{
+		TEvent & event = m_events[Key(path)];
+		if(event.path.empty())
+			event.added = false;
+		event.path = path;
+		event.tick = ::GetTickCount();
+		event.added = event.added || added;
+	}
+
+	void TWatcher::Release(TStrings & paths)
+	{
+		DWORD tick = ::GetTickCount();
+		for(TEvents::iterator it = m_events.begin(); it != m_events.end();)
+		{
+			TEvent & event = it->second;
+			if(tick - event.tick < WATCH_SETTLE_INTERVAL)
+			{
+				++it;
+				continue;
+			}
+
+			DWORD attributes = ::GetFileAttributes(event.path.c_str());
+			if(attributes == INVALID_FILE_ATTRIBUTES)
+			{
+				it = m_events.erase(it);
+				continue;
+			}
+
+			if((attributes&FILE_ATTRIBUTE_DIRECTORY) != 0)
+			{
+				// Изменение каталога не интересно, а перемещенный целиком каталог отдаем по файлам.
+				if(event.added)
+				{
+					TSnapshot snapshot;
+					Scan(event.path, true, snapshot);
+					for(TSnapshot::const_iterator file = snapshot.begin(); file != snapshot.end(); ++file)
+						paths.push_back(file->first);
+				}
+				it = m_events.erase(it);
+				continue;
+			}
+
+			// Файл, который еще пишется, обычно открыт без разрешения на совместное чтение.
+			HANDLE hFile = ::CreateFile(event.path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+			if(hFile == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_SHARING_VIOLATION)
+			{
+				event.tick = tick;
+				++it;
+				continue;
+			}
+			if(hFile != INVALID_HANDLE_VALUE)
+			{
+				::CloseHandle(hFile);
+				paths.push_back(event.path);
+			}
+			it = m_events.erase(it);
+		}
+	}
+
+	void TWatcher::Close(TDirectory *pDirectory)
+	{
+		if(pDirectory->hDirectory == INVALID_HANDLE_VALUE)
+			return;
+		DWORD size = 0;
+		if(pDirectory->listening && ::CancelIo(pDirectory->hDirectory) != FALSE)
+			::GetOverlappedResult(pDirectory->hDirectory, &pDirectory->overlapped, &size, TRUE);
+		pDirectory->listening = false;
+		::CloseHandle(pDirectory->hDirectory);
+		pDirectory->hDirectory = INVALID_HANDLE_VALUE;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+* AntiDupl.NET Program (http://ermig1979.github.io/AntiDupl).
+*
+* Copyright (c) 2002-2023 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy 
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+* copies of the Software, and to permit persons to whom the Software is 
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in 
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef __adWatcher_h__
+#define __adWatcher_h__
+
+#include "adConfig.h"
+#include "adStrings.h"
+
+namespace ad
+{
+	class TPathContainer;
+	class TStatus;
+
+	// Наблюдение за путями поиска в режиме ожидания новых файлов. Основной механизм - 
+	// ReadDirectoryChangesW. Если каталог его не поддерживает (например, часть сетевых ресурсов),
+	// он периодически перечисляется и сравнивается с предыдущим снимком. Файл выдается только
+	// после того, как события по нему затихли и его можно открыть на чтение.
+	class TWatcher
+	{
+	public:
+		TWatcher(TStatus *pStatus);
+		~TWatcher();
+
+		void Start(const TPathContainer & searchPaths);
+		void Pop(TStrings & paths, DWORD timeout);
+
+	private:
+		struct TFile
+		{
+			TUInt64 size;
+			TUInt64 time;
+		};
+		typedef std::map<TString, TFile> TSnapshot;
+
+		struct TDirectory
+		{
+			TString path;
+			bool enableSubFolder;
+			HANDLE hDirectory;
+			OVERLAPPED overlapped;
+			bool listening;
+			std::vector<DWORD> buffer;
+			TSnapshot snapshot; // Только для каталогов, которые опрашиваются.
+			DWORD polled;
+		};
+		typedef std::vector<TDirectory*> TDirectories;
+
+		struct TEvent
+		{
+			TString path;
+			DWORD tick;
+			bool added;
+		};
+		typedef std::map<TString, TEvent> TEvents;
+
+		bool Listen(TDirectory *pDirectory);
+		void Read(TDirectory *pDirectory);
+		void Poll(TDirectory *pDirectory, bool initial);
+		void Scan(const TString & path, bool enableSubFolder, TSnapshot & snapshot) const;
+		void Touch(const TString & path, bool added);
+		void Release(TStrings & paths);
+		void Close(TDirectory *pDirectory);
+
+		TStatus *m_pStatus;
+		TDirectories m_directories;
+		TEvents m_events;
+	};
+}
+
+#endif//__adWatcher_h__
@@ -57,7 +57,6 @@ namespace ad
 				TView * pView = new TView(features.width, features.height, TView::Bgra32);
 				if (pView)
 				{
-					pView->Recreate(features.width, features.height, TView::Bgra32);
 					if (WebPDecodeBGRAInto(data, data_size, pView->data, pView->DataSize(), (int)pView->stride))
 					{
 						pWebp = new TWebp();